@@ -0,0 +1,103 @@
+// Scaling benchmark for the job system, run with 1 to N threads
+#include "JobSystem.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std::chrono;
+
+static constexpr int Repeats = 10;
+
+// Stand-in for a transform update, a few dozen flops per element
+static void TransformRange(std::vector<float> &values, std::size_t begin,
+                           std::size_t end)
+{
+    for (std::size_t i = begin; i < end; i++)
+    {
+        float v = values[i];
+        for (int k = 0; k < 16; k++)
+            v = std::sqrt(v * v + 1.0f) * 0.5f;
+        values[i] = v;
+    }
+}
+
+// Runs the workload and returns the best time in milliseconds
+template <typename Func>
+static double Measure(Func &&func)
+{
+    double best = 1e30;
+    for (int r = 0; r < Repeats; r++)
+    {
+        auto start = steady_clock::now();
+        func();
+        double ms =
+            duration<double, std::milli>(steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t maxThreads =
+        std::max(1u, std::thread::hardware_concurrency());
+    auto values = std::vector<float>(std::size_t(1) << 22, 1.0f);
+
+    double baseParallelFor = 0.0, baseSmallJobs = 0.0;
+
+    std::cout << "threads  parallel-for ms  speedup  small-jobs ms  speedup"
+              << std::endl;
+    for (std::size_t threads = 1; threads <= maxThreads; threads++)
+    {
+        auto jobs = JobSystem(threads - 1);
+
+        // One big loop, split adaptively
+        double parallelFor = Measure([&] {
+            jobs.ParallelFor(values.size(),
+                             [&](std::size_t begin, std::size_t end) {
+                                 TransformRange(values, begin, end);
+                             });
+        });
+
+        // Many independent fixed-size jobs, stresses the deques
+        constexpr std::size_t jobSize  = 1024;
+        std::size_t           jobCount = values.size() / jobSize;
+        auto                  batch    = std::vector<Job>(jobCount);
+        for (std::size_t i = 0; i < jobCount; i++)
+        {
+            batch[i].function = [](JobSystem &, const Job &job) {
+                TransformRange(*static_cast<std::vector<float> *>(job.data),
+                               job.begin, job.end);
+            };
+            batch[i].data  = &values;
+            batch[i].begin = i * jobSize;
+            batch[i].end   = (i + 1) * jobSize;
+        }
+        double smallJobs = Measure([&] {
+            auto counter = JobCounter();
+            for (std::size_t i = 0; i < jobCount;
+                 i += JobSystem::MaxQueuedJobs)
+                jobs.Run(batch.data() + i,
+                         std::min(JobSystem::MaxQueuedJobs, jobCount - i),
+                         counter);
+            jobs.Wait(counter);
+        });
+
+        if (threads == 1)
+        {
+            baseParallelFor = parallelFor;
+            baseSmallJobs   = smallJobs;
+        }
+
+        std::cout << std::fixed << std::setprecision(2) << std::setw(7)
+                  << threads << std::setw(17) << parallelFor << std::setw(9)
+                  << baseParallelFor / parallelFor << std::setw(15)
+                  << smallJobs << std::setw(9) << baseSmallJobs / smallJobs
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+// Loading a synthetic tree of 10,000 shader manifests, with the manifest
+// loader against the boost::property_tree one it replaced
+#include "JobSystem.hpp"
+#include "ManifestIndex.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderSource.hpp"
+#include "SourceStore.hpp"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+static constexpr int         Repeats           = 3;
+static constexpr std::size_t DirectoryCount    = 100;
+static constexpr std::size_t ManifestsPerDir   = 100; // 10,000 in all
+static constexpr std::size_t SharedIncludes    = 8;
+static constexpr std::size_t SharedFragments   = 16;
+static constexpr std::size_t BodyLines         = 40; // Per vertex shader
+
+static void WriteFile(const fs::path &path, const std::string &contents)
+{
+    auto file = std::ofstream(path, std::ios::binary);
+    file << contents;
+}
+
+// Every manifest has a vertex shader of its own and one of a few shared
+// fragment shaders, all of them including a couple of shared files
+static void GenerateTree(const fs::path &root)
+{
+    fs::remove_all(root);
+    fs::create_directories(root / "include");
+    for (std::size_t i = 0; i < SharedIncludes; i++)
+    {
+        auto text = std::string("// Shared include\n");
+        for (std::size_t l = 0; l < BodyLines; l++)
+            text += "uniform vec4 u_Shared" + std::to_string(i) + "_" +
+                    std::to_string(l) + ";\n";
+        WriteFile(root / "include" / ("shared" + std::to_string(i) + ".glsl"),
+                  text);
+    }
+    for (std::size_t i = 0; i < SharedFragments; i++)
+        WriteFile(root / ("fragment" + std::to_string(i) + ".glsl"),
+                  "#version 330 core\n#include \"include/shared" +
+                      std::to_string(i % SharedIncludes) +
+                      ".glsl\"\nout vec4 color;\n"
+                      "void main() { color = vec4(1.0); }\n");
+
+    for (std::size_t d = 0; d < DirectoryCount; d++)
+    {
+        auto directory = root / ("dir" + std::to_string(d));
+        fs::create_directories(directory);
+        for (std::size_t m = 0; m < ManifestsPerDir; m++)
+        {
+            auto name   = "program" + std::to_string(d * ManifestsPerDir + m);
+            auto vertex = std::string("#version 330 core\n");
+            vertex += "#include \"../include/shared" +
+                      std::to_string(m % SharedIncludes) + ".glsl\"\n";
+            vertex += "#include \"../include/shared" +
+                      std::to_string((m + 1) % SharedIncludes) + ".glsl\"\n";
+            vertex += "layout(location = 0) in vec4 position;\n";
+            vertex += "void main()\n{\n    vec4 p = position;\n";
+            for (std::size_t l = 0; l < BodyLines; l++)
+                vertex += "    p = p * 0.5 + vec4(" + std::to_string(l) +
+                          ".0);\n";
+            vertex += "    gl_Position = p;\n}\n";
+            WriteFile(directory / (name + "_vert.glsl"), vertex);
+
+            WriteFile(directory / (name + ".json"),
+                      "{\n    \"type\": \"shader\",\n    \"name\": \"" +
+                          name +
+                          "\",\n    \"sources\": [\n        {\n"
+                          "            \"path\": \"./" +
+                          name +
+                          "_vert.glsl\",\n"
+                          "            \"type\": \"vertex\"\n        },\n"
+                          "        {\n            \"path\": \"../fragment" +
+                          std::to_string(m % SharedFragments) +
+                          ".glsl\",\n"
+                          "            \"type\": \"fragment\"\n        }\n"
+                          "    ]\n}\n");
+        }
+    }
+}
+
+// The include expansion the loader used before, line by line and without
+// remembering any file
+static bool ReadExpanded(const fs::path &path, std::string &contents,
+                         int depth)
+{
+    auto file = std::ifstream(path);
+    if (!file || depth > 16)
+        return false;
+    contents.clear();
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto start = line.find_first_not_of(" \t");
+        if (start != std::string::npos &&
+            line.compare(start, 8, "#include") == 0)
+        {
+            auto open     = line.find('"', start + 8);
+            auto close    = line.find('"', open + 1);
+            auto included = std::string();
+            if (!ReadExpanded(path.parent_path() /
+                                  line.substr(open + 1, close - open - 1),
+                              included, depth + 1))
+                return false;
+            contents += included;
+            continue;
+        }
+        contents += line;
+        contents += '\n';
+    }
+    return true;
+}
+
+// The loader as it was, a property tree per manifest
+static std::size_t LoadWithPropertyTree(const fs::path &root)
+{
+    namespace pt      = boost::property_tree;
+    std::size_t count = 0;
+    for (auto &entry : fs::recursive_directory_iterator(root))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".json")
+            continue;
+        auto tree = pt::ptree();
+        pt::read_json(entry.path().string(), tree);
+        if (tree.get<std::string>("type", "") != "shader")
+            continue;
+        auto name = tree.get<std::string>("name");
+        for (auto &shadelet : tree.get_child("sources"))
+        {
+            auto contents = std::string();
+            ReadExpanded(entry.path().parent_path() /
+                             shadelet.second.get<std::string>("path"),
+                         contents, 0);
+            shadelet.second.get<std::string>("type");
+        }
+        count++;
+    }
+    return count;
+}
+
+// Best of a few runs, in milliseconds, and what the last one loaded
+template <typename Func>
+static double Measure(Func &&func, std::size_t &loaded)
+{
+    double best = 1e30;
+    for (int r = 0; r < Repeats; r++)
+    {
+        auto start = steady_clock::now();
+        loaded     = func();
+        double ms =
+            duration<double, std::milli>(steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = fs::temp_directory_path() / "manifest_bench";
+    GenerateTree(root);
+    auto jobs = JobSystem();
+
+    std::size_t counts[4] = {};
+    double      times[4]  = {};
+    times[0]              = Measure(
+        [&]() { return LoadWithPropertyTree(root); }, counts[0]);
+    times[1] = Measure(
+        [&]() {
+            auto preprocessor = ShaderPreprocessor();
+            return ShaderSource::ReadShaderSources(root.string(),
+                                                   &preprocessor)
+                .size();
+        },
+        counts[1]);
+    times[2] = Measure(
+        [&]() {
+            auto preprocessor = ShaderPreprocessor();
+            return ShaderSource::ReadShaderSources(root.string(),
+                                                   &preprocessor, &jobs)
+                .size();
+        },
+        counts[2]);
+    // The first run writes the index, the others start from it
+    times[3] = Measure(
+        [&]() {
+            auto preprocessor = ShaderPreprocessor();
+            auto index        = ManifestIndex(root / "manifests.idx");
+            index.Load();
+            return ShaderSource::ReadShaderSources(
+                       root.string(), &preprocessor, &jobs, &index)
+                .size();
+        },
+        counts[3]);
+
+    const char *names[4] = {"property tree", "loader", "loader, jobs",
+                            "loader, index"};
+    std::cout << DirectoryCount * ManifestsPerDir << " manifests, "
+              << jobs.GetThreadCount() << " threads" << std::endl;
+    std::cout << "loader          programs       ms" << std::endl;
+    for (int i = 0; i < 4; i++)
+        std::cout << std::left << std::setw(14) << names[i] << std::right
+                  << std::setw(10) << counts[i] << std::fixed
+                  << std::setprecision(1) << std::setw(9) << times[i]
+                  << std::endl;
+
+    // Every run drops its sources, which releases the texts they stored
+    SourceStoreStats sourceStats = SourceStore::Shared().GetStats();
+    std::cout << sourceStats.stored << " source texts stored, "
+              << sourceStats.shared << " shared, " << sourceStats.released
+              << " released" << std::endl;
+
+    fs::remove_all(root);
+    return 0;
+}
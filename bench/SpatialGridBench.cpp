@@ -0,0 +1,148 @@
+// 100,000 objects wandering through a SpatialGrid, moved every frame with
+// Move one at a time and with MoveMany on 1 to N threads, then queried
+// with a camera frustum
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+#include "SpatialGrid.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+static constexpr int         Frames      = 60;
+static constexpr std::size_t ObjectCount = 100000;
+static constexpr float       WorldSize   = 1000.0f;
+static constexpr float       CellSize    = 8.0f;
+static constexpr float       DeltaTime   = 1.0f / 60.0f;
+
+struct Scene
+{
+public:
+    std::vector<SpatialGrid::ObjectID> ids;
+    std::vector<glm::vec4>             spheres;
+    std::vector<glm::vec3>             velocities;
+};
+
+// The same scene every time, so every row moves the same objects
+static Scene CreateScene(SpatialGrid &grid)
+{
+    auto random   = std::mt19937(42);
+    auto position = std::uniform_real_distribution<float>(0.0f, WorldSize);
+    auto speed    = std::uniform_real_distribution<float>(-20.0f, 20.0f);
+    auto radius   = std::uniform_real_distribution<float>(0.5f, 3.0f);
+
+    auto scene = Scene();
+    for (std::size_t i = 0; i < ObjectCount; i++)
+    {
+        auto center = glm::vec3(position(random), position(random) * 0.05f,
+                                position(random));
+        // A few are too large for their cell
+        float r = i % 1000 == 0 ? CellSize * 2.0f : radius(random);
+        scene.ids.push_back(grid.Insert(center, r));
+        scene.spheres.push_back(glm::vec4(center, r));
+        scene.velocities.push_back(
+            glm::vec3(speed(random), speed(random) * 0.1f, speed(random)));
+    }
+    return scene;
+}
+
+static void Step(Scene &scene)
+{
+    for (std::size_t i = 0; i < scene.spheres.size(); i++)
+    {
+        auto center = glm::vec3(scene.spheres[i]) +
+                      scene.velocities[i] * DeltaTime;
+        scene.spheres[i] = glm::vec4(center, scene.spheres[i].w);
+    }
+}
+
+// Average milliseconds per frame spent in move, the scene is stepped
+// outside of the measurement
+template <typename Func>
+static double Measure(Scene &scene, Func &&move)
+{
+    double total = 0.0;
+    for (int frame = 0; frame < Frames; frame++)
+    {
+        Step(scene);
+        auto start = steady_clock::now();
+        move();
+        total +=
+            duration<double, std::milli>(steady_clock::now() - start).count();
+    }
+    return total / Frames;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t maxThreads =
+        std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << ObjectCount << " objects, " << CellSize << " unit cells, "
+              << Frames << " frames" << std::endl;
+    std::cout << "mover     threads  move ms  speedup  cells" << std::endl;
+
+    double serial = 0.0;
+    {
+        auto grid  = SpatialGrid(CellSize);
+        auto scene = CreateScene(grid);
+        serial     = Measure(scene, [&] {
+            for (std::size_t i = 0; i < scene.ids.size(); i++)
+                grid.Move(scene.ids[i], glm::vec3(scene.spheres[i]),
+                          scene.spheres[i].w);
+        });
+        std::cout << std::left << std::setw(10) << "Move" << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(7) << 1
+                  << std::setw(9) << serial << std::setw(9) << 1.0
+                  << std::setw(7) << grid.GetCellCount() << std::endl;
+    }
+
+    for (std::size_t threads = 1; threads <= maxThreads; threads++)
+    {
+        auto jobs  = JobSystem(threads - 1);
+        auto grid  = SpatialGrid(CellSize);
+        auto scene = CreateScene(grid);
+        double ms  = Measure(scene, [&] {
+            grid.MoveMany(jobs, scene.ids.data(), scene.spheres.data(),
+                          scene.ids.size());
+        });
+        std::cout << std::left << std::setw(10) << "MoveMany" << std::right
+                  << std::setw(7) << threads << std::setw(9) << ms
+                  << std::setw(9) << serial / ms << std::setw(7)
+                  << grid.GetCellCount() << std::endl;
+
+        if (threads != maxThreads)
+            continue;
+
+        // What a camera in the middle of the world sees of the last frame
+        auto frustum = Frustum::FromMatrix(
+            glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f,
+                             300.0f) *
+            glm::lookAt(glm::vec3(WorldSize * 0.5f, 20.0f, WorldSize * 0.5f),
+                        glm::vec3(WorldSize, 0.0f, WorldSize),
+                        glm::vec3(0.0f, 1.0f, 0.0f)));
+        auto visible = std::vector<SpatialGrid::ObjectID>();
+        auto start   = steady_clock::now();
+        for (int frame = 0; frame < Frames; frame++)
+        {
+            visible.clear();
+            grid.QueryFrustum(frustum, visible);
+        }
+        double queryMs =
+            duration<double, std::milli>(steady_clock::now() - start)
+                .count() /
+            Frames;
+        std::cout << "QueryFrustum " << queryMs << " ms, " << visible.size()
+                  << " objects visible" << std::endl;
+    }
+    return 0;
+}
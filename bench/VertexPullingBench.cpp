@@ -0,0 +1,235 @@
+// Vertex pulling against classic attribute fetch, over the same multi draw
+// of meshes in three different vertex layouts
+#include "FrameConstants.hpp"
+#include "GLState.hpp"
+#include "IndirectDrawList.hpp"
+#include "MeshPool.hpp"
+#include "OpenGLExtensions.hpp"
+#include "RenderTarget.hpp"
+#include "Shader.hpp"
+#include "ShaderSource.hpp"
+#include "UniformBuffer.hpp"
+
+#include <GL/glew.h>
+// glew must be imported before glfw3
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+static constexpr int         Frames     = 20;
+static constexpr std::size_t DrawCount  = 16384;
+static constexpr int         GridSize   = 32; // Vertices per mesh side
+static constexpr GLsizei     TargetSize = 1024;
+
+// A bumpy grid of GridSize * GridSize vertices, written in the given layout
+static void AddGrid(MeshPool &pool, const VertexLayout &layout, float bump)
+{
+    auto data    = std::vector<GLfloat>();
+    auto indices = std::vector<std::uint32_t>();
+    for (int y = 0; y < GridSize; y++)
+        for (int x = 0; x < GridSize; x++)
+        {
+            float u      = float(x) / float(GridSize - 1);
+            float v      = float(y) / float(GridSize - 1);
+            auto  vertex = std::vector<GLfloat>(layout.stride, 0.0f);
+            if (layout.positionOffset >= 0)
+            {
+                vertex[layout.positionOffset]     = u - 0.5f;
+                vertex[layout.positionOffset + 1] = v - 0.5f;
+                vertex[layout.positionOffset + 2] = bump * u * v;
+            }
+            if (layout.uvOffset >= 0)
+            {
+                vertex[layout.uvOffset]     = u;
+                vertex[layout.uvOffset + 1] = v;
+            }
+            data.insert(data.end(), vertex.begin(), vertex.end());
+        }
+    for (int y = 0; y + 1 < GridSize; y++)
+        for (int x = 0; x + 1 < GridSize; x++)
+        {
+            std::uint32_t i = std::uint32_t(y * GridSize + x);
+            std::uint32_t r = i + 1, u = i + GridSize, d = u + 1;
+            indices.insert(indices.end(), {i, r, d, i, d, u});
+        }
+    pool.AddMesh(data.data(), std::size_t(GridSize * GridSize), layout,
+                 indices);
+}
+
+struct Result
+{
+public:
+    double submitMs = 0.0; // Issuing the draw
+    double gpuMs    = 0.0; // Timer query, some drivers do not report it
+    double frameMs  = 0.0; // Until the results are in
+};
+
+static Result Run(GLState &state, Shader &shader, bool pullVertices)
+{
+    // Position and uv, the Vertex layout
+    auto interleaved           = VertexLayout();
+    interleaved.stride         = 5;
+    interleaved.positionOffset = 0;
+    interleaved.uvOffset       = 3;
+    // Position only
+    auto positions           = VertexLayout();
+    positions.stride         = 3;
+    positions.positionOffset = 0;
+    // Uv first, and room for a normal nobody reads
+    auto padded           = VertexLayout();
+    padded.stride         = 8;
+    padded.positionOffset = 5;
+    padded.uvOffset       = 0;
+
+    auto pool = MeshPool();
+    AddGrid(pool, interleaved, 0.2f);
+    AddGrid(pool, positions, 0.4f);
+    AddGrid(pool, padded, 0.6f);
+    pool.CreatePool(state, pullVertices);
+
+    auto list = IndirectDrawList();
+    list.CreateList(state, DrawCount);
+    list.BeginFrame(DrawCount);
+    int side = 128;
+    for (std::size_t i = 0; i < DrawCount; i++)
+    {
+        auto  constants = ObjectConstants();
+        float x         = float(int(i) % side) - side * 0.5f;
+        float y         = float(int(i) / side) - side * 0.5f;
+        constants.model =
+            glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+        constants.color = glm::vec4(1.0f);
+        list.SetDraw(i, pool.GetRange(std::uint32_t(i % 3)), constants);
+    }
+    list.Flush();
+
+    GLuint query = 0;
+    GLCall(glGenQueries(1, &query));
+    auto result = Result();
+    for (int frame = -1; frame < Frames; frame++)
+    {
+        // Frame -1 warms up
+        GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        auto start = steady_clock::now();
+        GLCall(glBeginQuery(GL_TIME_ELAPSED, query));
+        shader.SetInUse(state);
+        list.Draw(pool);
+        GLCall(glEndQuery(GL_TIME_ELAPSED));
+        auto submitted = steady_clock::now();
+
+        GLuint64 elapsed = 0;
+        GLCall(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed));
+        auto finished = steady_clock::now();
+        if (frame < 0)
+            continue;
+        result.submitMs +=
+            duration<double, std::milli>(submitted - start).count();
+        result.gpuMs += double(elapsed) / 1e6;
+        result.frameMs +=
+            duration<double, std::milli>(finished - start).count();
+    }
+    result.submitMs /= Frames;
+    result.gpuMs /= Frames;
+    result.frameMs /= Frames;
+
+    GLCall(glDeleteQueries(1, &query));
+    list.ClearList();
+    pool.ClearPool();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return 1;
+    }
+    // Nothing is shown, everything is drawn into a RenderTarget
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "bench", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "OpenGL 4.5 is required" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK || !HasMultiDrawIndirect())
+    {
+        std::cerr << "Multi draw indirect is required" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    {
+        auto state = GLState();
+        state.SetDepthTest(true);
+        state.SetViewport(0, 0, TargetSize, TargetSize);
+
+        auto target = RenderTarget();
+        target.CreateTarget(state, TargetSize, TargetSize);
+        target.Bind();
+
+        auto sources = ShaderSource::ReadShaderSources("res/");
+        auto errors  = std::make_unique<std::vector<std::string>>();
+        auto shaders = Shader::CompileShaders(sources, errors);
+
+        long indirect = Shader::FindShader(*shaders, "indirect");
+        long pulled   = Shader::FindShader(*shaders, "pulled");
+        if (indirect < 0 || pulled < 0)
+        {
+            for (auto const &error : *errors)
+                std::cerr << error << std::endl;
+            glfwTerminate();
+            return 1;
+        }
+
+        // Every draw in view, each a few pixels across
+        auto frameConstants = FrameConstants();
+        frameConstants.viewProjection =
+            glm::perspective(glm::radians(60.0f), 1.0f, 1.0f, 500.0f) *
+            glm::lookAt(glm::vec3(0.0f, 0.0f, 120.0f), glm::vec3(0.0f),
+                        glm::vec3(0.0f, 1.0f, 0.0f));
+        auto frameBuffer = UniformBuffer();
+        frameBuffer.CreateBuffer(state, sizeof(FrameConstants));
+        frameBuffer.UpdateBuffer(&frameConstants, sizeof(FrameConstants));
+        frameBuffer.BindBase(FrameConstantsBinding);
+
+        Result attributes = Run(state, (*shaders)[indirect], false);
+        Result pulling    = Run(state, (*shaders)[pulled], true);
+
+        std::cout << DrawCount << " draws of " << GridSize * GridSize
+                  << " vertices, 3 layouts, " << glGetString(GL_RENDERER)
+                  << std::endl;
+        std::cout << "fetch       submit ms   gpu ms  frame ms" << std::endl;
+        for (auto const &row : {std::make_pair("attributes", attributes),
+                                std::make_pair("pulling", pulling)})
+            std::cout << std::left << std::setw(10) << row.first << std::right
+                      << std::fixed << std::setprecision(3) << std::setw(11)
+                      << row.second.submitMs << std::setw(9)
+                      << row.second.gpuMs << std::setw(10)
+                      << row.second.frameMs << std::endl;
+
+        frameBuffer.ClearBuffer();
+        target.ClearTarget();
+    }
+
+    glfwTerminate();
+    return 0;
+}
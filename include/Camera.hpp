@@ -0,0 +1,71 @@
+#pragma once
+#ifndef Camera_hpp
+#define Camera_hpp
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// A perspective camera stored as a position and an orientation. Every
+// derived matrix and the frustum are computed once in Update, and only when
+// something changed, so an idle camera costs nothing and any number of
+// consumers can read the cached results.
+class Camera
+{
+private:
+    glm::vec3 position;
+    glm::quat orientation;
+
+    float fieldOfView; // Vertical, in radians
+    float aspectRatio;
+    float nearPlane;
+    float farPlane;
+
+    bool viewDirty;
+    bool projectionDirty;
+
+    glm::mat4 view;
+    glm::mat4 inverseView;
+    glm::mat4 projection;
+    glm::mat4 inverseProjection;
+    glm::mat4 viewProjection;
+    glm::mat4 inverseViewProjection;
+    Frustum   frustum;
+
+public:
+    Camera(float fieldOfView, float aspectRatio, float nearPlane,
+           float farPlane);
+    ~Camera();
+
+    void SetPosition(const glm::vec3 &position);
+    void SetOrientation(const glm::quat &orientation);
+    void SetPerspective(float fieldOfView, float aspectRatio, float nearPlane,
+                        float farPlane);
+    void SetAspectRatio(float aspectRatio);
+
+    // Moves along the camera's own axes, -z being forward
+    void MoveLocal(const glm::vec3 &offset);
+    // Yaw turns about the world up axis, pitch about the camera's right axis
+    void Rotate(float yaw, float pitch);
+    void LookAt(const glm::vec3 &target,
+                const glm::vec3 &up = glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Recomputes whatever is out of date, call once per frame before use
+    void Update();
+
+    const glm::vec3 &GetPosition() const;
+    const glm::quat &GetOrientation() const;
+    glm::vec3        GetForward() const;
+    float            GetNearPlane() const;
+    float            GetFarPlane() const;
+
+    const glm::mat4 &GetView() const;
+    const glm::mat4 &GetInverseView() const;
+    const glm::mat4 &GetProjection() const;
+    const glm::mat4 &GetViewProjection() const;
+    const glm::mat4 &GetInverseViewProjection() const;
+    const Frustum &  GetFrustum() const;
+};
+
+#endif
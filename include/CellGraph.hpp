@@ -0,0 +1,91 @@
+#pragma once
+#ifndef CellGraph_hpp
+#define CellGraph_hpp
+
+#include "Frustum.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// A convex opening from one cell into another
+struct Portal
+{
+public:
+    std::vector<glm::vec3> vertices;
+    std::size_t            targetCell;
+};
+
+// A convex region of an interior, such as a room or a corridor
+struct Cell
+{
+public:
+    std::string              name;
+    glm::vec3                boundsMin;
+    glm::vec3                boundsMax;
+    std::vector<Portal>      portals;
+    std::vector<std::size_t> meshes; // Indices into the scene's mesh list
+};
+
+class CellGraph
+{
+private:
+    std::string       name;
+    std::vector<Cell> cells;
+    std::vector<bool> meshInCell; // By mesh index, false past its end
+
+    // Frame stamps, used so the visited sets never have to be cleared
+    std::uint32_t              currentStamp;
+    std::vector<std::uint32_t> cellStamps;
+    std::vector<std::uint32_t> meshStamps;
+    std::vector<std::uint32_t> projectedStamps;
+
+    // Screen-space bounds as (min x, min y, max x, max y) in normalized
+    // device coordinates. A cell's are the merged bounds of every portal
+    // path reaching it this frame, a portal's are of its projection.
+    std::vector<glm::vec4>              cellBounds;
+    std::vector<std::vector<glm::vec4>> portalBounds; // Per cell, per portal
+    std::vector<bool>                   cellQueued;
+    std::deque<std::size_t>             openCells;
+
+    void SubmitMeshes(std::size_t               cellIndex,
+                      std::vector<std::size_t> &visibleMeshes);
+    void ProjectPortals(std::size_t cellIndex, const glm::vec3 &eye,
+                        const Frustum &  frustum,
+                        const glm::mat4 &viewProjection);
+
+public:
+    CellGraph(std::string name);
+    ~CellGraph();
+
+    const std::string &GetName() const;
+
+    // Reads every JSON file of type "cells" in the directory
+    static std::vector<CellGraph> ReadCellGraphs(std::string directoryPath);
+
+    std::size_t AddCell(Cell cell);
+
+    std::vector<Cell> const &GetCells() const;
+
+    // Returns the index of the cell containing the point, or -1 if the point
+    // is outside of every cell
+    long FindCell(const glm::vec3 &point) const;
+
+    // True if any cell lists the mesh
+    bool ContainsMesh(std::size_t mesh) const;
+
+    // Gathers the meshes of every cell visible from the eye through the
+    // portal chain. Each cell's portals are projected once a frame, and a
+    // cell is only revisited when another path widens its bounds. Meshes in
+    // no cell are left out. Returns false if the eye is outside of every
+    // cell, in which case nothing can be culled.
+    bool ComputeVisibleMeshes(const glm::vec3 &eye, const Frustum &frustum,
+                              const glm::mat4 &         viewProjection,
+                              std::vector<std::size_t> &visibleMeshes);
+};
+
+#endif
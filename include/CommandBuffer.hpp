@@ -0,0 +1,84 @@
+#pragma once
+#ifndef CommandBuffer_hpp
+#define CommandBuffer_hpp
+
+#include "LinearAllocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+enum class CommandType : std::uint8_t
+{
+    BindProgram,
+    SetUniformMat4,
+    SetUniformVec4,
+    BindUniformRange,
+    DrawMesh
+};
+
+struct CommandHeader
+{
+public:
+    CommandType    type;
+    CommandHeader *next;
+};
+
+// Whatever executes recorded commands. Commands only refer to shaders and
+// meshes by index, so nothing about them is tied to OpenGL.
+class CommandBackend
+{
+public:
+    virtual ~CommandBackend();
+
+    virtual void BindProgram(std::uint32_t shaderIndex) = 0;
+    // Uniforms are named by HashName (StringHash.hpp)
+    virtual void SetUniformMat4(std::uint32_t nameHash, const float *value) = 0;
+    virtual void SetUniformVec4(std::uint32_t nameHash, const float *value) = 0;
+    // Binds a slice of the frame's per-draw uniform storage
+    virtual void BindUniformRange(std::uint32_t binding, std::size_t offset,
+                                  std::size_t size)                         = 0;
+    virtual void DrawMesh(std::uint32_t meshIndex)                          = 0;
+};
+
+// A list of draw commands recorded into its own linear allocator, so any
+// thread may record into a buffer without locking as long as no other
+// thread touches that same buffer. Replaying happens on the thread that
+// owns the backend.
+class CommandBuffer
+{
+private:
+    LinearAllocator allocator;
+    CommandHeader * first;
+    CommandHeader * last;
+    std::size_t     commandCount;
+
+    template <typename T>
+    T *Append(CommandType type);
+
+public:
+    CommandBuffer();
+    CommandBuffer(const CommandBuffer &other) = delete;
+    CommandBuffer &operator=(const CommandBuffer &other) = delete;
+    CommandBuffer(CommandBuffer &&other);
+    CommandBuffer &operator=(CommandBuffer &&other) = delete;
+    ~CommandBuffer();
+
+    // Forgets every command, keeping the memory for the next frame
+    void Reset();
+
+    // Uniforms are named by HashName, so nothing has to outlive the buffer
+    void BindProgram(std::uint32_t shaderIndex);
+    void SetUniformMat4(std::uint32_t nameHash, const glm::mat4 &value);
+    void SetUniformVec4(std::uint32_t nameHash, const glm::vec4 &value);
+    void BindUniformRange(std::uint32_t binding, std::size_t offset,
+                          std::size_t size);
+    void DrawMesh(std::uint32_t meshIndex);
+
+    void Replay(CommandBackend &backend) const;
+
+    std::size_t GetCommandCount() const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef CullingPass_hpp
+#define CullingPass_hpp
+
+#include "IndirectDrawList.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+class GLState;
+class HiZBuffer;
+class Shader;
+
+// Culls an IndirectDrawList on the GPU with the "cull" compute program.
+// Every draw's bounding sphere is tested against the frustum and against
+// last frame's HiZBuffer, and the draws that survive are appended to a
+// command buffer of their own, counted in another. The commands keep their
+// base instance, so draw IDs still point at the uncompacted constants.
+// Requires direct state access, HasMultiDrawIndirect and HasComputeShaders.
+class CullingPass
+{
+public:
+    // Storage buffer bindings, ObjectDataBinding is 0
+    static constexpr GLuint InputCommandsBinding  = 1;
+    static constexpr GLuint BoundsBinding         = 2;
+    static constexpr GLuint OutputCommandsBinding = 3;
+    static constexpr GLuint DrawCountBinding      = 4;
+
+    static constexpr GLuint GroupSize = 64; // Matches cull_comp.glsl
+
+private:
+    std::vector<glm::vec4> bounds;
+
+    GLuint      boundsBuffer;
+    GLuint      commandBuffer; // Compacted survivors
+    GLuint      countBuffer;   // One GLuint, the number of survivors
+    std::size_t capacity;
+    GLState *   state;
+
+    void CreateBuffers(std::size_t capacity);
+    void DeleteBuffers();
+
+public:
+    CullingPass();
+    CullingPass(const CullingPass &other) = delete;
+    CullingPass &operator=(const CullingPass &other) = delete;
+    CullingPass(CullingPass &&other)                 = delete;
+    CullingPass &operator=(CullingPass &&other) = delete;
+    ~CullingPass();
+
+    void CreatePass(GLState &state, std::size_t capacity);
+    void ClearPass();
+
+    // Same rules as IndirectDrawList, call both with the same count
+    void BeginFrame(std::size_t drawCount);
+
+    // World space bounding sphere of draw i, center in xyz, radius in w.
+    // Thread safe as long as no two threads write the same index.
+    void SetBounds(std::size_t index, const glm::vec4 &sphere);
+
+    // Uploads the frame's bounds
+    void Flush();
+
+    // Fills the survivor buffers from the draws' uploaded commands. The
+    // frame constants must be bound, their view projection is culled
+    // against. The Hi-Z test is skipped until hiZ has been built, and
+    // uses the view projection it was rendered with.
+    void Cull(Shader &cullShader, IndirectDrawList &draws,
+              const HiZBuffer &hiZ, const glm::mat4 &previousViewProjection);
+
+    // Issues the survivors, the draw program must already be in use
+    void Draw(IndirectDrawList &draws, MeshPool &pool);
+
+    // Reads the number of survivors back, stalling until culling is done.
+    // For debugging and tests only.
+    GLuint ReadDrawCount() const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef FlatHashMap_hpp
+#define FlatHashMap_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open addressing map from already hashed 32-bit keys (see StringHash.hpp)
+// to small values. The keys are used as their own hash, slots live in one
+// flat array and collisions probe linearly, so a lookup is usually a single
+// cache line. There is no erase, maps are built once and then read.
+template <typename Value>
+class FlatHashMap
+{
+private:
+    struct Slot
+    {
+        std::uint32_t key  = 0;
+        bool          used = false;
+        Value         value;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t       count = 0;
+
+    void Grow()
+    {
+        auto old = std::move(slots);
+        slots    = std::vector<Slot>(old.empty() ? 16 : old.size() * 2);
+        count    = 0;
+        for (auto &slot : old)
+            if (slot.used)
+                Insert(slot.key, std::move(slot.value));
+    }
+
+public:
+    // Inserts or overwrites
+    void Insert(std::uint32_t key, Value value)
+    {
+        // Keep the load at or below one half, probes stay short
+        if ((count + 1) * 2 > slots.size())
+            Grow();
+
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = key & mask;; i = (i + 1) & mask)
+        {
+            Slot &slot = slots[i];
+            if (!slot.used)
+            {
+                slot.key   = key;
+                slot.used  = true;
+                slot.value = std::move(value);
+                count++;
+                return;
+            }
+            if (slot.key == key)
+            {
+                slot.value = std::move(value);
+                return;
+            }
+        }
+    }
+
+    const Value *Find(std::uint32_t key) const
+    {
+        if (slots.empty())
+            return nullptr;
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = key & mask;; i = (i + 1) & mask)
+        {
+            const Slot &slot = slots[i];
+            if (!slot.used)
+                return nullptr;
+            if (slot.key == key)
+                return &slot.value;
+        }
+    }
+
+    Value *Find(std::uint32_t key)
+    {
+        return const_cast<Value *>(
+            static_cast<const FlatHashMap *>(this)->Find(key));
+    }
+
+    void Clear()
+    {
+        slots.clear();
+        count = 0;
+    }
+
+    std::size_t GetSize() const { return count; }
+};
+
+#endif
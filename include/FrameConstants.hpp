@@ -0,0 +1,36 @@
+#pragma once
+#ifndef FrameConstants_hpp
+#define FrameConstants_hpp
+
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Uniform block shared by every program, see res/include/frame_constants.glsl
+constexpr const char *FrameConstantsBlock   = "FrameConstants";
+constexpr GLuint      FrameConstantsBinding = 0;
+
+// Matches the std140 layout of the FrameConstants block exactly
+struct FrameConstants
+{
+public:
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition; // w is unused
+    float     time;
+    float     deltaTime;
+    glm::vec2 resolution;
+};
+
+static_assert(offsetof(FrameConstants, cameraPosition) == 192,
+              "FrameConstants does not match the std140 block layout");
+static_assert(offsetof(FrameConstants, time) == 208,
+              "FrameConstants does not match the std140 block layout");
+static_assert(offsetof(FrameConstants, resolution) == 216,
+              "FrameConstants does not match the std140 block layout");
+static_assert(sizeof(FrameConstants) == 224,
+              "FrameConstants does not match the std140 block layout");
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef Frustum_hpp
+#define Frustum_hpp
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct Plane
+{
+public:
+    Plane();
+    Plane(const glm::vec3 &normal, float distance);
+    // Plane through three points, facing the side 'a->b x a->c' points to
+    static Plane FromPoints(const glm::vec3 &a, const glm::vec3 &b,
+                            const glm::vec3 &c);
+
+    float SignedDistance(const glm::vec3 &point) const;
+    void  Flip();
+
+    glm::vec3 normal   = glm::vec3(0.0f, 1.0f, 0.0f);
+    float     distance = 0.0f;
+};
+
+// A convex volume bounded by inward facing planes. A camera frustum has six
+// planes, a frustum narrowed through a portal has one per portal edge plus
+// the portal plane itself.
+class Frustum
+{
+public:
+    static constexpr std::size_t MaxPlanes = 16;
+
+private:
+    std::array<Plane, MaxPlanes> planes;
+    std::size_t                  planeCount;
+
+public:
+    Frustum();
+    ~Frustum();
+
+    // Extracts the six clip planes from a (projection * view) matrix
+    static Frustum FromMatrix(const glm::mat4 &viewProjection);
+
+    bool AddPlane(const Plane &plane);
+
+    std::size_t  GetPlaneCount() const;
+    const Plane &GetPlane(std::size_t index) const;
+
+    bool ContainsPoint(const glm::vec3 &point) const;
+    bool IntersectsSphere(const glm::vec3 &center, float radius) const;
+    bool IntersectsAABB(const glm::vec3 &min, const glm::vec3 &max) const;
+
+    // The bounds of the volume's corners. Returns false if the volume is
+    // unbounded, such as a frustum narrowed through a portal, or empty.
+    bool ComputeBounds(glm::vec3 &min, glm::vec3 &max) const;
+
+    // Sutherland-Hodgman clip of a convex polygon against every plane,
+    // returns false if nothing of the polygon is left
+    bool ClipPolygon(const std::vector<glm::vec3> &polygon,
+                     std::vector<glm::vec3> &      clipped) const;
+};
+
+#endif
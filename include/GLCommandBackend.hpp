@@ -0,0 +1,37 @@
+#pragma once
+#ifndef GLCommandBackend_hpp
+#define GLCommandBackend_hpp
+
+#include "CommandBuffer.hpp"
+#include "GLState.hpp"
+#include "Mesh.hpp"
+#include "Shader.hpp"
+#include "UniformRing.hpp"
+
+#include <vector>
+
+// Replays recorded commands through OpenGL, only use it on the thread that
+// owns the context
+class GLCommandBackend : public CommandBackend
+{
+private:
+    GLState &            state;
+    std::vector<Shader> &shaders;
+    std::vector<Mesh> &  meshes;
+    UniformRing &        uniformRing;
+    Shader *             currentShader;
+
+public:
+    GLCommandBackend(GLState &state, std::vector<Shader> &shaders,
+                     std::vector<Mesh> &meshes, UniformRing &uniformRing);
+    ~GLCommandBackend();
+
+    void BindProgram(std::uint32_t shaderIndex) override;
+    void SetUniformMat4(std::uint32_t nameHash, const float *value) override;
+    void SetUniformVec4(std::uint32_t nameHash, const float *value) override;
+    void BindUniformRange(std::uint32_t binding, std::size_t offset,
+                          std::size_t size) override;
+    void DrawMesh(std::uint32_t meshIndex) override;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#pragma once
+#ifndef GLState_hpp
+#define GLState_hpp
+
+#include "FlatHashMap.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+struct GLStateStats
+{
+public:
+    std::size_t issued   = 0; // Calls that reached OpenGL
+    std::size_t filtered = 0; // Calls dropped, the state was already set
+};
+
+// Shadows the binding and fixed-function state of one context, so setting
+// something that is already set never reaches the driver. Everything that
+// binds or enables must go through here, or call Invalidate afterwards.
+// Uploads are expected to use GL_COPY_WRITE_BUFFER, which is not tracked.
+class GLState
+{
+public:
+    static constexpr GLuint      Unknown           = ~GLuint(0);
+    static constexpr std::size_t MaxTextureUnits   = 32;
+    static constexpr std::size_t MaxBufferBindings = 16;
+
+private:
+    // Generic buffer targets with a slot each, see TargetSlot
+    static constexpr std::size_t TrackedTargets = 6;
+
+    struct BufferRange
+    {
+    public:
+        GLuint     buffer = Unknown;
+        GLintptr   offset = 0;
+        GLsizeiptr size   = 0; // 0 for a whole-buffer (base) binding
+    };
+
+    struct VertexBufferBinding
+    {
+    public:
+        GLuint   buffer = Unknown;
+        GLintptr offset = 0;
+        GLsizei  stride = 0;
+    };
+
+    struct TextureBinding
+    {
+    public:
+        GLenum target  = 0;
+        GLuint texture = Unknown;
+    };
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint elementBuffer; // Part of the bound vertex array
+    GLuint framebuffer;   // Read and draw
+
+    std::array<GLuint, TrackedTargets> buffers;
+
+    // The element buffer each vertex array was last seen with
+    FlatHashMap<GLuint> vertexArrayElements;
+
+    // Vertex buffers attached to vertex arrays through direct state
+    // access, keyed by VertexBufferKey
+    FlatHashMap<VertexBufferBinding> vertexBuffers;
+
+    std::array<BufferRange, MaxBufferBindings> uniformRanges;
+    std::array<BufferRange, MaxBufferBindings> storageRanges;
+
+    GLuint                                      activeTexture;
+    std::array<TextureBinding, MaxTextureUnits> textures;
+    std::array<GLuint, MaxTextureUnits>         samplers;
+
+    // Capabilities are -1 while unknown
+    std::int8_t blend;
+    GLenum      blendSource;
+    GLenum      blendDestination;
+    GLenum      blendEquation;
+
+    std::int8_t depthTest;
+    std::int8_t depthWrite;
+    GLenum      depthFunction;
+
+    std::int8_t cullFace;
+    GLenum      cullMode;
+    GLenum      frontFace;
+    GLenum      polygonMode;
+    std::int8_t scissorTest;
+    GLint       viewport[4];
+
+    GLStateStats stats;
+
+    static int           TargetSlot(GLenum target);
+    static std::uint32_t VertexBufferKey(GLuint vertexArray, GLuint index);
+
+    bool Filter(bool redundant);
+    void SetCapability(GLenum capability, std::int8_t &cached, bool enabled);
+    void SelectTextureUnit(GLuint unit);
+    std::array<BufferRange, MaxBufferBindings> *IndexedRanges(GLenum target);
+
+public:
+    GLState();
+    ~GLState();
+
+    // Forgets everything, for after GL calls made behind the cache's back
+    void Invalidate();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertexArray);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                         GLintptr offset, GLsizeiptr size);
+    // Direct state access, the vertex array does not have to be bound
+    void VertexArrayVertexBuffer(GLuint vertexArray, GLuint bindingIndex,
+                                 GLuint buffer, GLintptr offset,
+                                 GLsizei stride);
+    void VertexArrayElementBuffer(GLuint vertexArray, GLuint buffer);
+    void BindFramebuffer(GLuint framebuffer);
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    void BindSampler(GLuint unit, GLuint sampler);
+
+    void SetBlend(bool enabled);
+    void SetBlendFunction(GLenum source, GLenum destination);
+    void SetBlendEquation(GLenum equation);
+
+    void SetDepthTest(bool enabled);
+    void SetDepthWrite(bool enabled);
+    void SetDepthFunction(GLenum function);
+
+    void SetCullFace(bool enabled);
+    void SetCullMode(GLenum mode);
+    void SetFrontFace(GLenum winding);
+    void SetPolygonMode(GLenum mode);
+    void SetScissorTest(bool enabled);
+    void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Deleting an object unbinds it, and its name may be handed out again,
+    // so deleted objects must be forgotten
+    void ForgetProgram(GLuint program);
+    void ForgetVertexArray(GLuint vertexArray);
+    void ForgetBuffer(GLuint buffer);
+    void ForgetFramebuffer(GLuint framebuffer);
+    void ForgetTexture(GLuint texture);
+    void ForgetSampler(GLuint sampler);
+
+    GLuint GetProgram() const;
+    GLuint GetVertexArray() const;
+
+    const GLStateStats &GetStats() const;
+    void                ResetStats();
+};
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef HeadlessContext_hpp
+#define HeadlessContext_hpp
+
+// An OpenGL core context made through EGL, without a window or a display
+// server, for tests and offline tools. Mesa's surfaceless platform is tried
+// first, then the first EGL device. There is no default framebuffer, draw
+// into a RenderTarget.
+class HeadlessContext
+{
+private:
+    // EGLDisplay and EGLContext, kept out of the header so including it
+    // does not pull in EGL's
+    void *display;
+    void *context;
+
+public:
+    HeadlessContext();
+    HeadlessContext(const HeadlessContext &other) = delete;
+    HeadlessContext &operator=(const HeadlessContext &other) = delete;
+    HeadlessContext(HeadlessContext &&other)                 = delete;
+    HeadlessContext &operator=(HeadlessContext &&other) = delete;
+    ~HeadlessContext();
+
+    // Makes the context current on this thread and initializes GLEW.
+    // Returns false if there is no EGL display or it cannot give the
+    // version.
+    bool CreateContext(int major, int minor);
+    void ClearContext();
+};
+
+#endif
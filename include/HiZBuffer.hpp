@@ -0,0 +1,50 @@
+#pragma once
+#ifndef HiZBuffer_hpp
+#define HiZBuffer_hpp
+
+#include <GL/glew.h>
+
+class GLState;
+class Shader;
+
+// A hierarchical depth buffer: a mip chain over a depth texture where every
+// texel holds the farthest depth of the area it covers. A CullingPass tests
+// bounds against one frame's pyramid the next frame, anything entirely
+// behind it was hidden then. Built by the "hiz" compute program.
+// Requires direct state access and HasComputeShaders.
+class HiZBuffer
+{
+public:
+    static constexpr GLuint GroupSize = 8; // Matches hiz_comp.glsl
+
+private:
+    GLuint   texture;
+    GLsizei  width;
+    GLsizei  height;
+    GLsizei  levelCount;
+    bool     valid; // Built at least once since CreateHiZ
+    GLState *state;
+
+public:
+    HiZBuffer();
+    HiZBuffer(const HiZBuffer &other) = delete;
+    HiZBuffer &operator=(const HiZBuffer &other) = delete;
+    HiZBuffer(HiZBuffer &&other)                 = delete;
+    HiZBuffer &operator=(HiZBuffer &&other) = delete;
+    ~HiZBuffer();
+
+    // The size of the depth textures it will be built from
+    void CreateHiZ(GLState &state, GLsizei width, GLsizei height);
+    void ClearHiZ();
+
+    // Rebuilds every level from a depth texture of the created size
+    void Build(Shader &hiZShader, GLuint depthTexture);
+
+    bool    IsValid() const;
+    GLuint  GetTexture() const;
+    GLsizei GetWidth() const;
+    GLsizei GetHeight() const;
+    GLsizei GetLevelCount() const;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+#ifndef IndirectDrawList_hpp
+#define IndirectDrawList_hpp
+
+#include "MeshPool.hpp"
+#include "ObjectConstants.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+class GLState;
+
+// Layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+public:
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20,
+              "DrawElementsIndirectCommand must be tightly packed");
+
+// A whole pass of MeshPool draws issued with one glMultiDrawElementsIndirect.
+// Draw i is one instance with base instance i, so its draw ID attribute
+// reads i from a buffer counting up from zero, and the vertex shader finds
+// its constants at u_Objects[i] in the ObjectData storage buffer. The number
+// of GL calls does not depend on the number of draws.
+// Requires direct state access and HasMultiDrawIndirect.
+class IndirectDrawList
+{
+private:
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<ObjectConstants>             objects;
+    std::vector<GLuint>                      meshes; // Pool mesh of each draw
+
+    GLuint      commandBuffer;
+    GLuint      objectBuffer;
+    GLuint      meshBuffer; // Read by pools that pull their vertices
+    GLuint      drawIDBuffer;
+    std::size_t capacity; // Draws the GPU buffers have room for
+    GLState *   state;
+
+    void CreateBuffers(std::size_t capacity);
+    void DeleteBuffers();
+    // Binds everything a draw needs but the indirect buffer
+    void BindForDraw(MeshPool &pool);
+
+public:
+    IndirectDrawList();
+    IndirectDrawList(const IndirectDrawList &other) = delete;
+    IndirectDrawList &operator=(const IndirectDrawList &other) = delete;
+    IndirectDrawList(IndirectDrawList &&other)                 = delete;
+    IndirectDrawList &operator=(IndirectDrawList &&other) = delete;
+    ~IndirectDrawList();
+
+    void CreateList(GLState &state, std::size_t capacity);
+    void ClearList();
+
+    // Starts a new frame of exactly this many draws, growing the storage
+    // when needed. Only call from the GL thread, outside of recording.
+    void BeginFrame(std::size_t drawCount);
+
+    // Thread safe as long as no two threads write the same index
+    void SetDraw(std::size_t index, const MeshRange &range,
+                 const ObjectConstants &constants);
+
+    // Uploads the frame's commands and constants
+    void Flush();
+
+    // Issues every draw of the frame, the program must already be in use
+    void Draw(MeshPool &pool);
+    // Issues commands someone else wrote over this frame's draws, such as
+    // the compacted output of a CullingPass. The number of commands is read
+    // from countBuffer where HasIndirectParameters, otherwise all
+    // GetDrawCount of them are issued and the unused ones must be zeroed.
+    void Draw(MeshPool &pool, GLuint drawCommands, GLuint countBuffer);
+
+    std::size_t GetDrawCount() const;
+    GLuint      GetCommandBuffer() const;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#pragma once
+#ifndef JobSystem_hpp
+#define JobSystem_hpp
+
+#include "WorkStealingDeque.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class JobSystem;
+struct Job;
+
+using JobFunction = void (*)(JobSystem &jobs, const Job &job);
+
+// Counts the unfinished jobs of a batch. Jobs can be made to wait on a
+// counter, which is how dependencies between batches are expressed.
+class JobCounter
+{
+private:
+    friend class JobSystem;
+    std::atomic<std::size_t> pending;
+
+public:
+    JobCounter();
+    ~JobCounter();
+
+    bool IsDone() const;
+};
+
+struct Job
+{
+public:
+    JobFunction function = nullptr;
+    void *      data     = nullptr;
+    std::size_t begin    = 0;
+    std::size_t end      = 0;
+    // Decremented once the job has run
+    JobCounter *counter = nullptr;
+    // The job is not started until this counter reaches zero
+    JobCounter *dependency = nullptr;
+};
+
+// Work-stealing job system. Every worker owns a Chase-Lev deque it pushes to
+// and pops from, idle workers steal from the others. The thread that
+// creates the system is worker 0 and only runs jobs while it waits on a
+// counter. Jobs may only be started from the creating thread or from
+// inside other jobs.
+class JobSystem
+{
+public:
+    static constexpr std::size_t MaxQueuedJobs = 4096;
+
+private:
+    // A queued job. Busy from Run until the job has been copied out of it
+    // to execute, only then may its worker hand it out again.
+    struct JobSlot
+    {
+        Job               job;
+        std::atomic<bool> busy{false};
+    };
+
+    struct Worker
+    {
+        WorkStealingDeque<JobSlot, MaxQueuedJobs> deque;
+        // Slot storage, searched round-robin for one that is not busy.
+        // Larger than the deque, so there always is one.
+        std::unique_ptr<JobSlot[]> pool;
+        std::size_t                poolIndex = 0;
+        std::thread                thread;
+    };
+
+    struct ParallelForContext
+    {
+        void (*invoke)(void *func, std::size_t begin, std::size_t end);
+        void *      func;
+        std::size_t grain;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool>                    running;
+
+    // Sleeping for idle workers
+    std::atomic<std::size_t> queuedJobs;
+    std::atomic<std::size_t> sleepingWorkers;
+    std::mutex               sleepMutex;
+    std::condition_variable  sleepCondition;
+
+    std::size_t CurrentWorker() const;
+    void        WorkerLoop(std::size_t index);
+    JobSlot *   AcquireSlot(Worker &worker);
+    JobSlot *   FindJob(std::size_t index);
+    void        Execute(std::size_t index, JobSlot *slot);
+
+    static void ParallelForJob(JobSystem &jobs, const Job &job);
+
+    template <typename Func>
+    static void InvokeRange(void *func, std::size_t begin, std::size_t end)
+    {
+        (*static_cast<Func *>(func))(begin, end);
+    }
+
+public:
+    // workerThreads excludes the calling thread, which becomes worker 0
+    JobSystem(std::size_t workerThreads =
+                  std::max(1u, std::thread::hardware_concurrency()) - 1);
+    JobSystem(const JobSystem &other) = delete;
+    JobSystem &operator=(const JobSystem &other) = delete;
+    ~JobSystem();
+
+    // Queues the jobs, adding their number to the counter first
+    void Run(const Job *jobs, std::size_t count, JobCounter &counter);
+    void Run(const Job &job, JobCounter &counter);
+
+    // Runs other jobs until the counter reaches zero, so waiting never
+    // blocks a worker and the calling thread helps out meanwhile
+    void Wait(const JobCounter &counter);
+
+    // Calls func(begin, end) over sub-ranges of [0, count) and waits. The
+    // range is run a grain at a time, and half of what is left is only
+    // queued for thieves once the worker's deque is empty, that is once
+    // the last half offered has been taken. A grain of zero picks one
+    // giving every thread several ranges.
+    template <typename Func>
+    void ParallelFor(std::size_t count, Func &&func, std::size_t grain = 0)
+    {
+        if (count == 0)
+            return;
+        if (grain == 0)
+            grain =
+                std::max<std::size_t>(1, count / (GetThreadCount() * 8));
+
+        using FuncType = std::remove_reference_t<Func>;
+
+        auto context   = ParallelForContext();
+        context.invoke = &InvokeRange<FuncType>;
+        context.func   = const_cast<void *>(static_cast<const void *>(&func));
+        context.grain  = grain;
+
+        auto counter = JobCounter();
+        auto job     = Job();
+        job.function = &JobSystem::ParallelForJob;
+        job.data     = &context;
+        job.begin    = 0;
+        job.end      = count;
+        Run(job, counter);
+        Wait(counter);
+    }
+
+    std::size_t GetThreadCount() const;
+};
+
+#endif
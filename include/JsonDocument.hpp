@@ -0,0 +1,77 @@
+#pragma once
+#ifndef JsonDocument_hpp
+#define JsonDocument_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class JsonType : std::uint8_t
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+// One value of a JsonDocument. Children are linked through their indices,
+// the first child of an array or object and then each next sibling.
+struct JsonValue
+{
+public:
+    static constexpr std::uint32_t None = 0xFFFFFFFF;
+
+    JsonType type = JsonType::Null;
+    // Strings without their quotes and escapes, numbers and literals as
+    // written
+    std::string_view text;
+    std::string_view key; // Within an object
+    std::uint32_t    firstChild  = None;
+    std::uint32_t    nextSibling = None;
+};
+
+// A small JSON parser for manifests. Every value goes into one array and
+// strings are views into the parsed text, so parsing allocates next to
+// nothing. Only strings with escapes get storage of their own. The text
+// must outlive the document.
+class JsonDocument
+{
+public:
+    static constexpr int MaxDepth = 64;
+
+private:
+    std::vector<JsonValue>  values;
+    std::deque<std::string> unescaped; // Never moved, views point in
+    std::string             error;
+
+    std::string_view text;
+    std::size_t      position;
+
+    void          SkipSpace();
+    bool          Fail(const char *message);
+    std::uint32_t ParseValue(int depth);
+    bool          ParseString(std::string_view &result);
+    bool          ParseContainer(std::uint32_t index, int depth);
+
+public:
+    JsonDocument();
+    ~JsonDocument();
+
+    bool               Parse(std::string_view json);
+    const std::string &GetError() const;
+
+    // The root is value 0, once parsed
+    const JsonValue &Get(std::uint32_t index) const;
+    // Member of an object, None if there is none or it is not an object
+    std::uint32_t Find(std::uint32_t object, std::string_view key) const;
+    // The member if it is a string
+    bool FindString(std::uint32_t object, std::string_view key,
+                    std::string_view &result) const;
+};
+
+#endif
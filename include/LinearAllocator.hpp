@@ -0,0 +1,41 @@
+#pragma once
+#ifndef LinearAllocator_hpp
+#define LinearAllocator_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for per-frame data. Nothing is freed individually, Reset
+// rewinds everything at once and keeps the memory for the next frame. Not
+// thread safe, give every thread its own.
+class LinearAllocator
+{
+private:
+    struct Block
+    {
+        std::unique_ptr<std::uint8_t[]> memory;
+        std::size_t                      size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t        currentBlock;
+    std::size_t        offset;
+    std::size_t        blockSize;
+
+public:
+    LinearAllocator(std::size_t blockSize = 64 * 1024);
+    LinearAllocator(const LinearAllocator &other) = delete;
+    LinearAllocator &operator=(const LinearAllocator &other) = delete;
+    LinearAllocator(LinearAllocator &&other)                 = default;
+    LinearAllocator &operator=(LinearAllocator &&other) = default;
+    ~LinearAllocator();
+
+    void *Allocate(std::size_t size, std::size_t alignment);
+    void  Reset();
+
+    std::size_t GetCapacity() const;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef ManifestIndex_hpp
+#define ManifestIndex_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+// What a shader manifest says, before any source file is read
+struct ShaderManifest
+{
+public:
+    std::string                                 path; // Empty if unreadable
+    std::string                                 name; // Empty if not a shader
+    std::vector<std::string>                    keywords;
+    std::vector<std::pair<std::string, GLenum>> shadelets; // Path, type
+    bool complete = true; // False if a shadelet entry was unusable
+
+    // The file as it was read, to tell later whether it changed
+    std::int64_t  modified = 0;
+    std::uint64_t size     = 0;
+    std::uint64_t hash     = 0; // HashContent of the whole file
+};
+
+// Every manifest read by the last ReadShaderSources, in one binary file, so
+// an unchanged tree is loaded without parsing any JSON. A manifest is taken
+// from the index while its file has the recorded modification time and
+// size. A file whose time changed is hashed again, and only parsed if its
+// contents changed too.
+//
+// The file is memory mapped and records are only read when looked up.
+// Lookup changes nothing, so it may be called from several threads.
+class ManifestIndex
+{
+private:
+    std::filesystem::path path;
+    const char *          data;
+    std::size_t           dataSize;
+    bool                  mapped;
+    std::string           buffer; // The file, where it could not be mapped
+    // Manifest path to record number
+    std::unordered_map<std::string_view, std::uint32_t> entries;
+
+    void Unload();
+
+public:
+    ManifestIndex(std::filesystem::path path);
+    ManifestIndex(const ManifestIndex &other) = delete;
+    ManifestIndex &operator=(const ManifestIndex &other) = delete;
+    ~ManifestIndex();
+
+    // Maps the index file. False if there is none, or it is from another
+    // version, the index is then empty until the next Store.
+    bool Load();
+
+    // Fills in the manifest if it is in the index and its file is
+    // unchanged. Manifests that are not shaders are found too, with no name.
+    bool Lookup(const std::string &manifestPath,
+                ShaderManifest &   manifest) const;
+
+    // Replaces the index with these manifests, unless they are exactly
+    // what it holds already. Manifests that could not be read are left out.
+    bool Store(const std::vector<ShaderManifest> &manifests);
+
+    std::size_t GetSize() const;
+};
+
+#endif
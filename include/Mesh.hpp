@@ -9,6 +9,8 @@
 
 #include <GL/glew.h>
 
+class GLState;
+
 class Mesh
 {
 private:
@@ -17,6 +19,13 @@ private:
         ibo;    // Index Buffer Object
     std::vector<Vertex>        vertices;
     std::vector<std::uint32_t> indices;
+    GLState *                  state; // Told when the buffers are deleted
+    // Direct state access meshes attach their buffers to the vertex array
+    // shared by every mesh, which they do not own
+    bool sharedVertexArray;
+
+    void CreateBuffersDirect();
+    void CreateBuffersBound();
 
 public:
     Mesh();
@@ -27,10 +36,15 @@ public:
 
     ~Mesh();
 
-    void CreateMesh(std::vector<Vertex> &&       vertices,
+    void CreateMesh(GLState &state, std::vector<Vertex> &&vertices,
                     std::vector<std::uint32_t> &&indices);
+    // Uses direct state access when available, binding to edit otherwise.
+    // Leaves the vertex array bound, the next mesh rebinds only if needed.
     void RenderMesh();
     void ClearMesh();
+
+    const std::vector<Vertex> &       GetVertices() const;
+    const std::vector<std::uint32_t> &GetIndices() const;
 };
 
 #endif
@@ -0,0 +1,126 @@
+#pragma once
+#ifndef MeshPool_hpp
+#define MeshPool_hpp
+
+#include "Vertex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+class GLState;
+
+// Where one mesh lives inside a MeshPool, in the terms of an indexed draw
+struct MeshRange
+{
+public:
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+    std::int32_t  baseVertex = 0;
+    std::uint32_t mesh       = 0; // Index in the pool, see DrawMeshBinding
+};
+
+// How one mesh's vertices are laid out, in floats. Attributes a mesh does
+// not have are -1 and read as zero.
+struct VertexLayout
+{
+public:
+    std::uint32_t stride         = 0;
+    std::int32_t  positionOffset = -1; // Three floats
+    std::int32_t  uvOffset       = -1; // Two floats
+};
+
+// The geometry of many meshes in one vertex and one index buffer, so any
+// number of them can be drawn without rebinding anything. The vertex array
+// also carries a per-instance draw ID attribute, which indirect draws point
+// at their own index through the base instance.
+//
+// Vertices are fetched one of two ways. With attributes, every mesh is
+// converted to the Vertex format so one vertex array can describe them all.
+// With vertex pulling, each mesh keeps its own layout in a shader storage
+// buffer, and the vertex shader reads its attributes by gl_VertexID, see
+// res/include/vertex_pulling.glsl. Meshes of any layout then share the same
+// multi draw.
+// Requires direct state access.
+class MeshPool
+{
+public:
+    static constexpr GLuint DrawIDAttribute = 2;
+    static constexpr GLuint DrawIDBinding   = 1;
+
+    // Storage buffer bindings for vertex pulling, after CullingPass's
+    static constexpr GLuint VertexDataBinding = 5;
+    static constexpr GLuint MeshFormatBinding = 6;
+    static constexpr GLuint DrawMeshBinding   = 7; // Pool mesh of each draw
+
+    static constexpr std::uint32_t InvalidMesh = 0xFFFFFFFF;
+
+private:
+    // One MeshFormat array element, std430
+    struct MeshFormat
+    {
+    public:
+        std::uint32_t firstFloat;
+        std::uint32_t stride;
+        std::int32_t  positionOffset;
+        std::int32_t  uvOffset;
+    };
+
+    std::vector<GLfloat>       vertexData; // Each mesh in its own layout
+    std::vector<std::uint32_t> indices;
+    std::vector<MeshRange>     ranges;
+    std::vector<MeshFormat>    formats;
+    std::vector<glm::vec4>     bounds;
+
+    GLuint   vao;
+    GLuint   vbo;
+    GLuint   ibo;
+    GLuint   formatBuffer;
+    bool     pullVertices;
+    GLState *state;
+
+    void DeleteObjects();
+    // Converts every mesh to Vertex, rebasing the ranges to match
+    std::vector<Vertex> BuildVertices();
+
+public:
+    MeshPool();
+    MeshPool(const MeshPool &other) = delete;
+    MeshPool &operator=(const MeshPool &other) = delete;
+    MeshPool(MeshPool &&other);
+    MeshPool &operator=(MeshPool &&other) = delete;
+    ~MeshPool();
+
+    // Appends the geometry and returns the mesh's index in the pool. Only
+    // takes effect on the GPU at the next CreatePool.
+    std::uint32_t AddMesh(const std::vector<Vertex> &       meshVertices,
+                          const std::vector<std::uint32_t> &meshIndices);
+    // Vertices in any layout, vertexCount of them at layout.stride floats.
+    // InvalidMesh if the layout has no stride or an attribute does not fit
+    // in it, nothing is added then.
+    std::uint32_t AddMesh(const GLfloat *meshVertices, std::size_t vertexCount,
+                          const VertexLayout &              layout,
+                          const std::vector<std::uint32_t> &meshIndices);
+
+    // Uploads everything added so far, replacing any previous buffers.
+    // Vertex pulling needs a program that pulls, such as "pulled".
+    void CreatePool(GLState &state, bool pullVertices = false);
+    void ClearPool();
+
+    // Binds the vertex array with the pool's buffers attached, and the
+    // vertex storage when pulling
+    void Bind();
+
+    const MeshRange &GetRange(std::uint32_t mesh) const;
+    // Bounding sphere in the mesh's own space, center in xyz, radius in w
+    const glm::vec4 &GetBounds(std::uint32_t mesh) const;
+    std::size_t      GetMeshCount() const;
+    GLuint           GetVertexArray() const;
+    bool             IsPullingVertices() const;
+};
+
+#endif
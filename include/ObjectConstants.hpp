@@ -0,0 +1,33 @@
+#pragma once
+#ifndef ObjectConstants_hpp
+#define ObjectConstants_hpp
+
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Per-draw uniform block, see res/include/object_constants.glsl. Each draw
+// binds its own slice of the frame's UniformRing at this binding.
+constexpr const char *ObjectConstantsBlock   = "ObjectConstants";
+constexpr GLuint      ObjectConstantsBinding = 1;
+
+// Indirect passes read every draw's constants from one shader storage
+// buffer instead, see res/include/object_data.glsl
+constexpr GLuint ObjectDataBinding = 0;
+
+// Matches the std140 layout of the ObjectConstants block exactly, and the
+// std430 layout of one ObjectData array element
+struct ObjectConstants
+{
+public:
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+static_assert(offsetof(ObjectConstants, color) == 64,
+              "ObjectConstants does not match the std140 block layout");
+static_assert(sizeof(ObjectConstants) == 80,
+              "ObjectConstants does not match the std140 block layout");
+
+#endif
@@ -11,6 +11,22 @@ void GLCheckError(const char *func, const char *file, int line);
 
 void PrintGLError(GLenum errorCode);
 
+// GL 4.5 or ARB_direct_state_access, objects can be edited without binding
+bool HasDirectStateAccess();
+
+// GL 4.3 or the multi draw indirect and shader storage buffer extensions
+bool HasMultiDrawIndirect();
+
+// GL 4.3 or ARB_compute_shader
+bool HasComputeShaders();
+
+// GL 4.6 or ARB_indirect_parameters, the draw count can come from a buffer
+bool HasIndirectParameters();
+
+// ARB_parallel_shader_compile, compile status can be polled. GLEW 2.1 has
+// no KHR_ spelling of it.
+bool HasParallelShaderCompile();
+
 // Only enable this call if we are in debug mode
 #ifndef NDEBUG
 // Debug mode
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ProgramBinaryCache_hpp
+#define ProgramBinaryCache_hpp
+
+#include "ShaderSource.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include <GL/glew.h>
+
+struct ProgramBinaryStats
+{
+public:
+    std::size_t loaded   = 0; // Programs that skipped compiling
+    std::size_t stored   = 0; // Programs compiled and written out
+    std::size_t rejected = 0; // Binaries the driver would not take
+};
+
+// Linked programs saved with glGetProgramBinary, one file per program
+// named after it. Each entry is keyed by a hash of the program's shadelet
+// types and sources, and of the driver's vendor, renderer and version, so
+// changing any of them invalidates it and the next Store replaces it. A
+// binary the driver rejects is deleted and the program compiled as usual.
+// Requires GL 4.1 or ARB_get_program_binary, and a current context.
+class ProgramBinaryCache
+{
+private:
+    std::filesystem::path directory;
+    std::uint64_t         driverHash;
+    bool                  supported;
+    ProgramBinaryStats    stats;
+
+    std::filesystem::path EntryPath(const ShaderSource &source) const;
+    std::uint64_t         ComputeKey(const ShaderSource &source) const;
+
+public:
+    ProgramBinaryCache(std::filesystem::path directory);
+    ~ProgramBinaryCache();
+
+    // False when the driver offers no binary formats, every call is then a
+    // miss and nothing is written
+    bool IsSupported() const;
+
+    // Call before linking a program that will be stored
+    void PrepareProgram(GLuint program);
+
+    // Loads the binary into the program, returns false on a miss. The
+    // program is then still empty and may be compiled as usual.
+    bool Load(const ShaderSource &source, GLuint program);
+    // Saves a linked program, replacing whatever entry it had
+    void Store(const ShaderSource &source, GLuint program);
+
+    const ProgramBinaryStats &GetStats() const;
+};
+
+#endif
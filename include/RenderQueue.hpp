@@ -0,0 +1,101 @@
+#pragma once
+#ifndef RenderQueue_hpp
+#define RenderQueue_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class RenderPass : std::uint8_t
+{
+    Opaque      = 0,
+    Transparent = 1,
+    Overlay     = 2
+};
+
+// A single draw, ordered by its key alone
+struct RenderPacket
+{
+public:
+    std::uint64_t key;
+    std::uint32_t shaderIndex; // Index into the compiled shaders
+    std::uint32_t meshIndex;   // Index into the scene's meshes
+    std::uint32_t objectIndex; // Index of the per-object data (model matrix)
+};
+
+struct RenderQueueStats
+{
+public:
+    std::size_t draws          = 0;
+    std::size_t programChanges = 0;
+    std::size_t meshChanges    = 0;
+};
+
+// Collects the visible draws of a frame, sorts them by a packed 64-bit key
+// and hands them back in order. Key layout, most significant bit first:
+//
+//  Opaque:      pass:2 | 0:1 | program:12 | material:12 | mesh:16 | depth:21
+//  Transparent: pass:2 | 1:1 | ~depth:21 | program:12 | material:12 | mesh:16
+//
+// So opaque draws are grouped by state and then go front to back, while
+// transparent ones go strictly back to front.
+class RenderQueue
+{
+public:
+    static constexpr std::uint32_t MaxPrograms  = 1u << 12;
+    static constexpr std::uint32_t MaxMaterials = 1u << 12;
+    static constexpr std::uint32_t MaxMeshes    = 1u << 16;
+    static constexpr std::uint32_t MaxDepth     = (1u << 21) - 1;
+
+private:
+    std::vector<RenderPacket> packets;
+    std::vector<RenderPacket> scratch;
+
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+    // Depth is the view distance normalized into [0, 1], usually
+    // (distance - near) / (far - near)
+    static std::uint64_t MakeKey(RenderPass pass, bool translucent,
+                                 std::uint32_t program, std::uint32_t material,
+                                 std::uint32_t mesh, float depth);
+
+    void Clear();
+    void Push(std::uint64_t key, std::uint32_t shaderIndex,
+              std::uint32_t meshIndex, std::uint32_t objectIndex);
+
+    // LSD radix sort, one byte per pass. Passes where every key has the
+    // same byte are skipped, which is most of them for small scenes.
+    void Sort();
+
+    std::vector<RenderPacket> const &GetPackets() const;
+    // The state changes of the packets in their current order. Counted on
+    // every call, so not meant to be called every frame.
+    RenderQueueStats GetStats() const;
+
+    // Calls draw(packet, programChanged) for every packet in order, where
+    // programChanged is true whenever the packet's shader differs from the
+    // previous one's
+    template <typename DrawFunc>
+    void Submit(DrawFunc &&draw) const
+    {
+        SubmitRange(0, packets.size(), draw);
+    }
+
+    // Submits the packets in [begin, end) only. The first packet's shader is
+    // compared against the packet before the range, so ranges submitted in
+    // order behave exactly like a single Submit.
+    template <typename DrawFunc>
+    void SubmitRange(std::size_t begin, std::size_t end, DrawFunc &&draw) const
+    {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            bool programChanged =
+                i == 0 || packets[i - 1].shaderIndex != packets[i].shaderIndex;
+            draw(packets[i], programChanged);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef RenderTarget_hpp
+#define RenderTarget_hpp
+
+#include <GL/glew.h>
+
+class GLState;
+
+// An offscreen framebuffer with a color and a depth texture, for passes
+// that need to read the depth of what was drawn, such as HiZBuffer.
+// Requires direct state access.
+class RenderTarget
+{
+private:
+    GLuint   framebuffer;
+    GLuint   colorTexture;
+    GLuint   depthTexture;
+    GLsizei  width;
+    GLsizei  height;
+    GLState *state;
+
+public:
+    RenderTarget();
+    RenderTarget(const RenderTarget &other) = delete;
+    RenderTarget &operator=(const RenderTarget &other) = delete;
+    RenderTarget(RenderTarget &&other)                 = delete;
+    RenderTarget &operator=(RenderTarget &&other) = delete;
+    ~RenderTarget();
+
+    // Returns false if the framebuffer is incomplete
+    bool CreateTarget(GLState &state, GLsizei width, GLsizei height);
+    void ClearTarget();
+
+    // Draws go to the target until another framebuffer is bound
+    void Bind();
+    // Copies the color to the default framebuffer, scaled to fit
+    void BlitToScreen(GLsizei screenWidth, GLsizei screenHeight);
+
+    GLuint  GetFramebuffer() const;
+    GLuint  GetColorTexture() const;
+    GLuint  GetDepthTexture() const;
+    GLsizei GetWidth() const;
+    GLsizei GetHeight() const;
+};
+
+#endif
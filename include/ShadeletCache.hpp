@@ -0,0 +1,71 @@
+#pragma once
+#ifndef ShadeletCache_hpp
+#define ShadeletCache_hpp
+
+#include "ShadeletSource.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+struct ShadeletCacheStats
+{
+public:
+    std::size_t compiled = 0; // Shader objects created
+    std::size_t reused   = 0; // Acquires answered by an existing one
+};
+
+// Compiled shader objects shared between programs. Shadelets with the same
+// type and the same text, after '#include' expansion and any '#define's,
+// are compiled once and attached to every program that uses them. Each
+// Acquire takes a reference and each Release drops one, the shader object
+// is deleted with the last.
+class ShadeletCache
+{
+private:
+    struct Key
+    {
+    public:
+        GLenum        type;
+        std::uint64_t sourceHash;
+
+        bool operator==(const Key &other) const;
+    };
+
+    struct KeyHash
+    {
+    public:
+        std::size_t operator()(const Key &key) const;
+    };
+
+    struct Entry
+    {
+    public:
+        Key         key;
+        std::size_t references;
+    };
+
+    std::unordered_map<Key, GLuint, KeyHash> shaders;
+    std::unordered_map<GLuint, Entry>        entries;
+    ShadeletCacheStats                       stats;
+
+public:
+    ShadeletCache();
+    ShadeletCache(const ShadeletCache &other) = delete;
+    ShadeletCache &operator=(const ShadeletCache &other) = delete;
+    ~ShadeletCache();
+
+    // The shader object for this shadelet, submitted for compiling when it
+    // is new. Its status is only known once the driver is done with it.
+    GLuint Acquire(const ShadeletSource &source);
+    void   Release(GLuint shader);
+    // Deletes every shader object, referenced or not
+    void Clear();
+
+    std::size_t               GetSize() const;
+    const ShadeletCacheStats &GetStats() const;
+};
+
+#endif
@@ -2,25 +2,51 @@
 #ifndef ShadeletSource_hpp
 #define ShadeletSource_hpp
 
+#include "SourceStore.hpp"
+
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+// One stage of a program. The text lives in SourceStore::Shared and the
+// paths are interned there, so shadelets are cheap to copy and identical
+// ones share their text.
 class ShadeletSource
 {
   private:
-    std::string source;
-    GLenum      type;
-    std::string fullPath;
+    SourceText    source;
+    GLenum        type;
+    std::uint32_t fullPath; // See SourceStore::Intern
+    // The file of each '#line' source string number, see ShaderPreprocessor
+    std::vector<std::uint32_t> sourceFiles;
 
   public:
-    ShadeletSource(std::string source, GLenum type, std::string fullPath);
+    ShadeletSource(std::string_view source, GLenum type,
+                   std::string_view           fullPath,
+                   std::vector<std::uint32_t> sourceFiles = {});
+    ShadeletSource(const ShadeletSource &other) = default;
+    ShadeletSource &operator=(const ShadeletSource &other) = default;
+    ShadeletSource(ShadeletSource &&other)                 = default;
+    ShadeletSource &operator=(ShadeletSource &&other) = default;
     ~ShadeletSource();
 
-    const std::string &GetFullPath() const;
-    const std::string &GetSource() const;
-    GLenum             GetType() const;
+    // The same shadelet with other text, for the same files
+    ShadeletSource WithSource(std::string_view newSource) const;
+
+    std::string_view GetFullPath() const;
+    std::string_view GetSource() const;
+    // HashText of the source, worked out once when it was stored
+    std::uint64_t GetSourceHash() const;
+    GLenum        GetType() const;
+
+    // SourceStore::Intern IDs of the paths
+    const std::vector<std::uint32_t> &GetSourceFiles() const;
+    // Names the files in a compiler log by their source string numbers
+    std::string DescribeLog(const std::string &log) const;
 };
 
 #endif
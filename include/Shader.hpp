@@ -2,37 +2,188 @@
 #ifndef shader_hpp
 #define shader_hpp
 
+#include "FlatHashMap.hpp"
+#include "GLState.hpp"
 #include "ShaderSource.hpp"
+#include "StringHash.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+class ProgramBinaryCache;
+class ShadeletCache;
+
+// What the linker kept of a program's interface, read once after linking
+struct UniformInfo
+{
+public:
+    std::string name;
+    GLint       location;   // -1 for members of a uniform block
+    GLenum      type;
+    GLint       size;       // Array length, 1 for non-arrays
+    GLint       blockIndex; // -1 outside of uniform blocks
+
+    // Where the last uploaded value lives in the program's shadow copy.
+    // Block members and unknown types have no shadow.
+    std::uint32_t shadowOffset = 0;
+    std::uint32_t shadowSize   = 0;
+};
+
+struct UniformStats
+{
+public:
+    std::size_t uploads = 0;
+    std::size_t skipped = 0; // Same value as last time, not uploaded
+};
+
+// Uniform blocks, and shader storage blocks
+struct UniformBlockInfo
+{
+public:
+    std::string name;
+    GLuint      index;
+    GLint       binding;
+    GLint       dataSize;
+};
+
+struct AttributeInfo
+{
+public:
+    std::string name;
+    GLint       location;
+    GLenum      type;
+    GLint       size;
+};
+
+// A program handed to the driver and not finished yet, see
+// Shader::SubmitProgram
+struct PendingShader
+{
+public:
+    const ShaderSource *source  = nullptr;
+    GLuint              program = 0;
+    bool                cached  = false; // Loaded from a binary
+    std::vector<GLuint> shadelets;       // Attached, released once linked
+};
 
 class Shader
 {
 private:
-    GLuint program;
+    GLuint      program;
+    std::string name;
+
+    std::vector<UniformInfo>      uniforms;
+    std::vector<UniformBlockInfo> uniformBlocks;
+    std::vector<UniformBlockInfo> storageBlocks;
+    std::vector<AttributeInfo>    attributes;
+    GLint                         workGroupSize[3];
+
+    // HashName of each name to its index in the vectors above
+    FlatHashMap<std::uint32_t> uniformLookup;
+    FlatHashMap<std::uint32_t> uniformBlockLookup;
+    FlatHashMap<std::uint32_t> storageBlockLookup;
+    FlatHashMap<std::uint32_t> attributeLookup;
+
+    // Last value uploaded to each uniform, and whether there has been one
+    std::vector<std::uint8_t> shadowValues;
+    std::vector<bool>         shadowValid;
+    UniformStats              uniformStats;
 
     static std::unique_ptr<std::string>
-        CompileShadelet(const ShadeletSource &shadeletSource, GLuint &id);
+        ShadeletError(const ShadeletSource &shadeletSource, GLuint id);
+
+    static void BindSharedUniformBlocks(GLuint programID);
+
+    // Programs loaded from a binary have no shaders attached to ask
+    void Reflect(bool compute);
+    void ReflectProgramInterface();
+    void ReflectActiveQueries();
+    void BuildLookups();
+    void AllocateShadows();
+
+    GLint ShadowUniform(std::uint32_t nameHash, const void *value,
+                        std::size_t size);
 
     Shader(GLuint programID);
 
 public:
     ~Shader();
 
+    // Programs with an entry in binaryCache are loaded instead of compiled,
+    // the others are compiled and stored in it. Shadelets come from
+    // shadeletCache, or from one that only lasts this call.
     static std::unique_ptr<std::vector<Shader>>
         CompileShaders(const std::vector<ShaderSource> &          sources,
-                       std::unique_ptr<std::vector<std::string>> &errors);
+                       std::unique_ptr<std::vector<std::string>> &errors,
+                       ProgramBinaryCache *binaryCache   = nullptr,
+                       ShadeletCache *     shadeletCache = nullptr);
+
+    // Compilation split in three, so programs can be queued and picked up
+    // later without waiting on the driver. SubmitProgram compiles and links
+    // without asking how either went, or loads a cached binary. Once
+    // IsProgramReady, FinishProgram reflects the program, or deletes it and
+    // reports why it failed. The source must outlive the PendingShader.
+    static PendingShader SubmitProgram(const ShaderSource &source,
+                                       ProgramBinaryCache *binaryCache,
+                                       ShadeletCache &     shadeletCache);
+    static bool          IsProgramReady(const PendingShader &pending);
+    static std::optional<Shader>
+        FinishProgram(const PendingShader &                       pending,
+                      std::unique_ptr<std::vector<std::string>> &errors,
+                      ProgramBinaryCache *                       binaryCache,
+                      ShadeletCache &                            shadeletCache);
+
+    // Returns the index of the shader with this name, or -1 if it did not
+    // compile
+    static long FindShader(const std::vector<Shader> &shaders,
+                           const std::string &        name);
+
+    GLuint             GetProgram();
+    const std::string &GetName() const;
+
+    void SetInUse(GLState &state);
+
+    // Cached at link time, neither of these asks OpenGL anything
+    GLint GetUniformLocation(std::uint32_t nameHash) const;
+    GLint GetUniformLocation(const std::string &uniformName) const;
+
+    const UniformInfo *     FindUniform(std::uint32_t nameHash) const;
+    const UniformBlockInfo *FindUniformBlock(std::uint32_t nameHash) const;
+    const UniformBlockInfo *FindStorageBlock(std::uint32_t nameHash) const;
+    const AttributeInfo *   FindAttribute(std::uint32_t nameHash) const;
+
+    const std::vector<UniformInfo> &     GetUniforms() const;
+    const std::vector<UniformBlockInfo> &GetUniformBlocks() const;
+    const std::vector<UniformBlockInfo> &GetStorageBlocks() const;
+    const std::vector<AttributeInfo> &   GetAttributes() const;
+
+    // Compute programs only, all zero otherwise
+    const GLint *GetWorkGroupSize() const;
+    bool         IsCompute() const;
 
-    GLuint GetProgram();
+    // Runs a compute program, which must be in use. Storage buffers are
+    // bound with GLState::BindBufferBase, and written results need a
+    // glMemoryBarrier before anything reads them.
+    void Dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1);
 
-    void SetInUse();
+    // The program must be in use. Names are hashed with HashName, ideally
+    // at compile time. Uniforms the program does not have are ignored, and
+    // so are values equal to the last one uploaded.
+    void SetUniform(std::uint32_t nameHash, int value);
+    void SetUniform(std::uint32_t nameHash, float value);
+    void SetUniform(std::uint32_t nameHash, const glm::vec2 &value);
+    void SetUniform(std::uint32_t nameHash, const glm::vec3 &value);
+    void SetUniform(std::uint32_t nameHash, const glm::vec4 &value);
+    void SetUniform(std::uint32_t nameHash, const glm::mat4 &value);
 
-    GLint GetUniformLocation(const std::string &uniformName);
+    const UniformStats &GetUniformStats() const;
 };
 
 #endif
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef ShaderBundle_hpp
+#define ShaderBundle_hpp
+
+#include "ShaderSource.hpp"
+
+#include <filesystem>
+#include <vector>
+
+// Every program, already expanded and with its keyword variants, in one
+// zlib compressed file. Made offline by shader_bundle (tools/), so loading
+// it parses no manifests and expands no includes. The files it was built
+// from, and the list of manifests in the shader directory, are only
+// hashed, to notice when the bundle is out of date.
+//
+// The file is a small header and a compressed index of programs, keywords,
+// variants, shadelets and source files, followed by each distinct source
+// text once.
+// A program's own shadelets are its mask 0 variant, the others are added
+// with ShaderSource::AddVariant.
+class ShaderBundle
+{
+public:
+    // The sources as read from the shader directory. False if the file
+    // could not be written.
+    static bool Write(const std::filesystem::path &    path,
+                      const std::filesystem::path &    shaderDirectory,
+                      const std::vector<ShaderSource> &sources);
+    // Appends the bundle's programs to sources. False if the file is
+    // missing, from another version or damaged, or if a file it was built
+    // from has changed since or manifests were added to or removed from
+    // the shader directory, sources are then unchanged. Without a shader
+    // directory the bundle is used as it is.
+    static bool Read(const std::filesystem::path &path,
+                     const std::filesystem::path &shaderDirectory,
+                     std::vector<ShaderSource> &  sources);
+};
+
+#endif
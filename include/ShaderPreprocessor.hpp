@@ -0,0 +1,106 @@
+#pragma once
+#ifndef ShaderPreprocessor_hpp
+#define ShaderPreprocessor_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ShaderPreprocessorStats
+{
+public:
+    std::size_t parsed = 0; // Files read from disk
+    std::size_t reused = 0; // Reads answered by an already parsed copy
+};
+
+// Expands '#include "file"' in shadelet sources. Files are looked up next to
+// the including file first, then next to the manifest. Each file is parsed
+// once and kept, however many shadelets include it, and '#pragma once'
+// files are only pasted once per shadelet.
+//
+// The output carries '#line' directives, so errors point at the right line.
+// The source string number of each '#line' indexes the list of files the
+// shadelet was built from, the first being the shadelet's own file.
+//
+// Every file a program was built from is recorded, so the programs a file
+// change affects can be looked up without reading anything again.
+class ShaderPreprocessor
+{
+public:
+    // How deep '#include's may nest before giving up
+    static constexpr int MaxIncludeDepth = 16;
+
+private:
+    // A file split at its '#include' lines. There is one more chunk than
+    // there are includes, the text before, between and after them.
+    struct ParsedFile
+    {
+    public:
+        std::vector<std::string> chunks;
+        std::vector<std::string> includes;     // As written
+        std::vector<std::size_t> includeLines; // Line each include is on
+        bool                     once = false; // Had '#pragma once'
+        std::uint32_t            id   = 0;     // Path's SourceStore::Intern ID
+    };
+
+    // Keyed by Normalize. The dependency graph is kept both ways, the
+    // programs of each file and the files of each program. Programs are
+    // known by their SourceStore::Intern ID.
+    using ProgramSet = std::unordered_set<std::uint32_t>;
+    std::unordered_map<std::string, ParsedFile>                 files;
+    std::unordered_map<std::string, ProgramSet>                 dependents;
+    std::unordered_map<std::uint32_t, std::vector<std::string>> dependencies;
+    ShaderPreprocessorStats                                     stats;
+
+    const ParsedFile *Parse(const std::string &path);
+    bool              Expand(const std::string &              path,
+                             const std::filesystem::path &    manifestDirectory,
+                             std::uint32_t                    program,
+                             std::string &                    contents,
+                             std::vector<std::uint32_t> &     sourceFiles,
+                             std::unordered_set<std::string> &pasted,
+                             int                              depth);
+    // AddDependency of an already normalized path
+    void Depend(const std::string &path, std::uint32_t program);
+
+public:
+    ShaderPreprocessor();
+    ~ShaderPreprocessor();
+
+    // The path every file is known by, absolute and without '..'
+    static std::string Normalize(const std::filesystem::path &path);
+    // The whole file in one read
+    static bool ReadFile(const std::filesystem::path &path,
+                         std::string &                contents);
+
+    // Reads the file with its includes expanded. sourceFiles receives the
+    // file each source string number stands for, as SourceStore::Intern
+    // IDs. Every file reached is
+    // recorded as a dependency of the program, even when it fails.
+    bool Process(const std::filesystem::path &path,
+                 const std::filesystem::path &manifestDirectory,
+                 const std::string &program, std::string &contents,
+                 std::vector<std::uint32_t> &sourceFiles);
+
+    // Records that the program was built from the file
+    void AddDependency(const std::filesystem::path &file,
+                       const std::string &          program);
+    // Names of the programs built from the file, directly or through an
+    // include
+    std::vector<std::string>
+         GetDependents(const std::filesystem::path &file) const;
+    bool IsDependency(const std::filesystem::path &file) const;
+
+    // Drops the parsed copy, the next Process reads the file again
+    void Invalidate(const std::filesystem::path &file);
+    // Forgets every dependency of the program, before it is read again
+    void ForgetProgram(const std::string &program);
+
+    const ShaderPreprocessorStats &GetStats() const;
+};
+
+#endif
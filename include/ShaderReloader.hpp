@@ -0,0 +1,89 @@
+#pragma once
+#ifndef ShaderReloader_hpp
+#define ShaderReloader_hpp
+
+#include "Shader.hpp"
+#include "ShaderSource.hpp"
+#include "ShaderWatcher.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <vector>
+
+class GLState;
+class ProgramBinaryCache;
+class ShadeletCache;
+class ShaderPreprocessor;
+class ShaderVariants;
+
+struct ShaderReloadStats
+{
+public:
+    std::size_t reloaded = 0;
+    std::size_t failed   = 0; // The old program was kept
+};
+
+// Rebuilds programs while the game runs, whenever a file they were built
+// from is written. The ShaderPreprocessor's record of those files says which
+// programs a change affects, only their manifests are read again.
+//
+// Rebuilds are submitted together and finished as the driver completes
+// them, without waiting. A program that built replaces the old one between
+// two frames, in place, so indices and pointers into the programs stay
+// valid. One that failed is reported and the old one is kept.
+class ShaderReloader
+{
+private:
+    struct Reload
+    {
+    public:
+        std::size_t                           sourceIndex;
+        std::size_t                           shaderIndex;
+        ShaderSource                          source;
+        PendingShader                         pending;
+        std::chrono::steady_clock::time_point start;
+        bool                                  superseded = false;
+    };
+
+    GLState &                  state;
+    std::vector<ShaderSource> &sources;
+    std::vector<Shader> &      shaders;
+    ShaderPreprocessor &       preprocessor;
+    ProgramBinaryCache *       binaryCache;
+    ShadeletCache &            shadeletCache;
+    ShaderVariants *           variants;
+
+    ShaderWatcher     watcher;
+    std::list<Reload> reloads; // Never moved, pending sources point in
+    ShaderReloadStats stats;
+
+    void Submit(std::size_t sourceIndex, std::size_t shaderIndex);
+    void Finish(Reload &reload);
+
+public:
+    // Programs are matched to their sources by name. Any variants are
+    // invalidated along with their program.
+    ShaderReloader(GLState &                  state,
+                   std::vector<ShaderSource> &sources,
+                   std::vector<Shader> &      shaders,
+                   ShaderPreprocessor &       preprocessor,
+                   ProgramBinaryCache *       binaryCache,
+                   ShadeletCache &            shadeletCache,
+                   ShaderVariants *           variants = nullptr);
+    ShaderReloader(const ShaderReloader &other) = delete;
+    ShaderReloader &operator=(const ShaderReloader &other) = delete;
+    ~ShaderReloader();
+
+    bool Watch(const std::string &directory);
+
+    // Starts rebuilding whatever changed and swaps in whatever is done.
+    // Call it once a frame, between frames.
+    void Update();
+
+    std::size_t              GetPendingCount() const;
+    const ShaderReloadStats &GetStats() const;
+};
+
+#endif
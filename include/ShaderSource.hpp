@@ -2,37 +2,108 @@
 #ifndef ShaderSource_hpp
 #define ShaderSource_hpp
 
+#include "ManifestIndex.hpp"
 #include "ShadeletSource.hpp"
+#include "ShaderPreprocessor.hpp"
 
+#include <cstdint>
+#include <filesystem>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+class JobSystem;
+
 class ShaderSource
 {
+  public:
+    // The shadelets of one keyword variant, by mask
+    using Variant = std::pair<std::uint32_t, std::vector<ShadeletSource>>;
+
   private:
-    std::string                 name;
+    std::uint32_t               nameID; // See SourceStore::Intern
     std::vector<ShadeletSource> shadelets;
+    std::vector<std::string>    keywords;
+    std::string                 manifestPath;
+    std::vector<Variant>        variants; // Built ahead of time
+
+    // False if it is not a shader manifest or could not be parsed. The path
+    // is only filled in for shaders and files that are not shaders.
+    static bool ParseManifest(std::filesystem::path const &path,
+                              ShaderManifest &             manifest);
+    static std::optional<ShaderSource>
+        BuildSource(ShaderManifest const &manifest,
+                    ShaderPreprocessor &  preprocessor);
 
     static bool HasEnding(std::string const &fullString,
                           std::string const &ending);
 
     static bool GetShaderType(std::string const &typeString, GLenum &type);
 
+    // Adds a '#define' for each keyword right after the '#version' line
+    static std::string InjectDefines(std::string_view                source,
+                                     std::vector<std::string> const &defines);
+
   public:
-    ShaderSource(std::string name);
+    // Each keyword is one bit of a variant mask
+    static constexpr std::size_t MaxKeywords = 16;
+
+    ShaderSource(std::string_view name);
+    ShaderSource(const ShaderSource &other) = default;
+    ShaderSource &operator=(const ShaderSource &other) = default;
+    ShaderSource(ShaderSource &&other)                 = default;
+    ShaderSource &operator=(ShaderSource &&other) = default;
     ~ShaderSource();
 
     const std::string &GetName() const;
+    std::uint32_t      GetNameID() const;
+    // The JSON file the program was declared in
+    const std::string &GetManifestPath() const;
 
+    // Shadelets are expanded by the preprocessor, which also records what
+    // each program was built from. Without one, a temporary one is used.
+    // With jobs, directories are walked and manifests parsed in parallel.
+    // With an index, unchanged manifests are taken from it instead of being
+    // parsed, and it is brought up to date afterwards.
     static std::vector<ShaderSource>
-        ReadShaderSources(std::string directoryPath);
+        ReadShaderSources(std::string         directoryPath,
+                          ShaderPreprocessor *preprocessor = nullptr,
+                          JobSystem *         jobs         = nullptr,
+                          ManifestIndex *     index        = nullptr);
+    // Every .json below the directory, sorted, walked in parallel with jobs
+    static std::vector<std::filesystem::path>
+        FindManifests(std::string const &directoryPath,
+                      JobSystem *        jobs = nullptr);
+    // Reads one manifest, nothing if it is not a shader or any part of it
+    // could not be read
+    static std::optional<ShaderSource>
+        ReadManifest(std::filesystem::path const &path,
+                     ShaderPreprocessor &         preprocessor);
 
     void AddShadelet(ShadeletSource shadelet);
+    bool AddKeyword(std::string keyword);
+
+    // A variant built ahead of time, as in a ShaderBundle. WithKeywords
+    // returns its shadelets as they are instead of adding '#define's.
+    void AddVariant(std::uint32_t mask, std::vector<ShadeletSource> shadelets);
+
+    // The program with a '#define' for every keyword whose bit is set, each
+    // only in the shadelets that mention it. Mask 0 is the program itself.
+    ShaderSource WithKeywords(std::uint32_t mask) const;
+    // The program, its keywords and manifest with other shadelets, such as
+    // stripped ones, and no variants
+    ShaderSource WithShadelets(std::vector<ShadeletSource> newShadelets) const;
 
     std::vector<ShadeletSource> const &GetShadelets() const;
+    bool                               HasStage(GLenum type) const;
+    std::vector<std::string> const &   GetKeywords() const;
+    std::vector<Variant> const &       GetVariants() const;
+    // The bit of this keyword, 0 if the program does not have it
+    std::uint32_t GetKeywordBit(std::string const &keyword) const;
 };
 
 #endif
@@ -0,0 +1,118 @@
+#pragma once
+#ifndef ShaderVariants_hpp
+#define ShaderVariants_hpp
+
+#include "Shader.hpp"
+#include "ShaderSource.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class GLState;
+class ProgramBinaryCache;
+class ShadeletCache;
+
+// The keyword variants of every program, built only once something asks for
+// them. Each "keywords" entry of a manifest is one bit of a variant mask, in
+// the order listed, and mask 0 is the program CompileShaders built.
+//
+// A variant is compiled on first use, which waits on the driver, or ahead of
+// time from the warm-up queue, which Update works through without waiting.
+// Both go through the ProgramBinaryCache when there is one. Finding a
+// variant is one index, built or not.
+class ShaderVariants
+{
+private:
+    enum class VariantState : std::uint8_t
+    {
+        Missing,
+        Queued,
+        Compiling,
+        Ready,
+        Failed
+    };
+
+    // One program and every variant it could have, indexed by mask
+    struct Family
+    {
+    public:
+        const ShaderSource *      source;
+        std::vector<Shader *>     shaders; // Null until ready
+        std::vector<VariantState> states;
+    };
+
+    // Family of a variant slot that is free for Submit to reuse
+    static constexpr std::size_t NoFamily = ~std::size_t(0);
+
+    // A variant built here, its source has to outlive the pending compile
+    struct Variant
+    {
+    public:
+        ShaderSource          source;
+        PendingShader         pending;
+        std::optional<Shader> shader;
+        std::size_t           family;
+        std::uint32_t         mask;
+    };
+
+    std::vector<Family>                               families;
+    std::deque<Variant>                               variants; // Never moved
+    std::vector<std::size_t>                          freeVariants;
+    std::deque<std::pair<std::size_t, std::uint32_t>> warmQueue;
+    std::vector<std::size_t>                          compiling; // Variants
+
+    ProgramBinaryCache *binaryCache;
+    ShadeletCache *     shadeletCache;
+
+    // Both take and return indices into variants. Submit wants a variant
+    // that is Missing or Queued, Finish one that is Compiling.
+    std::size_t Submit(std::size_t family, std::uint32_t mask);
+    Shader *    Finish(std::size_t index);
+    // Drops the variant's source and hands its slot back, for one that
+    // failed or whose program is deleted
+    void Release(std::size_t index);
+
+public:
+    // The sources and the programs CompileShaders built from them, both must
+    // outlive this
+    ShaderVariants(const std::vector<ShaderSource> &sources,
+                   std::vector<Shader> &            shaders,
+                   ProgramBinaryCache *             binaryCache,
+                   ShadeletCache &                  shadeletCache);
+    ShaderVariants(const ShaderVariants &other) = delete;
+    ShaderVariants &operator=(const ShaderVariants &other) = delete;
+    ~ShaderVariants();
+
+    // Returns the family of the program with this name, or -1 if there is
+    // none
+    long FindFamily(const std::string &name) const;
+    // Keywords the program does not have are left out
+    std::uint32_t GetMask(long                            family,
+                          const std::vector<std::string> &keywords) const;
+
+    // The variant, compiled now if it has not been. Null if it failed.
+    Shader *GetVariant(long family, std::uint32_t mask);
+    // The variant if it is ready, otherwise it is queued and this returns
+    // null, so the caller can fall back to another until then
+    Shader *TryGetVariant(long family, std::uint32_t mask);
+    // Queues the variant to be built by Update
+    void Warm(long family, std::uint32_t mask);
+
+    // Deletes every variant built so far, after the program's source has
+    // changed. Its keywords may have too.
+    void Invalidate(long family, GLState &state);
+
+    // Submits up to maxSubmits queued variants and finishes any the driver
+    // is done with. Never waits, call it once a frame.
+    void Update(std::size_t maxSubmits = 4);
+
+    std::size_t GetQueuedCount() const;
+    std::size_t GetBuiltCount() const;
+};
+
+#endif
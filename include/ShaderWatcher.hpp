@@ -0,0 +1,35 @@
+#pragma once
+#ifndef ShaderWatcher_hpp
+#define ShaderWatcher_hpp
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Watches directory trees for files that are written, with inotify, so
+// changes are known without scanning anything. Directories created later
+// are watched too. Only implemented on Linux, elsewhere Watch fails.
+class ShaderWatcher
+{
+private:
+    int                                  fd;
+    std::unordered_map<int, std::string> directories; // By watch descriptor
+
+    bool WatchDirectory(const std::string &directory);
+
+public:
+    ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher &other) = delete;
+    ShaderWatcher &operator=(const ShaderWatcher &other) = delete;
+    ~ShaderWatcher();
+
+    // The directory and everything below it
+    bool Watch(const std::string &directory);
+    bool IsWatching() const;
+
+    // Every file written since the last call, once each, as
+    // ShaderPreprocessor::Normalize names them. Never waits.
+    std::vector<std::string> Poll();
+};
+
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef SourceStore_hpp
+#define SourceStore_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Text kept by a SourceStore, with its HashText. Copies share the stored
+// text, which is released once the last of them is gone.
+class SourceText
+{
+private:
+    friend class SourceStore;
+    struct Stored
+    {
+    public:
+        std::string   text;
+        std::uint64_t hash = 0;
+    };
+    std::shared_ptr<const Stored> stored;
+
+public:
+    std::string_view GetText() const;
+    std::uint64_t    GetHash() const;
+};
+
+struct SourceStoreStats
+{
+public:
+    std::size_t stored   = 0; // Texts copied into the store
+    std::size_t shared   = 0; // Texts answered by an identical stored one
+    std::size_t released = 0; // Stored texts nothing held any more
+    std::size_t bytes    = 0; // Bytes of the texts held now
+};
+
+// Shader sources, each distinct text stored once. Thousands of variants
+// built from the same files then point at the same bytes, and copying a
+// shadelet copies no text. A text is dropped with the last SourceText
+// holding it, so a reloaded program's old sources go with the program.
+//
+// Names and paths are interned separately, each distinct one gets an ID
+// and is kept for good.
+//
+// There is one store for the whole process, see Shared. Safe to use from
+// any thread.
+class SourceStore
+{
+private:
+    struct Entry
+    {
+    public:
+        // Valid while the entry exists, Release erases it before the text
+        // is deleted
+        const SourceText::Stored *              text;
+        std::weak_ptr<const SourceText::Stored> handle;
+    };
+
+    // By hash, more than one text in the unlikely case hashes collide
+    std::unordered_multimap<std::uint64_t, Entry>       texts;
+    std::deque<std::string>                             names;
+    std::unordered_map<std::string_view, std::uint32_t> nameIDs;
+    SourceStoreStats                                    stats;
+    mutable std::mutex                                  mutex;
+
+    void Release(const SourceText::Stored *text);
+
+public:
+    SourceStore();
+    SourceStore(const SourceStore &other) = delete;
+    SourceStore &operator=(const SourceStore &other) = delete;
+    ~SourceStore();
+
+    static SourceStore &Shared();
+
+    // The stored copy of the text, the same one for identical texts
+    SourceText Add(std::string_view text);
+
+    // The ID of the name, the same one every time it is interned
+    std::uint32_t Intern(std::string_view name);
+    // The name of an ID from Intern
+    const std::string &GetName(std::uint32_t id) const;
+
+    SourceStoreStats GetStats() const;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef SpatialGrid_hpp
+#define SpatialGrid_hpp
+
+#include "Frustum.hpp"
+#include "JobSystem.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// A loose, hashed uniform grid for large numbers of moving objects.
+// Objects are binned by their center only, so a cell's loose bounds are its
+// bounds grown by half a cell, and any object with a radius up to half a
+// cell fits. Larger objects are kept in a separate list that every query
+// checks. Cells are hashed, so the world is unbounded.
+class SpatialGrid
+{
+public:
+    using ObjectID = std::uint32_t;
+
+    static constexpr ObjectID InvalidID = 0xFFFFFFFF;
+
+private:
+    static constexpr std::uint32_t OversizedCell = 0xFFFFFFFF;
+
+    struct GridCell
+    {
+        glm::ivec3            coord;
+        std::vector<ObjectID> ids;
+        // Bounding spheres (xyz center, w radius), parallel to ids so queries
+        // walk one contiguous array per cell
+        std::vector<glm::vec4> spheres;
+    };
+
+    struct Object
+    {
+        std::uint32_t cell; // Index into cells, or OversizedCell
+        std::uint32_t slot; // Index into the cell's arrays
+        bool          alive;
+    };
+
+    struct CellHash
+    {
+        std::size_t operator()(const glm::ivec3 &coord) const;
+    };
+
+    float cellSize;
+    float inverseCellSize;
+
+    std::vector<GridCell>                                  cells;
+    std::vector<std::uint32_t>                             freeCells;
+    std::unordered_map<glm::ivec3, std::uint32_t, CellHash> cellLookup;
+    // Every cell coordinate used since the last Clear lies within these,
+    // empty cells are not shrunk away
+    glm::ivec3 usedLo;
+    glm::ivec3 usedHi;
+
+    std::vector<Object>   objects;
+    std::vector<ObjectID> freeIDs;
+
+    // Objects too large for the loose bounds
+    std::vector<ObjectID>  oversizedIDs;
+    std::vector<glm::vec4> oversizedSpheres;
+
+    // Scratch for MoveMany, kept to avoid reallocating every frame
+    std::vector<std::uint32_t> rebinScratch;
+    std::mutex                 rebinMutex;
+
+    glm::ivec3 CellCoord(const glm::vec3 &position) const;
+
+    std::uint32_t TargetCell(const glm::vec4 &sphere);
+    void          Link(ObjectID id, const glm::vec4 &sphere);
+    void          Unlink(ObjectID id);
+
+public:
+    SpatialGrid(float cellSize);
+    ~SpatialGrid();
+
+    ObjectID Insert(const glm::vec3 &center, float radius);
+    void     Move(ObjectID id, const glm::vec3 &center, float radius);
+    void     Remove(ObjectID id);
+    void     Clear();
+
+    // Moves many objects at once. Objects that stay in their cell are
+    // updated in place on the job system, only the ones changing cell are
+    // rebinned serially afterwards.
+    void MoveMany(JobSystem &jobs, const ObjectID *ids,
+                  const glm::vec4 *spheres, std::size_t count);
+
+    // Both queries append to the output and may report an object once per
+    // call only
+    void QueryRadius(const glm::vec3 &center, float radius,
+                     std::vector<ObjectID> &results) const;
+    void QueryFrustum(const Frustum &        frustum,
+                      std::vector<ObjectID> &results) const;
+
+    std::size_t GetObjectCount() const;
+    std::size_t GetCellCount() const;
+    float       GetCellSize() const;
+};
+
+#endif
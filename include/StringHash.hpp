@@ -0,0 +1,62 @@
+#pragma once
+#ifndef StringHash_hpp
+#define StringHash_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 32-bit FNV-1a. Usable at compile time, so names such as uniforms can be
+// hashed once where they are written instead of on every use:
+//     constexpr std::uint32_t colorName = HashName("u_Color");
+constexpr std::uint32_t HashName(std::string_view name)
+{
+    std::uint32_t hash = 2166136261u;
+    for (char c : name)
+    {
+        hash ^= std::uint8_t(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t ContentHashSeed = 14695981039346656037ull;
+
+// 64-bit FNV-1a, for content rather than names. Pass the previous result
+// as the seed to hash several pieces as one.
+constexpr std::uint64_t HashContent(std::string_view data,
+                                    std::uint64_t    seed = ContentHashSeed)
+{
+    std::uint64_t hash = seed;
+    for (char c : data)
+    {
+        hash ^= std::uint8_t(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 64-bit, eight bytes at a time, for long texts such as shader sources
+// where HashContent's byte at a time is too slow. Not the same values as
+// HashContent.
+constexpr std::uint64_t HashText(std::string_view data)
+{
+    std::uint64_t hash = ContentHashSeed ^ data.size();
+    std::size_t   i    = 0;
+    for (; i + 8 <= data.size(); i += 8)
+    {
+        std::uint64_t word = 0;
+        for (std::size_t b = 0; b < 8; b++)
+            word |= std::uint64_t(std::uint8_t(data[i + b])) << (b * 8);
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 32;
+    }
+    for (; i < data.size(); i++)
+    {
+        hash ^= std::uint8_t(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+#endif
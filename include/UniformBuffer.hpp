@@ -0,0 +1,45 @@
+#pragma once
+#ifndef UniformBuffer_hpp
+#define UniformBuffer_hpp
+
+#include <GL/glew.h>
+
+class GLState;
+
+// Uploads use direct state access when available, otherwise they go through
+// GL_COPY_WRITE_BUFFER, which the GL state cache leaves alone. Either way
+// writing never disturbs the uniform buffer bindings.
+class UniformBuffer
+{
+private:
+    GLuint     buffer;
+    GLsizeiptr size;
+    GLenum     usage;
+    GLState *  state;
+    bool       direct;
+
+public:
+    UniformBuffer();
+    UniformBuffer(const UniformBuffer &other) = delete;
+    UniformBuffer &operator=(const UniformBuffer &other) = delete;
+    UniformBuffer(UniformBuffer &&other);
+    UniformBuffer &operator=(UniformBuffer &&other) = delete;
+    ~UniformBuffer();
+
+    void CreateBuffer(GLState &state, GLsizeiptr size,
+                      GLenum usage = GL_DYNAMIC_DRAW);
+    // Writing the whole buffer orphans it, so a frame still reading the old
+    // contents never stalls the upload
+    void UpdateBuffer(const void *data, GLsizeiptr size, GLintptr offset = 0);
+    // Detaches the current storage, which keeps serving draws still in
+    // flight, and replaces it with fresh storage of the same size
+    void OrphanBuffer();
+    void BindBase(GLuint binding);
+    void BindRange(GLuint binding, GLintptr offset, GLsizeiptr size);
+    void ClearBuffer();
+
+    GLuint     GetBuffer() const;
+    GLsizeiptr GetSize() const;
+};
+
+#endif
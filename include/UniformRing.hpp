@@ -0,0 +1,56 @@
+#pragma once
+#ifndef UniformRing_hpp
+#define UniformRing_hpp
+
+#include "UniformBuffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <GL/glew.h>
+
+// Per-frame uniform storage for per-draw constants. Draws append their
+// constants at the uniform buffer offset alignment, from any thread, and
+// the whole frame is uploaded with a single buffer write. Each draw then
+// binds its own slice with glBindBufferRange.
+class UniformRing
+{
+public:
+    static constexpr GLintptr InvalidOffset = -1;
+
+private:
+    UniformBuffer                    buffer;
+    GLState *                        state;
+    std::unique_ptr<std::uint8_t[]> staging;
+    std::size_t                      capacity;
+    std::size_t                      alignment;
+    std::atomic<std::size_t>         head;
+
+public:
+    UniformRing();
+    ~UniformRing();
+
+    // Queries the alignment, call once a context exists
+    void CreateRing(GLState &state, std::size_t capacity);
+    void ClearRing();
+
+    // Starts a new frame, growing the storage to at least the given size
+    // first. Only call from the GL thread, outside of recording.
+    void BeginFrame(std::size_t reserve = 0);
+
+    // Bytes one allocation of this size really takes up
+    std::size_t AlignedSize(std::size_t size) const;
+
+    // Copies the data into the frame and returns its offset, or
+    // InvalidOffset when the frame is full. Thread safe.
+    GLintptr Push(const void *data, std::size_t size);
+
+    // Uploads everything pushed this frame, before any draw reads it
+    void Flush();
+
+    void BindRange(GLuint binding, GLintptr offset, GLsizeiptr size);
+};
+
+#endif
@@ -6,6 +6,8 @@
 
 #include <GL/glew.h>
 
+class GLState;
+
 struct Vertex
 {
 public:
@@ -13,7 +15,14 @@ public:
     Vertex(GLfloat pos_x, GLfloat pos_y, GLfloat pos_z, GLfloat uv_x,
            GLfloat uv_y);
     ~Vertex();
-    static GLuint GenerateAttributes();
+    // Creates a vertex array for the buffer bound to GL_ARRAY_BUFFER and
+    // leaves it bound
+    static GLuint GenerateAttributes(GLState &state);
+    // Direct state access only. The format alone, with vertex buffer binding
+    // 0 and no element buffer, so every mesh can share it and attach its
+    // own buffers before drawing.
+    static GLuint GetSharedVertexArray();
+    static void   ClearSharedVertexArray(GLState &state);
     GLfloat       position[3] = {0.0f, 0.0f, 0.0f};
     GLfloat       uv[2]       = {0.0f, 0.0f};
 };
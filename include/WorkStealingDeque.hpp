@@ -0,0 +1,98 @@
+#pragma once
+#ifndef WorkStealingDeque_hpp
+#define WorkStealingDeque_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Chase-Lev work-stealing deque of pointers, as formulated for weak memory
+// models by Le et al. (2013). Only the owning thread may Push and Pop, at
+// the bottom; any thread may Steal from the top. Fixed capacity, Push fails
+// rather than grows.
+template <typename T, std::size_t Capacity>
+class WorkStealingDeque
+{
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+private:
+    static constexpr std::int64_t Mask = std::int64_t(Capacity) - 1;
+
+    // Keep the owner's and the thieves' indices on separate cache lines
+    alignas(64) std::atomic<std::int64_t> top;
+    alignas(64) std::atomic<std::int64_t> bottom;
+    alignas(64) std::atomic<T *> buffer[Capacity];
+
+public:
+    WorkStealingDeque() : top(0), bottom(0)
+    {
+        for (auto &slot : buffer)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool Push(T *item)
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= std::int64_t(Capacity))
+            return false;
+        // Release on the slot as well as the fence, which publishes the
+        // item to a thief that acquires the slot
+        buffer[b & Mask].store(item, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    T *Pop()
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Already empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = buffer[b & Mask].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last item, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed))
+                item = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    T *Steal()
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        T *item = buffer[t & Mask].load(std::memory_order_acquire);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            return nullptr; // Lost to another thief or the owner
+        return item;
+    }
+
+    std::size_t GetSize() const
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? std::size_t(b - t) : 0;
+    }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#version 430 core
+
+// Tests every draw of an IndirectDrawList against the frustum and against
+// last frame's Hi-Z, and compacts the survivors into a new indirect command
+// buffer. See CullingPass.
+layout(local_size_x = 64) in;
+
+#include "include/frame_constants.glsl"
+
+// Same layout as DrawElementsIndirectCommand
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 1) readonly buffer InputCommands
+{
+    DrawCommand u_InputCommands[];
+};
+
+// World space bounding sphere of each draw, center in xyz, radius in w
+layout(std430, binding = 2) readonly buffer DrawBounds
+{
+    vec4 u_Bounds[];
+};
+
+layout(std430, binding = 3) writeonly buffer OutputCommands
+{
+    DrawCommand u_OutputCommands[];
+};
+
+layout(std430, binding = 4) buffer DrawCount
+{
+    uint u_DrawCount;
+};
+
+// Farthest depth per texel, one level per halving
+layout(binding = 0) uniform sampler2D u_HiZ;
+
+uniform int  u_InputCount;
+uniform int  u_HiZLevels; // 0 while there is no previous frame
+uniform vec2 u_HiZSize;
+uniform mat4 u_PreviousViewProjection;
+
+bool InFrustum(vec4 sphere)
+{
+    // Planes straight from the matrix rows, as in Frustum::FromMatrix
+    mat4 rows      = transpose(u_ViewProjection);
+    vec4 planes[6] = vec4[6](rows[3] + rows[0], rows[3] - rows[0],
+                             rows[3] + rows[1], rows[3] - rows[1],
+                             rows[3] + rows[2], rows[3] - rows[2]);
+    for (int i = 0; i < 6; i++)
+    {
+        float distance = dot(planes[i].xyz, sphere.xyz) + planes[i].w;
+        if (distance < -sphere.w * length(planes[i].xyz))
+            return false;
+    }
+    return true;
+}
+
+bool Occluded(vec4 sphere)
+{
+    if (u_HiZLevels == 0)
+        return false;
+
+    // Screen rectangle and nearest depth of the sphere's box last frame
+    vec3 low  = vec3(1e30);
+    vec3 high = vec3(-1e30);
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = vec3((i & 1) != 0 ? 1.0 : -1.0,
+                           (i & 2) != 0 ? 1.0 : -1.0,
+                           (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip   = u_PreviousViewProjection *
+                    vec4(sphere.xyz + corner * sphere.w, 1.0);
+        // Reaching behind last frame's camera, nothing can be said
+        if (clip.w <= 0.0)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        low      = min(low, ndc);
+        high     = max(high, ndc);
+    }
+    // Entirely off last frame's screen, nothing can be said either
+    if (any(lessThan(high.xy, vec2(-1.0))) ||
+        any(greaterThan(low.xy, vec2(1.0))))
+        return false;
+
+    vec2  uvLow   = clamp(low.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2  uvHigh  = clamp(high.xy * 0.5 + 0.5, 0.0, 1.0);
+    float nearest = low.z * 0.5 + 0.5;
+
+    // The level at which the rectangle spans at most two texels a side, so
+    // its four corners cover all of it
+    vec2  extent = (uvHigh - uvLow) * u_HiZSize;
+    float level  = ceil(log2(max(max(extent.x, extent.y), 1.0)));
+    level        = min(level, float(u_HiZLevels - 1));
+
+    float farthest =
+        max(max(textureLod(u_HiZ, uvLow, level).r,
+                textureLod(u_HiZ, vec2(uvHigh.x, uvLow.y), level).r),
+            max(textureLod(u_HiZ, vec2(uvLow.x, uvHigh.y), level).r,
+                textureLod(u_HiZ, uvHigh, level).r));
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(u_InputCount))
+        return;
+
+    vec4 sphere = u_Bounds[index];
+    if (!InFrustum(sphere) || Occluded(sphere))
+        return;
+
+    uint slot               = atomicAdd(u_DrawCount, 1u);
+    u_OutputCommands[slot] = u_InputCommands[index];
+}
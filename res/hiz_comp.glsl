@@ -0,0 +1,41 @@
+#version 430 core
+
+// Builds one level of the Hi-Z pyramid, see HiZBuffer. Each texel keeps the
+// farthest depth of the texels it covers in the level below.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D u_Depth;
+layout(r32f, binding = 0) writeonly uniform image2D u_Destination;
+layout(r32f, binding = 1) readonly uniform image2D u_Source;
+
+// Level 0 copies the depth buffer, the others reduce the level above
+uniform int u_CopyDepth;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size  = imageSize(u_Destination);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    if (u_CopyDepth != 0)
+    {
+        float depth = texelFetch(u_Depth, texel, 0).r;
+        imageStore(u_Destination, texel, vec4(depth));
+        return;
+    }
+
+    // An odd sized source leaves a last row or column, the edge texels
+    // take it in as well
+    ivec2 sourceSize = imageSize(u_Source);
+    ivec2 first      = texel * 2;
+    ivec2 last       = first + 1 + ivec2(equal(texel, size - 1)) *
+                                 (sourceSize & 1);
+    last             = min(last, sourceSize - 1);
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++)
+        for (int x = first.x; x <= last.x; x++)
+            depth = max(depth, imageLoad(u_Source, ivec2(x, y)).r);
+    imageStore(u_Destination, texel, vec4(depth));
+}
@@ -0,0 +1,12 @@
+// Written once per frame, shared by every program. Must match the
+// FrameConstants struct in include/FrameConstants.hpp.
+layout(std140) uniform FrameConstants
+{
+    mat4  u_View;
+    mat4  u_Projection;
+    mat4  u_ViewProjection;
+    vec4  u_CameraPosition;
+    float u_Time;
+    float u_DeltaTime;
+    vec2  u_Resolution;
+};
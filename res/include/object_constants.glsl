@@ -0,0 +1,7 @@
+// One slice per draw, bound from the frame's uniform ring. Must match the
+// ObjectConstants struct in include/ObjectConstants.hpp.
+layout(std140) uniform ObjectConstants
+{
+    mat4 u_Model;
+    vec4 u_Color;
+};
@@ -0,0 +1,12 @@
+// Every draw of an indirect pass, indexed by its draw ID. Must match the
+// ObjectConstants struct in include/ObjectConstants.hpp.
+struct ObjectData
+{
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectDataBuffer
+{
+    ObjectData u_Objects[];
+};
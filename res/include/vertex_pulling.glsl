@@ -0,0 +1,47 @@
+// Vertex attributes read by hand, see MeshPool. Each mesh keeps its own
+// layout, described by a MeshFormat, and draw i draws mesh u_DrawMeshes[i].
+// Must match MeshPool::MeshFormat and its bindings.
+struct MeshFormat
+{
+    uint firstFloat;
+    uint stride;         // Floats per vertex
+    int  positionOffset; // -1 when the mesh has no such attribute
+    int  uvOffset;
+};
+
+layout(std430, binding = 5) readonly buffer VertexData
+{
+    float u_VertexData[];
+};
+
+layout(std430, binding = 6) readonly buffer MeshFormats
+{
+    MeshFormat u_MeshFormats[];
+};
+
+layout(std430, binding = 7) readonly buffer DrawMeshes
+{
+    uint u_DrawMeshes[];
+};
+
+// First float of the vertex, gl_VertexID being relative to the mesh
+uint VertexStart(MeshFormat format)
+{
+    return format.firstFloat + uint(gl_VertexID) * format.stride;
+}
+
+vec3 PullVec3(uint start, int offset)
+{
+    if (offset < 0)
+        return vec3(0.0);
+    uint i = start + uint(offset);
+    return vec3(u_VertexData[i], u_VertexData[i + 1], u_VertexData[i + 2]);
+}
+
+vec2 PullVec2(uint start, int offset)
+{
+    if (offset < 0)
+        return vec2(0.0);
+    uint i = start + uint(offset);
+    return vec2(u_VertexData[i], u_VertexData[i + 1]);
+}
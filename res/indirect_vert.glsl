@@ -0,0 +1,22 @@
+#version 430 core
+
+#include "include/frame_constants.glsl"
+#include "include/object_data.glsl"
+
+layout(location = 0) in vec4 position;
+// The draw's base instance, see MeshPool
+layout(location = 2) in uint drawID;
+
+out vec4 vertPos;
+#ifdef OBJECT_COLOR
+out vec4 vertColor;
+#endif
+
+void main()
+{
+    gl_Position = u_ViewProjection * u_Objects[drawID].model * position;
+    vertPos     = position;
+#ifdef OBJECT_COLOR
+    vertColor = u_Objects[drawID].color;
+#endif
+}
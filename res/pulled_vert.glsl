@@ -0,0 +1,27 @@
+#version 430 core
+
+#include "include/frame_constants.glsl"
+#include "include/object_data.glsl"
+#include "include/vertex_pulling.glsl"
+
+// The draw's base instance, see MeshPool. The only vertex attribute.
+layout(location = 2) in uint drawID;
+
+out vec4 vertPos;
+#ifdef OBJECT_COLOR
+out vec4 vertColor;
+#endif
+
+void main()
+{
+    MeshFormat format   = u_MeshFormats[u_DrawMeshes[drawID]];
+    vec4       position = vec4(PullVec3(VertexStart(format),
+                                        format.positionOffset),
+                               1.0);
+
+    gl_Position = u_ViewProjection * u_Objects[drawID].model * position;
+    vertPos     = position;
+#ifdef OBJECT_COLOR
+    vertColor = u_Objects[drawID].color;
+#endif
+}
@@ -1,9 +1,19 @@
 #version 330 core
 
+#include "include/object_constants.glsl"
+
 out vec4 color;
 
 in vec4 vertPos;
+#ifdef OBJECT_COLOR
+in vec4 vertColor;
+#endif
 
-uniform vec4 u_Color;
-
-void main() { color = (vertPos * 0.5) + 0.5; }
\ No newline at end of file
+void main()
+{
+#ifdef OBJECT_COLOR
+    color = vertColor;
+#else
+    color = (vertPos * 0.5) + 0.5;
+#endif
+}
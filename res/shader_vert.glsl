@@ -1,15 +1,14 @@
 #version 330 core
 
-layout(location = 0) in vec4 position;
+#include "include/frame_constants.glsl"
+#include "include/object_constants.glsl"
 
-uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+layout(location = 0) in vec4 position;
 
 out vec4 vertPos;
 
 void main()
 {
-    gl_Position = projection * view * model * position;
+    gl_Position = u_ViewProjection * u_Model * position;
     vertPos     = position;
-}
\ No newline at end of file
+}
@@ -0,0 +1,126 @@
+#include "Camera.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+Camera::Camera(float fov, float aspect, float nearDistance, float farDistance)
+    : position(0.0f), orientation(1.0f, 0.0f, 0.0f, 0.0f), fieldOfView(fov),
+      aspectRatio(aspect), nearPlane(nearDistance), farPlane(farDistance),
+      viewDirty(true), projectionDirty(true), view(1.0f), inverseView(1.0f),
+      projection(1.0f), inverseProjection(1.0f), viewProjection(1.0f),
+      inverseViewProjection(1.0f)
+{
+    Update();
+}
+
+Camera::~Camera() {}
+
+void Camera::SetPosition(const glm::vec3 &newPosition)
+{
+    position  = newPosition;
+    viewDirty = true;
+}
+
+void Camera::SetOrientation(const glm::quat &newOrientation)
+{
+    orientation = glm::normalize(newOrientation);
+    viewDirty   = true;
+}
+
+void Camera::SetPerspective(float fov, float aspect, float nearDistance,
+                            float farDistance)
+{
+    fieldOfView     = fov;
+    aspectRatio     = aspect;
+    nearPlane       = nearDistance;
+    farPlane        = farDistance;
+    projectionDirty = true;
+}
+
+void Camera::SetAspectRatio(float aspect)
+{
+    aspectRatio     = aspect;
+    projectionDirty = true;
+}
+
+void Camera::MoveLocal(const glm::vec3 &offset)
+{
+    position += orientation * offset;
+    viewDirty = true;
+}
+
+void Camera::Rotate(float yaw, float pitch)
+{
+    glm::quat yawRotation = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::quat pitchRotation =
+        glm::angleAxis(pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+    // World-space yaw on the left, local pitch on the right
+    orientation = glm::normalize(yawRotation * orientation * pitchRotation);
+    viewDirty   = true;
+}
+
+void Camera::LookAt(const glm::vec3 &target, const glm::vec3 &up)
+{
+    // The inverse of a look-at view matrix is the camera's world transform
+    glm::mat4 lookAt = glm::lookAt(position, target, up);
+    orientation      = glm::normalize(glm::quat_cast(glm::inverse(lookAt)));
+    viewDirty        = true;
+}
+
+void Camera::Update()
+{
+    if (!viewDirty && !projectionDirty)
+        return;
+
+    if (viewDirty)
+    {
+        // Rotation and translation only, so the inverse is the transpose of
+        // the rotation and a rotated, negated translation
+        glm::mat4 rotation = glm::mat4_cast(orientation);
+        inverseView        = rotation;
+        inverseView[3]     = glm::vec4(position, 1.0f);
+
+        view    = glm::mat4_cast(glm::conjugate(orientation));
+        view[3] = glm::vec4(-(glm::conjugate(orientation) * position), 1.0f);
+    }
+
+    if (projectionDirty)
+    {
+        projection =
+            glm::perspective(fieldOfView, aspectRatio, nearPlane, farPlane);
+        inverseProjection = glm::inverse(projection);
+    }
+
+    viewProjection        = projection * view;
+    inverseViewProjection = inverseView * inverseProjection;
+    frustum               = Frustum::FromMatrix(viewProjection);
+
+    viewDirty = projectionDirty = false;
+}
+
+const glm::vec3 &Camera::GetPosition() const { return position; }
+
+const glm::quat &Camera::GetOrientation() const { return orientation; }
+
+glm::vec3 Camera::GetForward() const
+{
+    return orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+}
+
+float Camera::GetNearPlane() const { return nearPlane; }
+
+float Camera::GetFarPlane() const { return farPlane; }
+
+const glm::mat4 &Camera::GetView() const { return view; }
+
+const glm::mat4 &Camera::GetInverseView() const { return inverseView; }
+
+const glm::mat4 &Camera::GetProjection() const { return projection; }
+
+const glm::mat4 &Camera::GetViewProjection() const { return viewProjection; }
+
+const glm::mat4 &Camera::GetInverseViewProjection() const
+{
+    return inverseViewProjection;
+}
+
+const Frustum &Camera::GetFrustum() const { return frustum; }
@@ -0,0 +1,364 @@
+#include "CellGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace pt = boost::property_tree;
+
+// Screen-space bounds, see CellGraph::cellBounds
+static const glm::vec4 EmptyBounds  = glm::vec4(1.0f, 1.0f, -1.0f, -1.0f);
+static const glm::vec4 ScreenBounds = glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f);
+
+static bool IsEmpty(const glm::vec4 &bounds)
+{
+    return bounds.x > bounds.z || bounds.y > bounds.w;
+}
+
+static glm::vec4 Intersect(const glm::vec4 &a, const glm::vec4 &b)
+{
+    return glm::vec4(std::max(a.x, b.x), std::max(a.y, b.y),
+                     std::min(a.z, b.z), std::min(a.w, b.w));
+}
+
+// Reads a JSON array of three numbers, such as [1.0, 2.0, 3.0]
+static bool ReadVec3(const pt::ptree &node, glm::vec3 &vec)
+{
+    if (node.size() != 3)
+        return false;
+    int i = 0;
+    for (auto &component : node)
+        vec[i++] = component.second.get_value<float>();
+    return true;
+}
+
+CellGraph::CellGraph(std::string name) : name(name), currentStamp(0) {}
+
+CellGraph::~CellGraph() {}
+
+const std::string &CellGraph::GetName() const { return this->name; }
+
+std::vector<CellGraph> CellGraph::ReadCellGraphs(std::string directoryPath)
+{
+    auto graphs = std::vector<CellGraph>();
+
+    if (!std::filesystem::is_directory(directoryPath))
+        return graphs;
+
+    for (auto &dir :
+         std::filesystem::recursive_directory_iterator(directoryPath))
+    {
+        std::error_code error;
+        if (!dir.is_regular_file(error) || error)
+            continue;
+        if (dir.path().extension() != ".json")
+            continue;
+
+        auto root = pt::ptree();
+        try
+        {
+            pt::read_json(dir.path(), root);
+            // Only JSON files describing cells are of interest here
+            boost::optional<std::string> jsonType =
+                root.get_optional<std::string>("type");
+            if (!jsonType.has_value() || jsonType.get() != "cells")
+                continue;
+
+            boost::optional<std::string> graphName =
+                root.get_optional<std::string>("name");
+            if (!graphName.has_value())
+            {
+                std::cerr << "All cell graphs must have a 'name' field in the "
+                             "root"
+                          << std::endl;
+                continue;
+            }
+
+            auto jsonCells = root.get_child_optional("cells");
+            if (!jsonCells.has_value())
+            {
+                std::cerr << "A cell graph must have a 'cells' array"
+                          << std::endl;
+                continue;
+            }
+
+            auto graph = CellGraph(graphName.get());
+            // Portals refer to their target by name, which can only be
+            // resolved once every cell is known
+            auto cellIndices  = std::unordered_map<std::string, std::size_t>();
+            auto portalTarget = std::vector<std::vector<std::string>>();
+
+            for (auto &cellData : jsonCells.get())
+            {
+                auto cell     = Cell();
+                auto cellName =
+                    cellData.second.get_optional<std::string>("name");
+                auto cellMin = cellData.second.get_child_optional("min");
+                auto cellMax = cellData.second.get_child_optional("max");
+                if (!cellName.has_value() || !cellMin.has_value() ||
+                    !cellMax.has_value() ||
+                    !ReadVec3(cellMin.get(), cell.boundsMin) ||
+                    !ReadVec3(cellMax.get(), cell.boundsMax))
+                {
+                    std::cerr << "Every cell must have a 'name' and 'min'/'max' "
+                                 "bounds"
+                              << std::endl;
+                    continue;
+                }
+                cell.name = cellName.get();
+
+                auto meshes = cellData.second.get_child_optional("meshes");
+                if (meshes.has_value())
+                    for (auto &mesh : meshes.get())
+                        cell.meshes.push_back(
+                            mesh.second.get_value<std::size_t>());
+
+                auto targets = std::vector<std::string>();
+                auto portals = cellData.second.get_child_optional("portals");
+                if (portals.has_value())
+                {
+                    for (auto &portalData : portals.get())
+                    {
+                        auto portal = Portal();
+                        auto target =
+                            portalData.second.get_optional<std::string>(
+                                "target");
+                        auto vertices =
+                            portalData.second.get_child_optional("vertices");
+                        if (!target.has_value() || !vertices.has_value())
+                        {
+                            std::cerr << "Every portal must have a 'target' "
+                                         "cell and 'vertices'"
+                                      << std::endl;
+                            continue;
+                        }
+                        for (auto &vertexData : vertices.get())
+                        {
+                            glm::vec3 vertex;
+                            if (ReadVec3(vertexData.second, vertex))
+                                portal.vertices.push_back(vertex);
+                        }
+                        if (portal.vertices.size() < 3)
+                        {
+                            std::cerr << "Portal into '" << target.get()
+                                      << "' needs at least 3 vertices"
+                                      << std::endl;
+                            continue;
+                        }
+                        cell.portals.push_back(std::move(portal));
+                        targets.push_back(target.get());
+                    }
+                }
+
+                cellIndices[cell.name] = graph.AddCell(std::move(cell));
+                portalTarget.push_back(std::move(targets));
+            }
+
+            // Resolve the portal targets, dropping any that lead nowhere
+            for (std::size_t c = 0; c < graph.cells.size(); c++)
+            {
+                auto &portals = graph.cells[c].portals;
+                auto  kept    = std::vector<Portal>();
+                for (std::size_t p = 0; p < portals.size(); p++)
+                {
+                    auto found = cellIndices.find(portalTarget[c][p]);
+                    if (found == cellIndices.end())
+                    {
+                        std::cerr << "Portal in cell '" << graph.cells[c].name
+                                  << "' targets unknown cell '"
+                                  << portalTarget[c][p] << "'" << std::endl;
+                        continue;
+                    }
+                    portals[p].targetCell = found->second;
+                    kept.push_back(std::move(portals[p]));
+                }
+                portals = std::move(kept);
+            }
+
+            graphs.push_back(std::move(graph));
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            continue;
+        }
+    }
+    return graphs;
+}
+
+std::size_t CellGraph::AddCell(Cell cell)
+{
+    for (auto mesh : cell.meshes)
+    {
+        if (mesh >= meshInCell.size())
+            meshInCell.resize(mesh + 1, false);
+        meshInCell[mesh] = true;
+    }
+    cells.push_back(std::move(cell));
+    cellStamps.push_back(0);
+    projectedStamps.push_back(0);
+    cellBounds.push_back(EmptyBounds);
+    portalBounds.emplace_back();
+    cellQueued.push_back(false);
+    return cells.size() - 1;
+}
+
+std::vector<Cell> const &CellGraph::GetCells() const { return cells; }
+
+long CellGraph::FindCell(const glm::vec3 &point) const
+{
+    for (std::size_t i = 0; i < cells.size(); i++)
+    {
+        const Cell &cell = cells[i];
+        if (point.x >= cell.boundsMin.x && point.x <= cell.boundsMax.x &&
+            point.y >= cell.boundsMin.y && point.y <= cell.boundsMax.y &&
+            point.z >= cell.boundsMin.z && point.z <= cell.boundsMax.z)
+            return long(i);
+    }
+    return -1;
+}
+
+bool CellGraph::ContainsMesh(std::size_t mesh) const
+{
+    return mesh < meshInCell.size() && meshInCell[mesh];
+}
+
+bool CellGraph::ComputeVisibleMeshes(const glm::vec3 &eye,
+                                     const Frustum &  frustum,
+                                     const glm::mat4 &viewProjection,
+                                     std::vector<std::size_t> &visibleMeshes)
+{
+    visibleMeshes.clear();
+
+    long startCell = FindCell(eye);
+    if (startCell < 0)
+        return false;
+
+    // Restart the stamps on wrap-around
+    if (++currentStamp == 0)
+    {
+        std::fill(cellStamps.begin(), cellStamps.end(), 0);
+        std::fill(meshStamps.begin(), meshStamps.end(), 0);
+        std::fill(projectedStamps.begin(), projectedStamps.end(), 0);
+        currentStamp = 1;
+    }
+
+    // Bounds flow from cell to cell through the portals until none of them
+    // grows. Every bound edge is a portal's or the screen's, so each cell is
+    // only queued again a bounded number of times, however many paths lead
+    // to it.
+    auto start        = std::size_t(startCell);
+    cellStamps[start] = currentStamp;
+    cellBounds[start] = ScreenBounds;
+    SubmitMeshes(start, visibleMeshes);
+    cellQueued[start] = true;
+    openCells.push_back(start);
+
+    while (!openCells.empty())
+    {
+        std::size_t cellIndex = openCells.front();
+        openCells.pop_front();
+        cellQueued[cellIndex] = false;
+
+        if (projectedStamps[cellIndex] != currentStamp)
+        {
+            projectedStamps[cellIndex] = currentStamp;
+            ProjectPortals(cellIndex, eye, frustum, viewProjection);
+        }
+
+        const Cell &cell = cells[cellIndex];
+        for (std::size_t p = 0; p < cell.portals.size(); p++)
+        {
+            glm::vec4 through =
+                Intersect(cellBounds[cellIndex], portalBounds[cellIndex][p]);
+            if (IsEmpty(through))
+                continue; // The portal is not visible along these paths
+
+            std::size_t target = cell.portals[p].targetCell;
+            if (cellStamps[target] != currentStamp)
+            {
+                cellStamps[target] = currentStamp;
+                cellBounds[target] = through;
+                SubmitMeshes(target, visibleMeshes);
+            }
+            else
+            {
+                const glm::vec4 &bounds = cellBounds[target];
+                glm::vec4        merged =
+                    glm::vec4(std::min(bounds.x, through.x),
+                              std::min(bounds.y, through.y),
+                              std::max(bounds.z, through.z),
+                              std::max(bounds.w, through.w));
+                if (merged == bounds)
+                    continue; // Nothing new can be seen from there
+                cellBounds[target] = merged;
+            }
+
+            if (!cellQueued[target])
+            {
+                cellQueued[target] = true;
+                openCells.push_back(target);
+            }
+        }
+    }
+    return true;
+}
+
+void CellGraph::SubmitMeshes(std::size_t               cellIndex,
+                             std::vector<std::size_t> &visibleMeshes)
+{
+    // A mesh can be listed by several cells, but is only submitted once
+    for (auto mesh : cells[cellIndex].meshes)
+    {
+        if (mesh >= meshStamps.size())
+            meshStamps.resize(mesh + 1, 0);
+        if (meshStamps[mesh] == currentStamp)
+            continue;
+        meshStamps[mesh] = currentStamp;
+        visibleMeshes.push_back(mesh);
+    }
+}
+
+void CellGraph::ProjectPortals(std::size_t cellIndex, const glm::vec3 &eye,
+                               const Frustum &  frustum,
+                               const glm::mat4 &viewProjection)
+{
+    const Cell &cell   = cells[cellIndex];
+    auto &      bounds = portalBounds[cellIndex];
+    bounds.assign(cell.portals.size(), EmptyBounds);
+
+    std::vector<glm::vec3> clipped;
+    for (std::size_t p = 0; p < cell.portals.size(); p++)
+    {
+        const Portal &portal = cell.portals[p];
+        if (!frustum.ClipPolygon(portal.vertices, clipped))
+            continue; // Outside of the view
+
+        // Standing in the portal opening its projection is degenerate, but
+        // it covers whatever can be seen of it
+        Plane portalPlane = Plane::FromPoints(
+            portal.vertices[0], portal.vertices[1], portal.vertices[2]);
+        if (std::abs(portalPlane.SignedDistance(eye)) < 1e-3f)
+        {
+            bounds[p] = ScreenBounds;
+            continue;
+        }
+
+        // Clipped by the near plane, every vertex is in front of the eye
+        glm::vec2 min = glm::vec2(INFINITY);
+        glm::vec2 max = glm::vec2(-INFINITY);
+        for (auto const &vertex : clipped)
+        {
+            glm::vec4 clip = viewProjection * glm::vec4(vertex, 1.0f);
+            glm::vec2 ndc  = glm::vec2(clip) / std::max(clip.w, 1e-6f);
+            min            = glm::min(min, ndc);
+            max            = glm::max(max, ndc);
+        }
+        bounds[p] = Intersect(glm::vec4(min, max), ScreenBounds);
+    }
+}
@@ -0,0 +1,165 @@
+#include "CommandBuffer.hpp"
+
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+// Command payloads, each laid out right behind its header
+namespace
+{
+    struct BindProgramCommand
+    {
+        CommandHeader header;
+        std::uint32_t shaderIndex;
+    };
+
+    struct SetUniformMat4Command
+    {
+        CommandHeader header;
+        std::uint32_t nameHash;
+        float         value[16];
+    };
+
+    struct SetUniformVec4Command
+    {
+        CommandHeader header;
+        std::uint32_t nameHash;
+        float         value[4];
+    };
+
+    struct BindUniformRangeCommand
+    {
+        CommandHeader header;
+        std::uint32_t binding;
+        std::size_t   offset;
+        std::size_t   size;
+    };
+
+    struct DrawMeshCommand
+    {
+        CommandHeader header;
+        std::uint32_t meshIndex;
+    };
+} // namespace
+
+CommandBackend::~CommandBackend() {}
+
+CommandBuffer::CommandBuffer()
+    : allocator(), first(nullptr), last(nullptr), commandCount(0)
+{
+}
+
+CommandBuffer::CommandBuffer(CommandBuffer &&other)
+    : allocator(std::move(other.allocator)), first(other.first),
+      last(other.last), commandCount(other.commandCount)
+{
+    other.first = other.last = nullptr;
+    other.commandCount       = 0;
+}
+
+CommandBuffer::~CommandBuffer() {}
+
+template <typename T>
+T *CommandBuffer::Append(CommandType type)
+{
+    T *command = static_cast<T *>(allocator.Allocate(sizeof(T), alignof(T)));
+    command->header.type = type;
+    command->header.next = nullptr;
+
+    if (last != nullptr)
+        last->next = &command->header;
+    else
+        first = &command->header;
+    last = &command->header;
+    commandCount++;
+    return command;
+}
+
+void CommandBuffer::Reset()
+{
+    allocator.Reset();
+    first = last = nullptr;
+    commandCount = 0;
+}
+
+void CommandBuffer::BindProgram(std::uint32_t shaderIndex)
+{
+    Append<BindProgramCommand>(CommandType::BindProgram)->shaderIndex =
+        shaderIndex;
+}
+
+void CommandBuffer::SetUniformMat4(std::uint32_t    nameHash,
+                                   const glm::mat4 &value)
+{
+    auto command = Append<SetUniformMat4Command>(CommandType::SetUniformMat4);
+    command->nameHash = nameHash;
+    std::memcpy(command->value, glm::value_ptr(value), sizeof(command->value));
+}
+
+void CommandBuffer::SetUniformVec4(std::uint32_t    nameHash,
+                                   const glm::vec4 &value)
+{
+    auto command = Append<SetUniformVec4Command>(CommandType::SetUniformVec4);
+    command->nameHash = nameHash;
+    std::memcpy(command->value, glm::value_ptr(value), sizeof(command->value));
+}
+
+void CommandBuffer::BindUniformRange(std::uint32_t binding,
+                                     std::size_t offset, std::size_t size)
+{
+    auto command =
+        Append<BindUniformRangeCommand>(CommandType::BindUniformRange);
+    command->binding = binding;
+    command->offset  = offset;
+    command->size    = size;
+}
+
+void CommandBuffer::DrawMesh(std::uint32_t meshIndex)
+{
+    Append<DrawMeshCommand>(CommandType::DrawMesh)->meshIndex = meshIndex;
+}
+
+void CommandBuffer::Replay(CommandBackend &backend) const
+{
+    for (const CommandHeader *header = first; header != nullptr;
+         header                      = header->next)
+    {
+        switch (header->type)
+        {
+            case CommandType::BindProgram:
+                backend.BindProgram(
+                    reinterpret_cast<const BindProgramCommand *>(header)
+                        ->shaderIndex);
+                break;
+            case CommandType::SetUniformMat4:
+            {
+                auto command =
+                    reinterpret_cast<const SetUniformMat4Command *>(header);
+                backend.SetUniformMat4(command->nameHash, command->value);
+                break;
+            }
+            case CommandType::SetUniformVec4:
+            {
+                auto command =
+                    reinterpret_cast<const SetUniformVec4Command *>(header);
+                backend.SetUniformVec4(command->nameHash, command->value);
+                break;
+            }
+            case CommandType::BindUniformRange:
+            {
+                auto command =
+                    reinterpret_cast<const BindUniformRangeCommand *>(header);
+                backend.BindUniformRange(command->binding, command->offset,
+                                         command->size);
+                break;
+            }
+            case CommandType::DrawMesh:
+                backend.DrawMesh(
+                    reinterpret_cast<const DrawMeshCommand *>(header)
+                        ->meshIndex);
+                break;
+        }
+    }
+}
+
+std::size_t CommandBuffer::GetCommandCount() const { return commandCount; }
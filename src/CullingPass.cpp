@@ -0,0 +1,141 @@
+#include "CullingPass.hpp"
+#include "GLState.hpp"
+#include "HiZBuffer.hpp"
+#include "OpenGLExtensions.hpp"
+#include "Shader.hpp"
+#include "StringHash.hpp"
+
+#include <algorithm>
+
+CullingPass::CullingPass()
+    : boundsBuffer(0), commandBuffer(0), countBuffer(0), capacity(0),
+      state(nullptr)
+{
+}
+
+CullingPass::~CullingPass() { ClearPass(); }
+
+void CullingPass::CreateBuffers(std::size_t drawCapacity)
+{
+    DeleteBuffers();
+    capacity = drawCapacity;
+
+    GLCall(glCreateBuffers(1, &boundsBuffer));
+    GLCall(glNamedBufferData(boundsBuffer, capacity * sizeof(glm::vec4),
+                             nullptr, GL_STREAM_DRAW));
+    // Only ever written by the GPU
+    GLCall(glCreateBuffers(1, &commandBuffer));
+    GLCall(glNamedBufferStorage(commandBuffer,
+                                capacity * sizeof(DrawElementsIndirectCommand),
+                                nullptr, GL_DYNAMIC_STORAGE_BIT));
+    GLCall(glCreateBuffers(1, &countBuffer));
+    GLCall(glNamedBufferStorage(countBuffer, sizeof(GLuint), nullptr,
+                                GL_DYNAMIC_STORAGE_BIT));
+}
+
+void CullingPass::DeleteBuffers()
+{
+    if (boundsBuffer == 0)
+        return;
+    for (GLuint buffer : {boundsBuffer, commandBuffer, countBuffer})
+        state->ForgetBuffer(buffer);
+    GLCall(glDeleteBuffers(1, &boundsBuffer));
+    GLCall(glDeleteBuffers(1, &commandBuffer));
+    GLCall(glDeleteBuffers(1, &countBuffer));
+    boundsBuffer = commandBuffer = countBuffer = 0;
+    capacity                                   = 0;
+}
+
+void CullingPass::CreatePass(GLState &glState, std::size_t drawCapacity)
+{
+    state = &glState;
+    CreateBuffers(std::max<std::size_t>(1, drawCapacity));
+}
+
+void CullingPass::ClearPass()
+{
+    DeleteBuffers();
+    bounds.clear();
+    state = nullptr;
+}
+
+void CullingPass::BeginFrame(std::size_t drawCount)
+{
+    if (drawCount > capacity)
+        CreateBuffers(std::max(drawCount, capacity * 2));
+    bounds.resize(drawCount);
+}
+
+void CullingPass::SetBounds(std::size_t index, const glm::vec4 &sphere)
+{
+    bounds[index] = sphere;
+}
+
+void CullingPass::Flush()
+{
+    if (bounds.empty())
+        return;
+    GLCall(glNamedBufferData(boundsBuffer, capacity * sizeof(glm::vec4),
+                             nullptr, GL_STREAM_DRAW));
+    GLCall(glNamedBufferSubData(boundsBuffer, 0,
+                                bounds.size() * sizeof(glm::vec4),
+                                bounds.data()));
+}
+
+void CullingPass::Cull(Shader &cullShader, IndirectDrawList &draws,
+                       const HiZBuffer &hiZ,
+                       const glm::mat4 &previousViewProjection)
+{
+    // Survivors are appended from zero. Without a count buffer to draw
+    // with, every slot is issued, so the ones left over must be empty.
+    GLCall(glClearNamedBufferData(countBuffer, GL_R32UI, GL_RED_INTEGER,
+                                  GL_UNSIGNED_INT, nullptr));
+    if (!HasIndirectParameters())
+    {
+        GLCall(glClearNamedBufferData(commandBuffer, GL_R32UI, GL_RED_INTEGER,
+                                      GL_UNSIGNED_INT, nullptr));
+    }
+
+    if (bounds.empty())
+        return;
+
+    cullShader.SetInUse(*state);
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, InputCommandsBinding,
+                          draws.GetCommandBuffer());
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, BoundsBinding,
+                          boundsBuffer);
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, OutputCommandsBinding,
+                          commandBuffer);
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCountBinding,
+                          countBuffer);
+
+    bool useHiZ = hiZ.IsValid();
+    if (useHiZ)
+        state->BindTexture(0, GL_TEXTURE_2D, hiZ.GetTexture());
+    cullShader.SetUniform(HashName("u_InputCount"), int(bounds.size()));
+    cullShader.SetUniform(HashName("u_HiZLevels"),
+                          useHiZ ? int(hiZ.GetLevelCount()) : 0);
+    cullShader.SetUniform(HashName("u_HiZSize"),
+                          glm::vec2(float(hiZ.GetWidth()),
+                                    float(hiZ.GetHeight())));
+    cullShader.SetUniform(HashName("u_PreviousViewProjection"),
+                          previousViewProjection);
+
+    cullShader.Dispatch(GLuint((bounds.size() + GroupSize - 1) / GroupSize));
+
+    // Both buffers are read next as draw parameters
+    GLCall(glMemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                           GL_SHADER_STORAGE_BARRIER_BIT));
+}
+
+void CullingPass::Draw(IndirectDrawList &draws, MeshPool &pool)
+{
+    draws.Draw(pool, commandBuffer, countBuffer);
+}
+
+GLuint CullingPass::ReadDrawCount() const
+{
+    GLuint count = 0;
+    GLCall(glGetNamedBufferSubData(countBuffer, 0, sizeof(count), &count));
+    return count;
+}
@@ -0,0 +1,195 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_access.hpp>
+
+Plane::Plane() {}
+
+Plane::Plane(const glm::vec3 &n, float d) : normal(n), distance(d) {}
+
+Plane Plane::FromPoints(const glm::vec3 &a, const glm::vec3 &b,
+                        const glm::vec3 &c)
+{
+    glm::vec3 n = glm::normalize(glm::cross(b - a, c - a));
+    return Plane(n, -glm::dot(n, a));
+}
+
+float Plane::SignedDistance(const glm::vec3 &point) const
+{
+    return glm::dot(normal, point) + distance;
+}
+
+void Plane::Flip()
+{
+    normal   = -normal;
+    distance = -distance;
+}
+
+Frustum::Frustum() : planeCount(0) {}
+
+Frustum::~Frustum() {}
+
+Frustum Frustum::FromMatrix(const glm::mat4 &viewProjection)
+{
+    // Gribb & Hartmann plane extraction
+    glm::vec4 rowX = glm::row(viewProjection, 0);
+    glm::vec4 rowY = glm::row(viewProjection, 1);
+    glm::vec4 rowZ = glm::row(viewProjection, 2);
+    glm::vec4 rowW = glm::row(viewProjection, 3);
+
+    const glm::vec4 rawPlanes[6] = {
+        rowW + rowX, // Left
+        rowW - rowX, // Right
+        rowW + rowY, // Bottom
+        rowW - rowY, // Top
+        rowW + rowZ, // Near
+        rowW - rowZ  // Far
+    };
+
+    auto frustum = Frustum();
+    for (auto const &raw : rawPlanes)
+    {
+        glm::vec3 n   = glm::vec3(raw.x, raw.y, raw.z);
+        float     len = glm::length(n);
+        frustum.AddPlane(Plane(n / len, raw.w / len));
+    }
+    return frustum;
+}
+
+bool Frustum::AddPlane(const Plane &plane)
+{
+    if (planeCount >= MaxPlanes)
+        return false;
+    planes[planeCount++] = plane;
+    return true;
+}
+
+std::size_t Frustum::GetPlaneCount() const { return planeCount; }
+
+const Plane &Frustum::GetPlane(std::size_t index) const
+{
+    return planes[index];
+}
+
+bool Frustum::ContainsPoint(const glm::vec3 &point) const
+{
+    for (std::size_t i = 0; i < planeCount; i++)
+        if (planes[i].SignedDistance(point) < 0.0f)
+            return false;
+    return true;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3 &center, float radius) const
+{
+    for (std::size_t i = 0; i < planeCount; i++)
+        if (planes[i].SignedDistance(center) < -radius)
+            return false;
+    return true;
+}
+
+bool Frustum::IntersectsAABB(const glm::vec3 &min, const glm::vec3 &max) const
+{
+    for (std::size_t i = 0; i < planeCount; i++)
+    {
+        // Test the corner furthest along the plane normal
+        const glm::vec3 &n        = planes[i].normal;
+        glm::vec3        positive = glm::vec3(n.x >= 0.0f ? max.x : min.x,
+                                       n.y >= 0.0f ? max.y : min.y,
+                                       n.z >= 0.0f ? max.z : min.z);
+        if (planes[i].SignedDistance(positive) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::ComputeBounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    // A direction the volume extends along forever lies where two planes
+    // meet, and no plane faces against it. With fewer than two planes that
+    // are not parallel, there is always one.
+    bool anyEdge = false;
+    for (std::size_t i = 0; i < planeCount; i++)
+        for (std::size_t j = i + 1; j < planeCount; j++)
+        {
+            glm::vec3 edge = glm::cross(planes[i].normal, planes[j].normal);
+            float     size = glm::length(edge);
+            if (size < 1e-5f)
+                continue;
+            anyEdge = true;
+            for (float sign : {1.0f, -1.0f})
+            {
+                bool escapes = true;
+                for (std::size_t k = 0; k < planeCount && escapes; k++)
+                    escapes = glm::dot(planes[k].normal, edge * sign) >=
+                              -1e-5f * size;
+                if (escapes)
+                    return false;
+            }
+        }
+    if (!anyEdge)
+        return false;
+
+    // Every corner is where three planes meet, inside all the others
+    bool found = false;
+    for (std::size_t i = 0; i < planeCount; i++)
+        for (std::size_t j = i + 1; j < planeCount; j++)
+            for (std::size_t k = j + 1; k < planeCount; k++)
+            {
+                const Plane &a     = planes[i];
+                const Plane &b     = planes[j];
+                const Plane &c     = planes[k];
+                glm::vec3    bc    = glm::cross(b.normal, c.normal);
+                float        denom = glm::dot(a.normal, bc);
+                if (std::abs(denom) < 1e-6f)
+                    continue;
+                glm::vec3 corner = -(a.distance * bc +
+                                     b.distance * glm::cross(c.normal, a.normal) +
+                                     c.distance * glm::cross(a.normal, b.normal)) /
+                                   denom;
+
+                // Far corners carry more rounding error
+                float tolerance = 1e-4f * (1.0f + glm::length(corner));
+                bool  inside    = true;
+                for (std::size_t p = 0; p < planeCount && inside; p++)
+                    inside = planes[p].SignedDistance(corner) >= -tolerance;
+                if (!inside)
+                    continue;
+
+                min   = found ? glm::min(min, corner) : corner;
+                max   = found ? glm::max(max, corner) : corner;
+                found = true;
+            }
+    return found;
+}
+
+bool Frustum::ClipPolygon(const std::vector<glm::vec3> &polygon,
+                          std::vector<glm::vec3> &      clipped) const
+{
+    clipped = polygon;
+    std::vector<glm::vec3> input;
+
+    for (std::size_t p = 0; p < planeCount && clipped.size() >= 3; p++)
+    {
+        input.swap(clipped);
+        clipped.clear();
+
+        const Plane &plane = planes[p];
+        for (std::size_t i = 0; i < input.size(); i++)
+        {
+            const glm::vec3 &current = input[i];
+            const glm::vec3 &next    = input[(i + 1) % input.size()];
+            float            dCur    = plane.SignedDistance(current);
+            float            dNext   = plane.SignedDistance(next);
+
+            if (dCur >= 0.0f)
+                clipped.push_back(current);
+            // Edge crosses the plane, emit the intersection point
+            if ((dCur >= 0.0f) != (dNext >= 0.0f))
+                clipped.push_back(current +
+                                  (next - current) * (dCur / (dCur - dNext)));
+        }
+    }
+
+    return clipped.size() >= 3;
+}
@@ -0,0 +1,48 @@
+#include "GLCommandBackend.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+GLCommandBackend::GLCommandBackend(GLState &            glState,
+                                   std::vector<Shader> &shaderList,
+                                   std::vector<Mesh> &  meshList,
+                                   UniformRing &        ring)
+    : state(glState), shaders(shaderList), meshes(meshList), uniformRing(ring),
+      currentShader(nullptr)
+{
+}
+
+GLCommandBackend::~GLCommandBackend() {}
+
+void GLCommandBackend::BindProgram(std::uint32_t shaderIndex)
+{
+    currentShader = &shaders.at(shaderIndex);
+    currentShader->SetInUse(state);
+}
+
+void GLCommandBackend::SetUniformMat4(std::uint32_t nameHash,
+                                      const float * value)
+{
+    if (currentShader == nullptr)
+        return;
+    currentShader->SetUniform(nameHash, glm::make_mat4(value));
+}
+
+void GLCommandBackend::SetUniformVec4(std::uint32_t nameHash,
+                                      const float * value)
+{
+    if (currentShader == nullptr)
+        return;
+    currentShader->SetUniform(nameHash, glm::make_vec4(value));
+}
+
+void GLCommandBackend::BindUniformRange(std::uint32_t binding,
+                                        std::size_t offset, std::size_t size)
+{
+    uniformRing.BindRange(binding, GLintptr(offset), GLsizeiptr(size));
+}
+
+void GLCommandBackend::DrawMesh(std::uint32_t meshIndex)
+{
+    meshes.at(meshIndex).RenderMesh();
+}
@@ -0,0 +1,412 @@
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <algorithm>
+
+GLState::GLState() { Invalidate(); }
+
+GLState::~GLState() {}
+
+int GLState::TargetSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_UNIFORM_BUFFER: return 1;
+        case GL_SHADER_STORAGE_BUFFER: return 2;
+        case GL_DRAW_INDIRECT_BUFFER: return 3;
+        case GL_DISPATCH_INDIRECT_BUFFER: return 4;
+        case GL_PARAMETER_BUFFER: return 5;
+        default: return -1;
+    }
+}
+
+std::uint32_t GLState::VertexBufferKey(GLuint vertexArray, GLuint index)
+{
+    // Names are small and dense, there is plenty of room for the index
+    return (std::uint32_t(vertexArray) << 4) | (index & 0xF);
+}
+
+bool GLState::Filter(bool redundant)
+{
+    if (redundant)
+        stats.filtered++;
+    else
+        stats.issued++;
+    return redundant;
+}
+
+void GLState::Invalidate()
+{
+    program       = Unknown;
+    vertexArray   = Unknown;
+    elementBuffer = Unknown;
+    framebuffer   = Unknown;
+    buffers.fill(Unknown);
+    vertexArrayElements.Clear();
+    vertexBuffers.Clear();
+
+    uniformRanges.fill(BufferRange());
+    storageRanges.fill(BufferRange());
+
+    activeTexture = Unknown;
+    textures.fill(TextureBinding());
+    samplers.fill(Unknown);
+
+    blend            = -1;
+    blendSource      = 0;
+    blendDestination = 0;
+    blendEquation    = 0;
+
+    depthTest     = -1;
+    depthWrite    = -1;
+    depthFunction = 0;
+
+    cullFace    = -1;
+    cullMode    = 0;
+    frontFace   = 0;
+    polygonMode = 0;
+    scissorTest = -1;
+    std::fill(viewport, viewport + 4, -1);
+}
+
+void GLState::UseProgram(GLuint newProgram)
+{
+    if (Filter(program == newProgram))
+        return;
+    program = newProgram;
+    GLCall(glUseProgram(program));
+}
+
+void GLState::BindVertexArray(GLuint newVertexArray)
+{
+    if (Filter(vertexArray == newVertexArray))
+        return;
+    vertexArray = newVertexArray;
+    GLCall(glBindVertexArray(vertexArray));
+
+    const GLuint *element = vertexArrayElements.Find(vertexArray);
+    elementBuffer         = element != nullptr ? *element : Unknown;
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (Filter(vertexArray != Unknown && elementBuffer == buffer))
+            return;
+        elementBuffer = buffer;
+        if (vertexArray != Unknown)
+            vertexArrayElements.Insert(vertexArray, buffer);
+        GLCall(glBindBuffer(target, buffer));
+        return;
+    }
+
+    int slot = TargetSlot(target);
+    if (Filter(slot >= 0 && buffers[slot] == buffer))
+        return;
+    if (slot >= 0)
+        buffers[slot] = buffer;
+    GLCall(glBindBuffer(target, buffer));
+}
+
+void GLState::VertexArrayVertexBuffer(GLuint vertexArray, GLuint bindingIndex,
+                                      GLuint buffer, GLintptr offset,
+                                      GLsizei stride)
+{
+    if (bindingIndex < 16)
+    {
+        std::uint32_t key = VertexBufferKey(vertexArray, bindingIndex);
+        const VertexBufferBinding *bound = vertexBuffers.Find(key);
+        if (Filter(bound != nullptr && bound->buffer == buffer &&
+                   bound->offset == offset && bound->stride == stride))
+            return;
+        vertexBuffers.Insert(key, {buffer, offset, stride});
+    }
+    else
+        Filter(false);
+    GLCall(glVertexArrayVertexBuffer(vertexArray, bindingIndex, buffer, offset,
+                                     stride));
+}
+
+void GLState::VertexArrayElementBuffer(GLuint vertexArray, GLuint buffer)
+{
+    const GLuint *bound = vertexArrayElements.Find(vertexArray);
+    if (Filter(bound != nullptr && *bound == buffer))
+        return;
+    vertexArrayElements.Insert(vertexArray, buffer);
+    if (vertexArray == this->vertexArray)
+        elementBuffer = buffer;
+    GLCall(glVertexArrayElementBuffer(vertexArray, buffer));
+}
+
+std::array<GLState::BufferRange, GLState::MaxBufferBindings> *
+    GLState::IndexedRanges(GLenum target)
+{
+    switch (target)
+    {
+        case GL_UNIFORM_BUFFER: return &uniformRanges;
+        case GL_SHADER_STORAGE_BUFFER: return &storageRanges;
+        default: return nullptr;
+    }
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    auto ranges = IndexedRanges(target);
+    int  slot   = TargetSlot(target);
+    if (ranges != nullptr && index < ranges->size())
+    {
+        BufferRange &range = (*ranges)[index];
+        if (Filter(range.buffer == buffer && range.offset == 0 &&
+                   range.size == 0))
+            return;
+        range = {buffer, 0, 0};
+    }
+    else
+        Filter(false);
+
+    // Indexed binds replace the generic binding as well
+    if (slot >= 0)
+        buffers[slot] = buffer;
+    GLCall(glBindBufferBase(target, index, buffer));
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                              GLintptr offset, GLsizeiptr size)
+{
+    auto ranges = IndexedRanges(target);
+    int  slot   = TargetSlot(target);
+    if (ranges != nullptr && index < ranges->size())
+    {
+        BufferRange &range = (*ranges)[index];
+        if (Filter(range.buffer == buffer && range.offset == offset &&
+                   range.size == size))
+            return;
+        range = {buffer, offset, size};
+    }
+    else
+        Filter(false);
+
+    if (slot >= 0)
+        buffers[slot] = buffer;
+    GLCall(glBindBufferRange(target, index, buffer, offset, size));
+}
+
+void GLState::BindFramebuffer(GLuint newFramebuffer)
+{
+    if (Filter(framebuffer == newFramebuffer))
+        return;
+    framebuffer = newFramebuffer;
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+}
+
+void GLState::SelectTextureUnit(GLuint unit)
+{
+    if (Filter(activeTexture == unit))
+        return;
+    activeTexture = unit;
+    GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+}
+
+void GLState::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    if (unit >= MaxTextureUnits)
+    {
+        Filter(false);
+        GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+        GLCall(glBindTexture(target, texture));
+        activeTexture = unit;
+        return;
+    }
+
+    TextureBinding &binding = textures[unit];
+    if (Filter(binding.target == target && binding.texture == texture))
+        return;
+    binding = {target, texture};
+    SelectTextureUnit(unit);
+    GLCall(glBindTexture(target, texture));
+}
+
+void GLState::BindSampler(GLuint unit, GLuint sampler)
+{
+    if (Filter(unit < MaxTextureUnits && samplers[unit] == sampler))
+        return;
+    if (unit < MaxTextureUnits)
+        samplers[unit] = sampler;
+    GLCall(glBindSampler(unit, sampler));
+}
+
+void GLState::SetCapability(GLenum capability, std::int8_t &cached,
+                            bool enabled)
+{
+    if (Filter(cached == std::int8_t(enabled)))
+        return;
+    cached = std::int8_t(enabled);
+    if (enabled)
+    {
+        GLCall(glEnable(capability));
+    }
+    else
+    {
+        GLCall(glDisable(capability));
+    }
+}
+
+void GLState::SetBlend(bool enabled)
+{
+    SetCapability(GL_BLEND, blend, enabled);
+}
+
+void GLState::SetBlendFunction(GLenum source, GLenum destination)
+{
+    if (Filter(blendSource == source && blendDestination == destination))
+        return;
+    blendSource      = source;
+    blendDestination = destination;
+    GLCall(glBlendFunc(source, destination));
+}
+
+void GLState::SetBlendEquation(GLenum equation)
+{
+    if (Filter(blendEquation == equation))
+        return;
+    blendEquation = equation;
+    GLCall(glBlendEquation(equation));
+}
+
+void GLState::SetDepthTest(bool enabled)
+{
+    SetCapability(GL_DEPTH_TEST, depthTest, enabled);
+}
+
+void GLState::SetDepthWrite(bool enabled)
+{
+    if (Filter(depthWrite == std::int8_t(enabled)))
+        return;
+    depthWrite = std::int8_t(enabled);
+    GLCall(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+}
+
+void GLState::SetDepthFunction(GLenum function)
+{
+    if (Filter(depthFunction == function))
+        return;
+    depthFunction = function;
+    GLCall(glDepthFunc(function));
+}
+
+void GLState::SetCullFace(bool enabled)
+{
+    SetCapability(GL_CULL_FACE, cullFace, enabled);
+}
+
+void GLState::SetCullMode(GLenum mode)
+{
+    if (Filter(cullMode == mode))
+        return;
+    cullMode = mode;
+    GLCall(glCullFace(mode));
+}
+
+void GLState::SetFrontFace(GLenum winding)
+{
+    if (Filter(frontFace == winding))
+        return;
+    frontFace = winding;
+    GLCall(glFrontFace(winding));
+}
+
+void GLState::SetPolygonMode(GLenum mode)
+{
+    if (Filter(polygonMode == mode))
+        return;
+    polygonMode = mode;
+    GLCall(glPolygonMode(GL_FRONT_AND_BACK, mode));
+}
+
+void GLState::SetScissorTest(bool enabled)
+{
+    SetCapability(GL_SCISSOR_TEST, scissorTest, enabled);
+}
+
+void GLState::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (Filter(viewport[0] == x && viewport[1] == y && viewport[2] == width &&
+               viewport[3] == height))
+        return;
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    GLCall(glViewport(x, y, width, height));
+}
+
+void GLState::ForgetProgram(GLuint oldProgram)
+{
+    if (program == oldProgram)
+        program = Unknown;
+}
+
+void GLState::ForgetVertexArray(GLuint oldVertexArray)
+{
+    if (vertexArray == oldVertexArray)
+    {
+        vertexArray   = Unknown;
+        elementBuffer = Unknown;
+    }
+    // The name may come back as a new vertex array without buffers
+    if (vertexArrayElements.Find(oldVertexArray) != nullptr)
+        vertexArrayElements.Insert(oldVertexArray, Unknown);
+    for (GLuint index = 0; index < 16; index++)
+        if (vertexBuffers.Find(VertexBufferKey(oldVertexArray, index)) !=
+            nullptr)
+            vertexBuffers.Insert(VertexBufferKey(oldVertexArray, index),
+                                 VertexBufferBinding());
+}
+
+void GLState::ForgetBuffer(GLuint buffer)
+{
+    // Vertex arrays other than the bound one keep deleted buffers attached,
+    // simply forget them all as deletes are rare
+    elementBuffer = Unknown;
+    vertexArrayElements.Clear();
+    vertexBuffers.Clear();
+    for (auto &bound : buffers)
+        if (bound == buffer)
+            bound = Unknown;
+    for (auto &range : uniformRanges)
+        if (range.buffer == buffer)
+            range = BufferRange();
+    for (auto &range : storageRanges)
+        if (range.buffer == buffer)
+            range = BufferRange();
+}
+
+void GLState::ForgetFramebuffer(GLuint oldFramebuffer)
+{
+    if (framebuffer == oldFramebuffer)
+        framebuffer = Unknown;
+}
+
+void GLState::ForgetTexture(GLuint texture)
+{
+    for (auto &binding : textures)
+        if (binding.texture == texture)
+            binding = TextureBinding();
+}
+
+void GLState::ForgetSampler(GLuint sampler)
+{
+    for (auto &bound : samplers)
+        if (bound == sampler)
+            bound = Unknown;
+}
+
+GLuint GLState::GetProgram() const { return program; }
+
+GLuint GLState::GetVertexArray() const { return vertexArray; }
+
+const GLStateStats &GLState::GetStats() const { return stats; }
+
+void GLState::ResetStats() { stats = GLStateStats(); }
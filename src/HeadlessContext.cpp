@@ -0,0 +1,146 @@
+#include "HeadlessContext.hpp"
+
+#include <GL/glew.h>
+
+// Only the platform independent types are needed
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+static bool HasExtension(const char *extensions, const char *name)
+{
+    if (extensions == nullptr)
+        return false;
+    // A whole word of the list, not the start of a longer name
+    std::size_t length = std::strlen(name);
+    const char *found  = std::strstr(extensions, name);
+    while (found != nullptr)
+    {
+        if ((found == extensions || found[-1] == ' ') &&
+            (found[length] == ' ' || found[length] == '\0'))
+            return true;
+        found = std::strstr(found + length, name);
+    }
+    return false;
+}
+
+// The surfaceless platform if Mesa has it, which needs no device node,
+// otherwise the first device
+static EGLDisplay OpenDisplay()
+{
+    const char *clientExtensions =
+        eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay == nullptr)
+        return EGL_NO_DISPLAY;
+
+    if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                                EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY &&
+            eglInitialize(display, nullptr, nullptr))
+            return display;
+    }
+
+    auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+        eglGetProcAddress("eglQueryDevicesEXT"));
+    EGLDeviceEXT device      = nullptr;
+    EGLint       deviceCount = 0;
+    if (HasExtension(clientExtensions, "EGL_EXT_platform_device") &&
+        queryDevices != nullptr && queryDevices(1, &device, &deviceCount) &&
+        deviceCount > 0)
+    {
+        EGLDisplay display =
+            getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+        if (display != EGL_NO_DISPLAY &&
+            eglInitialize(display, nullptr, nullptr))
+            return display;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+HeadlessContext::HeadlessContext()
+    : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT)
+{
+}
+
+HeadlessContext::~HeadlessContext() { ClearContext(); }
+
+bool HeadlessContext::CreateContext(int major, int minor)
+{
+    ClearContext();
+    display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY)
+    {
+        std::cerr << "No EGL display to create a headless context on"
+                  << std::endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "EGL cannot create OpenGL contexts" << std::endl;
+        ClearContext();
+        return false;
+    }
+
+    // Nothing is drawn to a surface, so any OpenGL config will do, or none
+    // where the driver allows it
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                       EGL_NONE};
+    EGLConfig config      = nullptr;
+    EGLint    configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1,
+                         &configCount) ||
+        configCount == 0)
+        config = EGL_NO_CONFIG_KHR;
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,
+        major,
+        EGL_CONTEXT_MINOR_VERSION,
+        minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                               contextAttributes);
+    if (context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cerr << "OpenGL " << major << "." << minor
+                  << " is required, EGL error 0x" << std::hex
+                  << eglGetError() << std::dec << std::endl;
+        ClearContext();
+        return false;
+    }
+
+    // GLEW built for GLX loads every function, then fails to find a GLX
+    // display, which an EGL context does not need
+    glewExperimental = GL_TRUE;
+    GLenum error     = glewInit();
+    if (error != GLEW_OK && error != GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+        std::cerr << "Failed to initialize GLEW: "
+                  << glewGetErrorString(error) << std::endl;
+        ClearContext();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::ClearContext()
+{
+    if (display == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+}
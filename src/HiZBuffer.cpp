@@ -0,0 +1,93 @@
+#include "HiZBuffer.hpp"
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+#include "Shader.hpp"
+#include "StringHash.hpp"
+
+#include <algorithm>
+
+HiZBuffer::HiZBuffer()
+    : texture(0), width(0), height(0), levelCount(0), valid(false),
+      state(nullptr)
+{
+}
+
+HiZBuffer::~HiZBuffer() { ClearHiZ(); }
+
+void HiZBuffer::CreateHiZ(GLState &glState, GLsizei hiZWidth,
+                          GLsizei hiZHeight)
+{
+    ClearHiZ();
+    state  = &glState;
+    width  = hiZWidth;
+    height = hiZHeight;
+
+    // Down to a single texel
+    levelCount = 1;
+    for (GLsizei size = std::max(width, height); size > 1; size /= 2)
+        levelCount++;
+
+    GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &texture));
+    GLCall(glTextureStorage2D(texture, levelCount, GL_R32F, width, height));
+    // Culling picks its level explicitly, and must never blend depths
+    GLCall(glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER,
+                               GL_NEAREST_MIPMAP_NEAREST));
+    GLCall(glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+}
+
+void HiZBuffer::ClearHiZ()
+{
+    if (texture == 0)
+        return;
+    state->ForgetTexture(texture);
+    GLCall(glDeleteTextures(1, &texture));
+    texture = 0;
+    width = height = levelCount = 0;
+    valid                       = false;
+}
+
+void HiZBuffer::Build(Shader &hiZShader, GLuint depthTexture)
+{
+    if (texture == 0)
+        return;
+
+    hiZShader.SetInUse(*state);
+    state->BindTexture(0, GL_TEXTURE_2D, depthTexture);
+
+    for (GLsizei level = 0; level < levelCount; level++)
+    {
+        GLsizei levelWidth  = std::max(1, width >> level);
+        GLsizei levelHeight = std::max(1, height >> level);
+
+        // Level 0 is a copy of the depth, the rest reduce the one above,
+        // which the previous dispatch must have finished writing
+        hiZShader.SetUniform(HashName("u_CopyDepth"), level == 0 ? 1 : 0);
+        if (level > 0)
+        {
+            GLCall(glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT));
+            GLCall(glBindImageTexture(1, texture, level - 1, GL_FALSE, 0,
+                                      GL_READ_ONLY, GL_R32F));
+        }
+        GLCall(glBindImageTexture(0, texture, level, GL_FALSE, 0,
+                                  GL_WRITE_ONLY, GL_R32F));
+
+        hiZShader.Dispatch((levelWidth + GroupSize - 1) / GroupSize,
+                           (levelHeight + GroupSize - 1) / GroupSize);
+    }
+
+    // Culling samples it next
+    GLCall(glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT));
+    valid = true;
+}
+
+bool HiZBuffer::IsValid() const { return valid; }
+
+GLuint HiZBuffer::GetTexture() const { return texture; }
+
+GLsizei HiZBuffer::GetWidth() const { return width; }
+
+GLsizei HiZBuffer::GetHeight() const { return height; }
+
+GLsizei HiZBuffer::GetLevelCount() const { return levelCount; }
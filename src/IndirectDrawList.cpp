@@ -0,0 +1,176 @@
+#include "IndirectDrawList.hpp"
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+IndirectDrawList::IndirectDrawList()
+    : commandBuffer(0), objectBuffer(0), meshBuffer(0), drawIDBuffer(0),
+      capacity(0), state(nullptr)
+{
+}
+
+IndirectDrawList::~IndirectDrawList() { ClearList(); }
+
+void IndirectDrawList::CreateBuffers(std::size_t drawCapacity)
+{
+    DeleteBuffers();
+    capacity = drawCapacity;
+
+    // Rewritten every frame, orphaned through glNamedBufferData
+    GLCall(glCreateBuffers(1, &commandBuffer));
+    GLCall(glNamedBufferData(commandBuffer,
+                             capacity * sizeof(DrawElementsIndirectCommand),
+                             nullptr, GL_STREAM_DRAW));
+    GLCall(glCreateBuffers(1, &objectBuffer));
+    GLCall(glNamedBufferData(objectBuffer, capacity * sizeof(ObjectConstants),
+                             nullptr, GL_STREAM_DRAW));
+    GLCall(glCreateBuffers(1, &meshBuffer));
+    GLCall(glNamedBufferData(meshBuffer, capacity * sizeof(GLuint), nullptr,
+                             GL_STREAM_DRAW));
+
+    // Never changes, draw i reads element i
+    auto drawIDs = std::vector<GLuint>(capacity);
+    std::iota(drawIDs.begin(), drawIDs.end(), 0u);
+    GLCall(glCreateBuffers(1, &drawIDBuffer));
+    GLCall(glNamedBufferStorage(drawIDBuffer, capacity * sizeof(GLuint),
+                                drawIDs.data(), 0));
+}
+
+void IndirectDrawList::DeleteBuffers()
+{
+    if (commandBuffer == 0)
+        return;
+    for (GLuint buffer : {commandBuffer, objectBuffer, meshBuffer,
+                          drawIDBuffer})
+        state->ForgetBuffer(buffer);
+    GLCall(glDeleteBuffers(1, &commandBuffer));
+    GLCall(glDeleteBuffers(1, &objectBuffer));
+    GLCall(glDeleteBuffers(1, &meshBuffer));
+    GLCall(glDeleteBuffers(1, &drawIDBuffer));
+    commandBuffer = objectBuffer = meshBuffer = drawIDBuffer = 0;
+    capacity                                                 = 0;
+}
+
+void IndirectDrawList::CreateList(GLState &glState, std::size_t drawCapacity)
+{
+    state = &glState;
+    CreateBuffers(std::max<std::size_t>(1, drawCapacity));
+}
+
+void IndirectDrawList::ClearList()
+{
+    DeleteBuffers();
+    commands.clear();
+    objects.clear();
+    meshes.clear();
+    state = nullptr;
+}
+
+void IndirectDrawList::BeginFrame(std::size_t drawCount)
+{
+    // Grow geometrically, like the uniform ring
+    if (drawCount > capacity)
+        CreateBuffers(std::max(drawCount, capacity * 2));
+    commands.resize(drawCount);
+    objects.resize(drawCount);
+    meshes.resize(drawCount);
+}
+
+void IndirectDrawList::SetDraw(std::size_t index, const MeshRange &range,
+                               const ObjectConstants &constants)
+{
+    DrawElementsIndirectCommand &command = commands[index];
+
+    command.count         = range.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex    = range.firstIndex;
+    command.baseVertex    = range.baseVertex;
+    command.baseInstance  = GLuint(index); // Selects draw ID i
+    objects[index]        = constants;
+    meshes[index]         = range.mesh;
+}
+
+void IndirectDrawList::Flush()
+{
+    if (commands.empty())
+        return;
+    // Whole-buffer writes into fresh storage, the previous frame's draws
+    // are not waited on
+    GLCall(glNamedBufferData(commandBuffer,
+                             capacity * sizeof(DrawElementsIndirectCommand),
+                             nullptr, GL_STREAM_DRAW));
+    GLCall(glNamedBufferSubData(commandBuffer, 0,
+                                commands.size() *
+                                    sizeof(DrawElementsIndirectCommand),
+                                commands.data()));
+    GLCall(glNamedBufferData(objectBuffer, capacity * sizeof(ObjectConstants),
+                             nullptr, GL_STREAM_DRAW));
+    GLCall(glNamedBufferSubData(objectBuffer, 0,
+                                objects.size() * sizeof(ObjectConstants),
+                                objects.data()));
+    GLCall(glNamedBufferData(meshBuffer, capacity * sizeof(GLuint), nullptr,
+                             GL_STREAM_DRAW));
+    GLCall(glNamedBufferSubData(meshBuffer, 0, meshes.size() * sizeof(GLuint),
+                                meshes.data()));
+}
+
+void IndirectDrawList::BindForDraw(MeshPool &pool)
+{
+    state->VertexArrayVertexBuffer(pool.GetVertexArray(),
+                                   MeshPool::DrawIDBinding, drawIDBuffer, 0,
+                                   sizeof(GLuint));
+    pool.Bind();
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, ObjectDataBinding,
+                          objectBuffer);
+    if (pool.IsPullingVertices())
+        state->BindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                              MeshPool::DrawMeshBinding, meshBuffer);
+}
+
+void IndirectDrawList::Draw(MeshPool &pool)
+{
+    if (commands.empty())
+        return;
+
+    BindForDraw(pool);
+    state->BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                       GLsizei(commands.size()), 0));
+}
+
+void IndirectDrawList::Draw(MeshPool &pool, GLuint drawCommands,
+                            GLuint countBuffer)
+{
+    if (commands.empty())
+        return;
+
+    BindForDraw(pool);
+    state->BindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommands);
+    if (!HasIndirectParameters())
+    {
+        GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                           nullptr,
+                                           GLsizei(commands.size()), 0));
+        return;
+    }
+
+    state->BindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+    if (GLEW_VERSION_4_6)
+    {
+        GLCall(glMultiDrawElementsIndirectCount(
+            GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0,
+            GLsizei(commands.size()), 0));
+    }
+    else
+    {
+        GLCall(glMultiDrawElementsIndirectCountARB(
+            GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0,
+            GLsizei(commands.size()), 0));
+    }
+}
+
+std::size_t IndirectDrawList::GetDrawCount() const { return commands.size(); }
+
+GLuint IndirectDrawList::GetCommandBuffer() const { return commandBuffer; }
@@ -0,0 +1,217 @@
+#include "JobSystem.hpp"
+
+#include <cassert>
+#include <chrono>
+
+// Identifies the job system worker running on this thread
+static thread_local const JobSystem *currentSystem = nullptr;
+static thread_local std::size_t      currentIndex  = 0;
+
+// Job slots per worker, see Worker::pool
+static constexpr std::size_t PoolSize = JobSystem::MaxQueuedJobs * 4;
+
+// Failed searches for work before an idle worker goes to sleep
+static constexpr int IdleSpins = 64;
+
+JobCounter::JobCounter() : pending(0) {}
+
+JobCounter::~JobCounter() {}
+
+bool JobCounter::IsDone() const
+{
+    return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(std::size_t workerThreads)
+    : running(true), queuedJobs(0), sleepingWorkers(0)
+{
+    for (std::size_t i = 0; i <= workerThreads; i++)
+    {
+        auto worker  = std::make_unique<Worker>();
+        worker->pool = std::make_unique<JobSlot[]>(PoolSize);
+        workers.push_back(std::move(worker));
+    }
+
+    currentSystem = this;
+    currentIndex  = 0;
+
+    // Only start the threads once every deque exists, they steal from all
+    for (std::size_t i = 1; i <= workerThreads; i++)
+        workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    sleepCondition.notify_all();
+    for (auto &worker : workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+
+    if (currentSystem == this)
+        currentSystem = nullptr;
+}
+
+std::size_t JobSystem::CurrentWorker() const
+{
+    assert(currentSystem == this &&
+           "Jobs may only be started by the job system's own threads");
+    return currentIndex;
+}
+
+void JobSystem::Run(const Job *jobs, std::size_t count, JobCounter &counter)
+{
+    counter.pending.fetch_add(count, std::memory_order_relaxed);
+
+    std::size_t index  = CurrentWorker();
+    Worker &    worker = *workers[index];
+    for (std::size_t i = 0; i < count; i++)
+    {
+        JobSlot *slot     = AcquireSlot(worker);
+        slot->job         = jobs[i];
+        slot->job.counter = &counter;
+
+        if (worker.deque.Push(slot))
+            queuedJobs.fetch_add(1, std::memory_order_release);
+        else
+            Execute(index, slot); // Deque is full, just run it here
+    }
+
+    if (sleepingWorkers.load(std::memory_order_acquire) > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (count > 1)
+            sleepCondition.notify_all();
+        else
+            sleepCondition.notify_one();
+    }
+}
+
+void JobSystem::Run(const Job &job, JobCounter &counter)
+{
+    Run(&job, 1, counter);
+}
+
+JobSystem::JobSlot *JobSystem::AcquireSlot(Worker &worker)
+{
+    // Slots can stay queued for a long time, the first half a ParallelFor
+    // offers is the last one it gets back to, so skip over the busy ones
+    JobSlot *slot;
+    do
+        slot = &worker.pool[worker.poolIndex++ & (PoolSize - 1)];
+    while (slot->busy.load(std::memory_order_acquire));
+    slot->busy.store(true, std::memory_order_relaxed);
+    return slot;
+}
+
+JobSystem::JobSlot *JobSystem::FindJob(std::size_t index)
+{
+    JobSlot *job = workers[index]->deque.Pop();
+    if (job == nullptr)
+    {
+        // Try every other worker once, starting after ourselves so the
+        // thieves spread out
+        for (std::size_t i = 1; i < workers.size() && job == nullptr; i++)
+            job = workers[(index + i) % workers.size()]->deque.Steal();
+    }
+    if (job != nullptr)
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::Execute(std::size_t index, JobSlot *slot)
+{
+    // Copy the job out and free the slot for its worker to reuse
+    Job local = slot->job;
+    slot->busy.store(false, std::memory_order_release);
+
+    if (local.dependency != nullptr)
+        Wait(*local.dependency);
+
+    local.function(*this, local);
+    local.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(std::size_t index)
+{
+    currentSystem = this;
+    currentIndex  = index;
+
+    int idle = 0;
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (JobSlot *job = FindJob(index))
+        {
+            Execute(index, job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < IdleSpins)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Nothing to do for a while, sleep until jobs are queued. The
+        // timeout covers a notify racing the check of the predicate.
+        sleepingWorkers.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait_for(
+                lock, std::chrono::milliseconds(1), [this] {
+                    return queuedJobs.load(std::memory_order_acquire) > 0 ||
+                           !running.load(std::memory_order_relaxed);
+                });
+        }
+        sleepingWorkers.fetch_sub(1, std::memory_order_acq_rel);
+        idle = 0;
+    }
+}
+
+void JobSystem::Wait(const JobCounter &counter)
+{
+    std::size_t index = CurrentWorker();
+    while (!counter.IsDone())
+    {
+        if (JobSlot *job = FindJob(index))
+            Execute(index, job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelForJob(JobSystem &jobs, const Job &job)
+{
+    auto        context = static_cast<const ParallelForContext *>(job.data);
+    auto &      deque   = jobs.workers[jobs.CurrentWorker()]->deque;
+    bool        alone   = jobs.workers.size() == 1;
+    std::size_t begin   = job.begin;
+    std::size_t end     = job.end;
+
+    while (begin < end)
+    {
+        // Offer the upper half of what is left only once the deque is
+        // empty, so ranges are split about as often as they are stolen
+        // rather than all the way down to the grain up front
+        if (!alone && end - begin > context->grain && deque.GetSize() == 0)
+        {
+            std::size_t middle = begin + (end - begin) / 2;
+            Job         half   = job;
+            half.begin         = middle;
+            half.end           = end;
+            jobs.Run(half, *job.counter);
+            end = middle;
+            continue;
+        }
+
+        std::size_t chunk = std::min(end, begin + context->grain);
+        context->invoke(context->func, begin, chunk);
+        begin = chunk;
+    }
+}
+
+std::size_t JobSystem::GetThreadCount() const { return workers.size(); }
@@ -0,0 +1,267 @@
+#include "JsonDocument.hpp"
+
+JsonDocument::JsonDocument() : position(0) {}
+
+JsonDocument::~JsonDocument() {}
+
+void JsonDocument::SkipSpace()
+{
+    while (position < text.size() &&
+           (text[position] == ' ' || text[position] == '\t' ||
+            text[position] == '\n' || text[position] == '\r'))
+        position++;
+}
+
+bool JsonDocument::Fail(const char *message)
+{
+    // Only the first error is kept, the rest follow from it
+    if (error.empty())
+    {
+        std::size_t line = 1;
+        for (std::size_t i = 0; i < position && i < text.size(); i++)
+            if (text[i] == '\n')
+                line++;
+        error = std::string(message) + " on line " + std::to_string(line);
+    }
+    return false;
+}
+
+bool JsonDocument::ParseString(std::string_view &result)
+{
+    // position is on the opening quote
+    std::size_t start   = ++position;
+    bool        escaped = false;
+    while (position < text.size() && text[position] != '"')
+    {
+        if (text[position] == '\\')
+        {
+            escaped = true;
+            position++;
+        }
+        position++;
+    }
+    if (position >= text.size())
+        return Fail("Unterminated string");
+    result = text.substr(start, position - start);
+    position++;
+    if (!escaped)
+        return true;
+
+    // Rare in manifests, so only these strings are copied
+    auto value = std::string();
+    for (std::size_t i = 0; i < result.size(); i++)
+    {
+        char c = result[i];
+        if (c != '\\' || i + 1 >= result.size())
+        {
+            value += c;
+            continue;
+        }
+        switch (result[++i])
+        {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'u':
+            {
+                // Paths and names are ASCII, anything else is kept as UTF-8
+                if (i + 4 >= result.size())
+                    return Fail("Malformed \\u escape");
+                unsigned code = 0;
+                for (int d = 0; d < 4; d++)
+                {
+                    char h = result[++i];
+                    code <<= 4;
+                    if (h >= '0' && h <= '9')
+                        code |= unsigned(h - '0');
+                    else if (h >= 'a' && h <= 'f')
+                        code |= unsigned(h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F')
+                        code |= unsigned(h - 'A' + 10);
+                    else
+                        return Fail("Malformed \\u escape");
+                }
+                if (code < 0x80)
+                    value += char(code);
+                else if (code < 0x800)
+                {
+                    value += char(0xC0 | (code >> 6));
+                    value += char(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    value += char(0xE0 | (code >> 12));
+                    value += char(0x80 | ((code >> 6) & 0x3F));
+                    value += char(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: value += result[i]; break;
+        }
+    }
+    unescaped.push_back(std::move(value));
+    result = unescaped.back();
+    return true;
+}
+
+bool JsonDocument::ParseContainer(std::uint32_t index, int depth)
+{
+    bool object = values[index].type == JsonType::Object;
+    char close  = object ? '}' : ']';
+    position++;
+    SkipSpace();
+    if (position < text.size() && text[position] == close)
+    {
+        position++;
+        return true;
+    }
+
+    std::uint32_t last = JsonValue::None;
+    while (true)
+    {
+        auto key = std::string_view();
+        if (object)
+        {
+            SkipSpace();
+            if (position >= text.size() || text[position] != '"')
+                return Fail("Expected a member name");
+            if (!ParseString(key))
+                return false;
+            SkipSpace();
+            if (position >= text.size() || text[position] != ':')
+                return Fail("Expected ':'");
+            position++;
+        }
+
+        std::uint32_t child = ParseValue(depth + 1);
+        if (child == JsonValue::None)
+            return false;
+        values[child].key = key;
+        if (last == JsonValue::None)
+            values[index].firstChild = child;
+        else
+            values[last].nextSibling = child;
+        last = child;
+
+        SkipSpace();
+        if (position >= text.size())
+            return Fail("Unexpected end of file");
+        if (text[position] == ',')
+        {
+            position++;
+            continue;
+        }
+        if (text[position] == close)
+        {
+            position++;
+            return true;
+        }
+        return Fail(object ? "Expected ',' or '}'" : "Expected ',' or ']'");
+    }
+}
+
+std::uint32_t JsonDocument::ParseValue(int depth)
+{
+    if (depth > MaxDepth)
+    {
+        Fail("Nested too deeply");
+        return JsonValue::None;
+    }
+    SkipSpace();
+    if (position >= text.size())
+    {
+        Fail("Unexpected end of file");
+        return JsonValue::None;
+    }
+
+    // Values are appended before their children, so the root is 0
+    auto index = std::uint32_t(values.size());
+    values.push_back(JsonValue());
+    char c = text[position];
+    if (c == '{' || c == '[')
+    {
+        values[index].type = c == '{' ? JsonType::Object : JsonType::Array;
+        if (!ParseContainer(index, depth))
+            return JsonValue::None;
+    }
+    else if (c == '"')
+    {
+        values[index].type = JsonType::String;
+        auto result        = std::string_view();
+        if (!ParseString(result))
+            return JsonValue::None;
+        values[index].text = result;
+    }
+    else
+    {
+        // Numbers and literals run until the next delimiter
+        std::size_t start = position;
+        while (position < text.size() && text[position] != ',' &&
+               text[position] != '}' && text[position] != ']' &&
+               text[position] != ' ' && text[position] != '\t' &&
+               text[position] != '\n' && text[position] != '\r')
+            position++;
+        auto word          = text.substr(start, position - start);
+        values[index].text = word;
+        if (word == "true" || word == "false")
+            values[index].type = JsonType::Bool;
+        else if (word == "null")
+            values[index].type = JsonType::Null;
+        else if (!word.empty() &&
+                 (word[0] == '-' || (word[0] >= '0' && word[0] <= '9')))
+            values[index].type = JsonType::Number;
+        else
+        {
+            Fail("Unexpected character");
+            return JsonValue::None;
+        }
+    }
+    return index;
+}
+
+bool JsonDocument::Parse(std::string_view json)
+{
+    values.clear();
+    unescaped.clear();
+    error.clear();
+    text     = json;
+    position = 0;
+
+    if (ParseValue(0) == JsonValue::None)
+        return false;
+    SkipSpace();
+    if (position < text.size())
+        return Fail("Unexpected text after the root value");
+    return true;
+}
+
+const std::string &JsonDocument::GetError() const { return error; }
+
+const JsonValue &JsonDocument::Get(std::uint32_t index) const
+{
+    return values[index];
+}
+
+std::uint32_t JsonDocument::Find(std::uint32_t    object,
+                                 std::string_view key) const
+{
+    if (object >= values.size() || values[object].type != JsonType::Object)
+        return JsonValue::None;
+    for (std::uint32_t child = values[object].firstChild;
+         child != JsonValue::None; child = values[child].nextSibling)
+        if (values[child].key == key)
+            return child;
+    return JsonValue::None;
+}
+
+bool JsonDocument::FindString(std::uint32_t object, std::string_view key,
+                              std::string_view &result) const
+{
+    std::uint32_t member = Find(object, key);
+    if (member == JsonValue::None || values[member].type != JsonType::String)
+        return false;
+    result = values[member].text;
+    return true;
+}
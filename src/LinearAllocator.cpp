@@ -0,0 +1,52 @@
+#include "LinearAllocator.hpp"
+
+#include <algorithm>
+
+LinearAllocator::LinearAllocator(std::size_t size)
+    : currentBlock(0), offset(0), blockSize(size)
+{
+}
+
+LinearAllocator::~LinearAllocator() {}
+
+void *LinearAllocator::Allocate(std::size_t size, std::size_t alignment)
+{
+    while (currentBlock < blocks.size())
+    {
+        Block &        block = blocks[currentBlock];
+        std::uintptr_t base =
+            reinterpret_cast<std::uintptr_t>(block.memory.get());
+        std::size_t aligned = ((base + offset + alignment - 1) &
+                               ~(std::uintptr_t(alignment) - 1)) -
+                              base;
+        if (aligned + size <= block.size)
+        {
+            offset = aligned + size;
+            return block.memory.get() + aligned;
+        }
+        // Move on to the next block, the tail of this one is wasted
+        currentBlock++;
+        offset = 0;
+    }
+
+    // Out of blocks, oversized requests get a block of their own
+    std::size_t newSize = std::max(blockSize, size + alignment);
+    blocks.push_back({std::make_unique<std::uint8_t[]>(newSize), newSize});
+    currentBlock = blocks.size() - 1;
+    offset       = 0;
+    return Allocate(size, alignment);
+}
+
+void LinearAllocator::Reset()
+{
+    currentBlock = 0;
+    offset       = 0;
+}
+
+std::size_t LinearAllocator::GetCapacity() const
+{
+    std::size_t capacity = 0;
+    for (auto const &block : blocks)
+        capacity += block.size;
+    return capacity;
+}
@@ -0,0 +1,367 @@
+#include "ManifestIndex.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "StringHash.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The file is a header followed by the manifest, shadelet and keyword
+// records, then every string the records point at
+namespace
+{
+    // Bumped whenever the file layout changes
+    constexpr std::uint32_t IndexVersion = 1;
+
+    struct IndexHeader
+    {
+    public:
+        char          magic[4];
+        std::uint32_t version;
+        std::uint32_t manifestCount;
+        std::uint32_t shadeletCount;
+        std::uint32_t keywordCount;
+        std::uint32_t stringBytes;
+    };
+
+    struct StringRef
+    {
+    public:
+        std::uint32_t offset; // Into the strings
+        std::uint32_t length;
+    };
+
+    struct ManifestRecord
+    {
+    public:
+        std::int64_t  modified;
+        std::uint64_t size;
+        std::uint64_t hash;
+        StringRef     path;
+        StringRef     name;
+        std::uint32_t firstKeyword;
+        std::uint32_t keywordCount;
+        std::uint32_t firstShadelet;
+        std::uint32_t shadeletCount;
+        std::uint32_t complete;
+        std::uint32_t padding;
+    };
+
+    struct ShadeletRecord
+    {
+    public:
+        StringRef     path;
+        std::uint32_t type;
+    };
+
+    // Where each part of a file with this header starts, and its total size
+    struct IndexLayout
+    {
+    public:
+        std::size_t manifests;
+        std::size_t shadelets;
+        std::size_t keywords;
+        std::size_t strings;
+        std::size_t size;
+    };
+
+    IndexLayout GetLayout(const IndexHeader &header)
+    {
+        auto layout      = IndexLayout();
+        layout.manifests = sizeof(IndexHeader);
+        layout.shadelets =
+            layout.manifests + header.manifestCount * sizeof(ManifestRecord);
+        layout.keywords =
+            layout.shadelets + header.shadeletCount * sizeof(ShadeletRecord);
+        layout.strings =
+            layout.keywords + header.keywordCount * sizeof(StringRef);
+        layout.size = layout.strings + header.stringBytes;
+        return layout;
+    }
+
+    IndexHeader ReadHeader(const char *data)
+    {
+        auto header = IndexHeader();
+        std::memcpy(&header, data, sizeof(header));
+        return header;
+    }
+
+    const ManifestRecord &GetRecord(const char *data, std::uint32_t record)
+    {
+        return reinterpret_cast<const ManifestRecord *>(
+            data + GetLayout(ReadHeader(data)).manifests)[record];
+    }
+
+    std::int64_t GetModified(const std::string &path, std::error_code &error)
+    {
+        return std::filesystem::last_write_time(path, error)
+            .time_since_epoch()
+            .count();
+    }
+} // namespace
+
+ManifestIndex::ManifestIndex(std::filesystem::path indexPath)
+    : path(std::move(indexPath)), data(nullptr), dataSize(0), mapped(false)
+{
+}
+
+ManifestIndex::~ManifestIndex() { Unload(); }
+
+void ManifestIndex::Unload()
+{
+#ifdef __linux__
+    if (mapped)
+        munmap(const_cast<char *>(data), dataSize);
+#endif
+    entries.clear();
+    buffer.clear();
+    data     = nullptr;
+    dataSize = 0;
+    mapped   = false;
+}
+
+bool ManifestIndex::Load()
+{
+    Unload();
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        void *map = mmap(nullptr, std::size_t(status.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            data     = static_cast<const char *>(map);
+            dataSize = std::size_t(status.st_size);
+            mapped   = true;
+        }
+    }
+    close(fd);
+#endif
+    if (!mapped)
+    {
+        if (!ShaderPreprocessor::ReadFile(path, buffer))
+            return false;
+        data     = buffer.data();
+        dataSize = buffer.size();
+    }
+
+    // Anything that does not add up is treated as no index at all
+    if (dataSize < sizeof(IndexHeader))
+    {
+        Unload();
+        return false;
+    }
+    IndexHeader header = ReadHeader(data);
+    IndexLayout layout = GetLayout(header);
+    if (std::memcmp(header.magic, "GLMI", 4) != 0 ||
+        header.version != IndexVersion || layout.size != dataSize)
+    {
+        Unload();
+        return false;
+    }
+
+    auto manifests =
+        reinterpret_cast<const ManifestRecord *>(data + layout.manifests);
+    auto shadelets =
+        reinterpret_cast<const ShadeletRecord *>(data + layout.shadelets);
+    auto keywords = reinterpret_cast<const StringRef *>(data + layout.keywords);
+    auto inStrings = [&](const StringRef &string) {
+        return std::size_t(string.offset) + string.length <= header.stringBytes;
+    };
+    for (std::uint32_t m = 0; m < header.manifestCount; m++)
+    {
+        const ManifestRecord &record = manifests[m];
+        bool valid = inStrings(record.path) && inStrings(record.name) &&
+                     std::size_t(record.firstKeyword) + record.keywordCount <=
+                         header.keywordCount &&
+                     std::size_t(record.firstShadelet) + record.shadeletCount <=
+                         header.shadeletCount;
+        for (std::uint32_t k = 0; valid && k < record.keywordCount; k++)
+            valid = inStrings(keywords[record.firstKeyword + k]);
+        for (std::uint32_t s = 0; valid && s < record.shadeletCount; s++)
+            valid = inStrings(shadelets[record.firstShadelet + s].path);
+        if (!valid)
+        {
+            std::cerr << "Shader manifest index '" << path.generic_string()
+                      << "' is corrupt, ignoring it" << std::endl;
+            Unload();
+            return false;
+        }
+        entries[std::string_view(data + layout.strings + record.path.offset,
+                                 record.path.length)] = m;
+    }
+    return true;
+}
+
+bool ManifestIndex::Lookup(const std::string &manifestPath,
+                           ShaderManifest &   manifest) const
+{
+    auto found = entries.find(manifestPath);
+    if (found == entries.end())
+        return false;
+
+    IndexLayout           layout = GetLayout(ReadHeader(data));
+    const ManifestRecord &record = GetRecord(data, found->second);
+
+    std::error_code error;
+    std::uint64_t   size = std::filesystem::file_size(manifestPath, error);
+    if (error || size != record.size)
+        return false;
+    std::int64_t modified = GetModified(manifestPath, error);
+    if (error)
+        return false;
+    if (modified != record.modified)
+    {
+        // Checked out or saved again, the contents may still be the same
+        auto text = std::string();
+        if (!ShaderPreprocessor::ReadFile(manifestPath, text) ||
+            HashContent(text) != record.hash)
+            return false;
+    }
+
+    auto strings = data + layout.strings;
+    auto text    = [&](const StringRef &string) {
+        return std::string(strings + string.offset, string.length);
+    };
+    manifest.path     = manifestPath;
+    manifest.name     = text(record.name);
+    manifest.complete = record.complete != 0;
+    manifest.modified = modified;
+    manifest.size     = size;
+    manifest.hash     = record.hash;
+    manifest.keywords.clear();
+    manifest.shadelets.clear();
+    auto keywords = reinterpret_cast<const StringRef *>(data + layout.keywords);
+    for (std::uint32_t k = 0; k < record.keywordCount; k++)
+        manifest.keywords.push_back(text(keywords[record.firstKeyword + k]));
+    auto shadelets =
+        reinterpret_cast<const ShadeletRecord *>(data + layout.shadelets);
+    for (std::uint32_t s = 0; s < record.shadeletCount; s++)
+    {
+        const ShadeletRecord &shadelet = shadelets[record.firstShadelet + s];
+        manifest.shadelets.emplace_back(text(shadelet.path),
+                                        GLenum(shadelet.type));
+    }
+    return true;
+}
+
+bool ManifestIndex::Store(const std::vector<ShaderManifest> &manifests)
+{
+    auto header = IndexHeader();
+    std::memcpy(header.magic, "GLMI", 4);
+    header.version       = IndexVersion;
+    header.manifestCount = 0;
+    header.shadeletCount = 0;
+    header.keywordCount  = 0;
+    header.stringBytes   = 0;
+
+    auto records   = std::vector<ManifestRecord>();
+    auto shadelets = std::vector<ShadeletRecord>();
+    auto keywords  = std::vector<StringRef>();
+    auto strings   = std::string();
+    auto addString = [&](const std::string &string) {
+        auto ref   = StringRef();
+        ref.offset = std::uint32_t(strings.size());
+        ref.length = std::uint32_t(string.size());
+        strings += string;
+        return ref;
+    };
+    bool unchanged = true;
+    for (auto const &manifest : manifests)
+    {
+        if (manifest.path.empty())
+            continue;
+
+        auto record          = ManifestRecord();
+        record.modified      = manifest.modified;
+        record.size          = manifest.size;
+        record.hash          = manifest.hash;
+        record.path          = addString(manifest.path);
+        record.name          = addString(manifest.name);
+        record.firstKeyword  = std::uint32_t(keywords.size());
+        record.keywordCount  = std::uint32_t(manifest.keywords.size());
+        record.firstShadelet = std::uint32_t(shadelets.size());
+        record.shadeletCount = std::uint32_t(manifest.shadelets.size());
+        record.complete      = manifest.complete ? 1 : 0;
+        record.padding       = 0;
+        for (auto const &keyword : manifest.keywords)
+            keywords.push_back(addString(keyword));
+        for (auto const &shadelet : manifest.shadelets)
+        {
+            auto entry = ShadeletRecord();
+            entry.path = addString(shadelet.first);
+            entry.type = std::uint32_t(shadelet.second);
+            shadelets.push_back(entry);
+        }
+        records.push_back(record);
+
+        // Whatever the index had for this file, if it is the same file
+        // there is nothing new to say about it
+        auto found = entries.find(manifest.path);
+        if (found == entries.end())
+            unchanged = false;
+        else if (unchanged)
+        {
+            const ManifestRecord &old = GetRecord(data, found->second);
+            unchanged = old.modified == record.modified &&
+                        old.size == record.size && old.hash == record.hash;
+        }
+    }
+    if (unchanged && records.size() == entries.size())
+        return true;
+
+    header.manifestCount = std::uint32_t(records.size());
+    header.shadeletCount = std::uint32_t(shadelets.size());
+    header.keywordCount  = std::uint32_t(keywords.size());
+    header.stringBytes   = std::uint32_t(strings.size());
+
+    std::error_code error;
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path(), error);
+
+    // Written aside and renamed over the index, so a crash mid-write never
+    // leaves a truncated one behind
+    auto writePath = path;
+    writePath += ".tmp";
+    {
+        auto file = std::ofstream(writePath, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()),
+                   std::streamsize(records.size() * sizeof(ManifestRecord)));
+        file.write(reinterpret_cast<const char *>(shadelets.data()),
+                   std::streamsize(shadelets.size() * sizeof(ShadeletRecord)));
+        file.write(reinterpret_cast<const char *>(keywords.data()),
+                   std::streamsize(keywords.size() * sizeof(StringRef)));
+        file.write(strings.data(), std::streamsize(strings.size()));
+        if (!file)
+        {
+            std::cerr << "Could not write shader manifest index '"
+                      << writePath.generic_string() << "'" << std::endl;
+            return false;
+        }
+    }
+    std::filesystem::rename(writePath, path, error);
+    if (error)
+    {
+        std::cerr << "Could not write shader manifest index '"
+                  << path.generic_string() << "': " << error.message()
+                  << std::endl;
+        return false;
+    }
+    // Later lookups see what was just written
+    return Load();
+}
+
+std::size_t ManifestIndex::GetSize() const { return entries.size(); }
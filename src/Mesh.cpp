@@ -1,4 +1,5 @@
 #include "Mesh.hpp"
+#include "GLState.hpp"
 #include "OpenGLExtensions.hpp"
 
 #include <iostream>
@@ -15,34 +16,60 @@ std::size_t VecTotalSize(const std::vector<T> &vec)
     return GetVecTypeSize(vec) * vec.size();
 }
 
-Mesh::Mesh() : vao(0), vbo(0), ibo(0) {}
+Mesh::Mesh()
+    : vao(0), vbo(0), ibo(0), state(nullptr), sharedVertexArray(false)
+{
+}
 
 Mesh::~Mesh() { ClearMesh(); }
 
-void Mesh::CreateMesh(std::vector<Vertex> &&       vertices,
+void Mesh::CreateMesh(GLState &glState, std::vector<Vertex> &&vertices,
                       std::vector<std::uint32_t> &&indices)
 {
     this->vertices = std::move(vertices);
     this->indices  = std::move(indices);
+    this->state    = &glState;
+
+    if (HasDirectStateAccess())
+        CreateBuffersDirect();
+    else
+        CreateBuffersBound();
+}
+
+void Mesh::CreateBuffersDirect()
+{
+    // Immutable storage, filled once and never bound to be edited
+    GLCall(glCreateBuffers(1, &this->vbo));
+    GLCall(glNamedBufferStorage(this->vbo, VecTotalSize(this->vertices),
+                                this->vertices.data(), 0));
+    GLCall(glCreateBuffers(1, &this->ibo));
+    GLCall(glNamedBufferStorage(this->ibo, VecTotalSize(this->indices),
+                                this->indices.data(), 0));
+
+    this->vao               = Vertex::GetSharedVertexArray();
+    this->sharedVertexArray = true;
+}
+
+void Mesh::CreateBuffersBound()
+{
     // Vertex buffer
     GLCall(glGenBuffers(1, &this->vbo));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, this->vbo));
+    state->BindBuffer(GL_ARRAY_BUFFER, this->vbo);
     GLCall(glBufferData(GL_ARRAY_BUFFER, VecTotalSize(this->vertices),
                         this->vertices.data(), GL_STATIC_DRAW));
 
     // Setup vertex array object
-    this->vao = Vertex::GenerateAttributes();
+    this->vao               = Vertex::GenerateAttributes(*state);
+    this->sharedVertexArray = false;
 
-    // Index buffer
+    // Index buffer, recorded in the vertex array
     GLCall(glGenBuffers(1, &this->ibo));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo));
+    state->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, VecTotalSize(this->indices),
                         this->indices.data(), GL_STATIC_DRAW));
 
-    // Unbind all buffers
-    GLCall(glBindVertexArray(0));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    // Nothing after this may change the vertex array by accident
+    state->BindVertexArray(0);
 }
 
 void Mesh::RenderMesh()
@@ -54,23 +81,39 @@ void Mesh::RenderMesh()
     if (this->ibo == 0)
         std::cout << "ibo == 0" << std::endl;
 
-    GLCall(glBindVertexArray(vao));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, vbo)); // Probably not needed
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo));
+    if (state == nullptr)
+        return; // Never created
+
+    if (sharedVertexArray)
+    {
+        // Consecutive draws of the same mesh attach nothing
+        state->VertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
+        state->VertexArrayElementBuffer(vao, ibo);
+    }
+    // Otherwise the vertex array already holds the attribute and index
+    // buffers
+    state->BindVertexArray(vao);
     GLCall(glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0));
-    GLCall(glBindVertexArray(0));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0)); // Probably not needed
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
 }
 
 void Mesh::ClearMesh()
 {
+    if (state != nullptr && vao != 0)
+    {
+        state->ForgetBuffer(ibo);
+        state->ForgetBuffer(vbo);
+        if (!sharedVertexArray)
+            state->ForgetVertexArray(vao);
+    }
     glDeleteBuffers(1, &ibo);
     ibo = 0;
     glDeleteBuffers(1, &vbo);
     vbo = 0;
-    glDeleteVertexArrays(1, &vao);
-    vao = 0;
+    if (!sharedVertexArray)
+        glDeleteVertexArrays(1, &vao);
+    vao               = 0;
+    sharedVertexArray = false;
+    state             = nullptr;
     indices.clear();
     vertices.clear();
 }
@@ -81,7 +124,15 @@ Mesh::Mesh(Mesh &&other)
     vbo       = other.vbo;
     ibo       = other.ibo;
     other.vao = other.vbo = other.ibo = 0; // Clear other
+    state     = other.state;
+
+    sharedVertexArray       = other.sharedVertexArray;
+    other.sharedVertexArray = false;
 
     vertices = std::move(other.vertices);
     indices  = std::move(other.indices);
 }
+
+const std::vector<Vertex> &Mesh::GetVertices() const { return vertices; }
+
+const std::vector<std::uint32_t> &Mesh::GetIndices() const { return indices; }
@@ -0,0 +1,248 @@
+#include "MeshPool.hpp"
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+MeshPool::MeshPool()
+    : vao(0), vbo(0), ibo(0), formatBuffer(0), pullVertices(false),
+      state(nullptr)
+{
+}
+
+MeshPool::MeshPool(MeshPool &&other)
+    : vertexData(std::move(other.vertexData)),
+      indices(std::move(other.indices)), ranges(std::move(other.ranges)),
+      formats(std::move(other.formats)), bounds(std::move(other.bounds)),
+      vao(other.vao), vbo(other.vbo), ibo(other.ibo),
+      formatBuffer(other.formatBuffer), pullVertices(other.pullVertices),
+      state(other.state)
+{
+    other.vao = other.vbo = other.ibo = other.formatBuffer = 0;
+    other.state                                            = nullptr;
+}
+
+MeshPool::~MeshPool() { ClearPool(); }
+
+std::uint32_t MeshPool::AddMesh(const std::vector<Vertex> &       meshVertices,
+                                const std::vector<std::uint32_t> &meshIndices)
+{
+    auto layout           = VertexLayout();
+    layout.stride         = 5;
+    layout.positionOffset = 0;
+    layout.uvOffset       = 3;
+
+    auto data = std::vector<GLfloat>();
+    data.reserve(meshVertices.size() * layout.stride);
+    for (auto const &vertex : meshVertices)
+    {
+        data.insert(data.end(), vertex.position, vertex.position + 3);
+        data.insert(data.end(), vertex.uv, vertex.uv + 2);
+    }
+    return AddMesh(data.data(), meshVertices.size(), layout, meshIndices);
+}
+
+std::uint32_t MeshPool::AddMesh(const GLfloat *meshVertices,
+                                std::size_t vertexCount,
+                                const VertexLayout &              layout,
+                                const std::vector<std::uint32_t> &meshIndices)
+{
+    // Every attribute has to fit in one vertex, or the vertices could not
+    // be walked
+    auto fits = [&](std::int32_t offset, std::uint32_t size) {
+        return offset < 0 || std::uint64_t(offset) + size <= layout.stride;
+    };
+    if (layout.stride == 0 || !fits(layout.positionOffset, 3) ||
+        !fits(layout.uvOffset, 2))
+    {
+        std::cerr << "Mesh layout with a stride of " << layout.stride
+                  << " floats cannot hold its attributes" << std::endl;
+        return InvalidMesh;
+    }
+
+    auto range       = MeshRange();
+    range.firstIndex = std::uint32_t(indices.size());
+    range.indexCount = std::uint32_t(meshIndices.size());
+    range.mesh       = std::uint32_t(ranges.size());
+
+    auto format           = MeshFormat();
+    format.firstFloat     = std::uint32_t(vertexData.size());
+    format.stride         = layout.stride;
+    format.positionOffset = layout.positionOffset;
+    format.uvOffset       = layout.uvOffset;
+
+    // Indices stay relative to the mesh, CreatePool decides the base vertex
+    vertexData.insert(vertexData.end(), meshVertices,
+                      meshVertices + vertexCount * layout.stride);
+    indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+    ranges.push_back(range);
+    formats.push_back(format);
+
+    // Sphere around the center of the box, loose but cheap to transform
+    auto positionOf = [&](std::size_t vertex) {
+        if (layout.positionOffset < 0)
+            return glm::vec3(0.0f);
+        const GLfloat *p =
+            meshVertices + vertex * layout.stride + layout.positionOffset;
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+    glm::vec3 low  = glm::vec3(0.0f);
+    glm::vec3 high = glm::vec3(0.0f);
+    if (vertexCount > 0)
+        low = high = positionOf(0);
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        low  = glm::min(low, positionOf(i));
+        high = glm::max(high, positionOf(i));
+    }
+    glm::vec3 center = (low + high) * 0.5f;
+    float     radius = 0.0f;
+    for (std::size_t i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 offset = positionOf(i) - center;
+        radius           = std::max(radius, glm::dot(offset, offset));
+    }
+    bounds.push_back(glm::vec4(center, std::sqrt(radius)));
+    return range.mesh;
+}
+
+std::vector<Vertex> MeshPool::BuildVertices()
+{
+    auto vertices = std::vector<Vertex>();
+    for (std::size_t m = 0; m < formats.size(); m++)
+    {
+        const MeshFormat &format = formats[m];
+        std::size_t       end    = m + 1 < formats.size()
+                                       ? formats[m + 1].firstFloat
+                                       : vertexData.size();
+
+        ranges[m].baseVertex = std::int32_t(vertices.size());
+        for (std::size_t f = format.firstFloat; f < end; f += format.stride)
+        {
+            const GLfloat *source = vertexData.data() + f;
+            auto           vertex = Vertex();
+            if (format.positionOffset >= 0)
+                std::copy_n(source + format.positionOffset, 3,
+                            vertex.position);
+            if (format.uvOffset >= 0)
+                std::copy_n(source + format.uvOffset, 2, vertex.uv);
+            vertices.push_back(vertex);
+        }
+    }
+    return vertices;
+}
+
+void MeshPool::DeleteObjects()
+{
+    if (vao == 0)
+        return;
+    state->ForgetBuffer(vbo);
+    state->ForgetBuffer(ibo);
+    state->ForgetBuffer(formatBuffer);
+    state->ForgetVertexArray(vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+    glDeleteBuffers(1, &formatBuffer);
+    glDeleteVertexArrays(1, &vao);
+    vao = vbo = ibo = formatBuffer = 0;
+}
+
+void MeshPool::CreatePool(GLState &glState, bool pull)
+{
+    // Drop the old buffers, but keep the CPU side geometry
+    DeleteObjects();
+    state        = &glState;
+    pullVertices = pull;
+
+    GLCall(glCreateBuffers(1, &ibo));
+    GLCall(glNamedBufferStorage(ibo, indices.size() * sizeof(std::uint32_t),
+                                indices.data(), 0));
+    GLCall(glCreateVertexArrays(1, &vao));
+
+    if (pullVertices)
+    {
+        // Indices stay relative to each mesh, so gl_VertexID is the vertex
+        // within the mesh and the shader adds the mesh's first float
+        for (auto &range : ranges)
+            range.baseVertex = 0;
+
+        GLCall(glCreateBuffers(1, &vbo));
+        GLCall(glNamedBufferStorage(vbo, vertexData.size() * sizeof(GLfloat),
+                                    vertexData.data(), 0));
+        GLCall(glCreateBuffers(1, &formatBuffer));
+        GLCall(glNamedBufferStorage(formatBuffer,
+                                    formats.size() * sizeof(MeshFormat),
+                                    formats.data(), 0));
+    }
+    else
+    {
+        auto vertices = BuildVertices();
+        GLCall(glCreateBuffers(1, &vbo));
+        GLCall(glNamedBufferStorage(vbo, vertices.size() * sizeof(Vertex),
+                                    vertices.data(), 0));
+
+        // Model position attribute
+        GLCall(glEnableVertexArrayAttrib(vao, 0));
+        GLCall(glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE,
+                                         offsetof(Vertex, position)));
+        GLCall(glVertexArrayAttribBinding(vao, 0, 0));
+
+        // UV Coordinate Attribute
+        GLCall(glEnableVertexArrayAttrib(vao, 1));
+        GLCall(glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE,
+                                         offsetof(Vertex, uv)));
+        GLCall(glVertexArrayAttribBinding(vao, 1, 0));
+
+        state->VertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
+    }
+
+    // Draw ID, advancing once per instance. Its buffer is attached by
+    // whoever issues the indirect draws.
+    GLCall(glEnableVertexArrayAttrib(vao, DrawIDAttribute));
+    GLCall(glVertexArrayAttribIFormat(vao, DrawIDAttribute, 1,
+                                      GL_UNSIGNED_INT, 0));
+    GLCall(glVertexArrayAttribBinding(vao, DrawIDAttribute, DrawIDBinding));
+    GLCall(glVertexArrayBindingDivisor(vao, DrawIDBinding, 1));
+
+    state->VertexArrayElementBuffer(vao, ibo);
+}
+
+void MeshPool::ClearPool()
+{
+    DeleteObjects();
+    state        = nullptr;
+    pullVertices = false;
+    vertexData.clear();
+    indices.clear();
+    ranges.clear();
+    formats.clear();
+    bounds.clear();
+}
+
+void MeshPool::Bind()
+{
+    state->BindVertexArray(vao);
+    if (!pullVertices)
+        return;
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, VertexDataBinding, vbo);
+    state->BindBufferBase(GL_SHADER_STORAGE_BUFFER, MeshFormatBinding,
+                          formatBuffer);
+}
+
+const MeshRange &MeshPool::GetRange(std::uint32_t mesh) const
+{
+    return ranges.at(mesh);
+}
+
+const glm::vec4 &MeshPool::GetBounds(std::uint32_t mesh) const
+{
+    return bounds.at(mesh);
+}
+
+std::size_t MeshPool::GetMeshCount() const { return ranges.size(); }
+
+GLuint MeshPool::GetVertexArray() const { return vao; }
+
+bool MeshPool::IsPullingVertices() const { return pullVertices; }
@@ -24,6 +24,33 @@ void GLCheckError(const char *func, const char *file, int line)
     assert(!hadError);
 }
 
+bool HasDirectStateAccess()
+{
+    return GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+}
+
+bool HasMultiDrawIndirect()
+{
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect &&
+                                GLEW_ARB_shader_storage_buffer_object &&
+                                GLEW_ARB_base_instance);
+}
+
+bool HasComputeShaders()
+{
+    return GLEW_VERSION_4_3 || GLEW_ARB_compute_shader;
+}
+
+bool HasIndirectParameters()
+{
+    return GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters;
+}
+
+bool HasParallelShaderCompile()
+{
+    return GLEW_ARB_parallel_shader_compile;
+}
+
 void PrintGLError(GLenum errorCode)
 {
     // As defined by:
@@ -0,0 +1,194 @@
+#include "ProgramBinaryCache.hpp"
+#include "OpenGLExtensions.hpp"
+#include "StringHash.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+    // Bumped whenever the file layout changes
+    constexpr std::uint32_t EntryVersion = 1;
+
+    struct EntryHeader
+    {
+    public:
+        char          magic[4];
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint32_t format; // GLenum from glGetProgramBinary
+        std::uint32_t length; // Bytes of binary following the header
+    };
+} // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path cacheDirectory)
+    : directory(std::move(cacheDirectory)), driverHash(ContentHashSeed),
+      supported(false)
+{
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+        return;
+    GLint formats = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    if (formats <= 0)
+        return;
+
+    // A binary is only good for the driver that made it
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        GLCall(auto value =
+                   reinterpret_cast<const char *>(glGetString(name)));
+        driverHash = HashContent(value != nullptr ? value : "", driverHash);
+        driverHash = HashContent(std::string_view("\0", 1), driverHash);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "Could not create shader cache '"
+                  << directory.generic_string() << "': " << error.message()
+                  << std::endl;
+        return;
+    }
+    supported = true;
+}
+
+ProgramBinaryCache::~ProgramBinaryCache() {}
+
+std::filesystem::path
+    ProgramBinaryCache::EntryPath(const ShaderSource &source) const
+{
+    // Program names come from the manifests, keep them file name safe
+    auto fileName = source.GetName();
+    for (char &c : fileName)
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' &&
+            c != '-')
+            c = '_';
+    return directory / (fileName + ".bin");
+}
+
+std::uint64_t ProgramBinaryCache::ComputeKey(const ShaderSource &source) const
+{
+    // Sources are hashed after '#include' expansion, so editing an included
+    // file invalidates every program using it. Each shadelet's hash was
+    // already worked out when its text was stored.
+    std::uint64_t key = driverHash;
+    for (auto const &shadelet : source.GetShadelets())
+    {
+        GLenum        type       = shadelet.GetType();
+        std::uint64_t sourceHash = shadelet.GetSourceHash();
+        key                      = HashContent(
+            std::string_view(reinterpret_cast<const char *>(&type),
+                             sizeof(type)),
+            key);
+        key = HashContent(
+            std::string_view(reinterpret_cast<const char *>(&sourceHash),
+                             sizeof(sourceHash)),
+            key);
+    }
+    return key;
+}
+
+bool ProgramBinaryCache::IsSupported() const { return supported; }
+
+void ProgramBinaryCache::PrepareProgram(GLuint program)
+{
+    if (!supported)
+        return;
+    GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                               GL_TRUE));
+}
+
+bool ProgramBinaryCache::Load(const ShaderSource &source, GLuint program)
+{
+    if (!supported)
+        return false;
+
+    auto path = EntryPath(source);
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    auto header = EntryHeader();
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, "GLPB", 4) != 0 ||
+        header.version != EntryVersion || header.key != ComputeKey(source))
+        return false; // Stale, replaced by the next Store
+
+    auto binary = std::vector<char>(header.length);
+    if (!file.read(binary.data(), std::streamsize(binary.size())))
+        return false;
+    file.close();
+
+    GLCall(glProgramBinary(program, header.format, binary.data(),
+                           GLsizei(binary.size())));
+    GLint linked = 0;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
+    {
+        // Drivers may refuse binaries after an update that kept the version
+        // string, compiling from source replaces the entry
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        stats.rejected++;
+        return false;
+    }
+    stats.loaded++;
+    return true;
+}
+
+void ProgramBinaryCache::Store(const ShaderSource &source, GLuint program)
+{
+    if (!supported)
+        return;
+
+    GLint length = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return;
+
+    auto   binary = std::vector<char>(std::size_t(length));
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format,
+                              binary.data()));
+
+    auto header = EntryHeader();
+    std::memcpy(header.magic, "GLPB", 4);
+    header.version = EntryVersion;
+    header.key     = ComputeKey(source);
+    header.format  = format;
+    header.length  = std::uint32_t(length);
+
+    // Written aside and renamed over the entry, so a crash mid-write never
+    // leaves a truncated binary behind
+    auto path      = EntryPath(source);
+    auto writePath = path;
+    writePath += ".tmp";
+    {
+        auto file = std::ofstream(writePath, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            std::cerr << "Could not write shader cache '"
+                      << writePath.generic_string() << "'" << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(writePath, path, error);
+    if (error)
+        std::cerr << "Could not write shader cache '" << path.generic_string()
+                  << "': " << error.message() << std::endl;
+    else
+        stats.stored++;
+}
+
+const ProgramBinaryStats &ProgramBinaryCache::GetStats() const
+{
+    return stats;
+}
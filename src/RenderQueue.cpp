@@ -0,0 +1,89 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
+RenderQueue::RenderQueue() {}
+
+RenderQueue::~RenderQueue() {}
+
+std::uint64_t RenderQueue::MakeKey(RenderPass pass, bool translucent,
+                                   std::uint32_t program,
+                                   std::uint32_t material, std::uint32_t mesh,
+                                   float depth)
+{
+    depth = std::min(std::max(depth, 0.0f), 1.0f);
+
+    std::uint64_t quantum   = std::uint64_t(depth * float(MaxDepth));
+    std::uint64_t programB  = program & (MaxPrograms - 1);
+    std::uint64_t materialB = material & (MaxMaterials - 1);
+    std::uint64_t meshB     = mesh & (MaxMeshes - 1);
+
+    std::uint64_t key = std::uint64_t(pass) << 62;
+    if (!translucent)
+        return key | (programB << 49) | (materialB << 37) | (meshB << 21) |
+               quantum;
+
+    // Furthest first, so the depth is inverted and placed above the state
+    key |= std::uint64_t(1) << 61;
+    return key | ((MaxDepth - quantum) << 40) | (programB << 28) |
+           (materialB << 16) | meshB;
+}
+
+void RenderQueue::Clear() { packets.clear(); }
+
+void RenderQueue::Push(std::uint64_t key, std::uint32_t shaderIndex,
+                       std::uint32_t meshIndex, std::uint32_t objectIndex)
+{
+    packets.push_back({key, shaderIndex, meshIndex, objectIndex});
+}
+
+void RenderQueue::Sort()
+{
+    scratch.resize(packets.size());
+
+    for (unsigned shift = 0; shift < 64; shift += 8)
+    {
+        auto counts = std::array<std::size_t, 256>();
+        for (auto const &packet : packets)
+            counts[(packet.key >> shift) & 0xFF]++;
+
+        // Every key shares this byte, the pass would not move anything
+        if (counts[(packets.empty() ? 0 : packets[0].key >> shift) & 0xFF] ==
+            packets.size())
+            continue;
+
+        // Exclusive prefix sum gives each bucket's first output slot
+        std::size_t offset = 0;
+        for (auto &count : counts)
+        {
+            std::size_t bucketSize = count;
+            count                  = offset;
+            offset += bucketSize;
+        }
+
+        for (auto const &packet : packets)
+            scratch[counts[(packet.key >> shift) & 0xFF]++] = packet;
+
+        packets.swap(scratch);
+    }
+}
+
+std::vector<RenderPacket> const &RenderQueue::GetPackets() const
+{
+    return packets;
+}
+
+RenderQueueStats RenderQueue::GetStats() const
+{
+    auto stats = RenderQueueStats();
+    for (std::size_t i = 0; i < packets.size(); i++)
+    {
+        if (i == 0 || packets[i - 1].shaderIndex != packets[i].shaderIndex)
+            stats.programChanges++;
+        if (i == 0 || packets[i - 1].meshIndex != packets[i].meshIndex)
+            stats.meshChanges++;
+    }
+    stats.draws = packets.size();
+    return stats;
+}
@@ -0,0 +1,83 @@
+#include "RenderTarget.hpp"
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <iostream>
+
+RenderTarget::RenderTarget()
+    : framebuffer(0), colorTexture(0), depthTexture(0), width(0), height(0),
+      state(nullptr)
+{
+}
+
+RenderTarget::~RenderTarget() { ClearTarget(); }
+
+bool RenderTarget::CreateTarget(GLState &glState, GLsizei targetWidth,
+                                GLsizei targetHeight)
+{
+    ClearTarget();
+    state  = &glState;
+    width  = targetWidth;
+    height = targetHeight;
+
+    GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &colorTexture));
+    GLCall(glTextureStorage2D(colorTexture, 1, GL_RGBA8, width, height));
+    // Sampled as depth by whoever reads it, never filtered
+    GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture));
+    GLCall(glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, width,
+                              height));
+    GLCall(glTextureParameteri(depthTexture, GL_TEXTURE_MIN_FILTER,
+                               GL_NEAREST));
+    GLCall(glTextureParameteri(depthTexture, GL_TEXTURE_MAG_FILTER,
+                               GL_NEAREST));
+
+    GLCall(glCreateFramebuffers(1, &framebuffer));
+    GLCall(glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0,
+                                     colorTexture, 0));
+    GLCall(glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT,
+                                     depthTexture, 0));
+
+    GLCall(GLenum status =
+               glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Render target incomplete, status " << status
+                  << std::endl;
+        ClearTarget();
+        return false;
+    }
+    return true;
+}
+
+void RenderTarget::ClearTarget()
+{
+    if (framebuffer == 0 && colorTexture == 0)
+        return;
+    state->ForgetFramebuffer(framebuffer);
+    state->ForgetTexture(colorTexture);
+    state->ForgetTexture(depthTexture);
+    GLCall(glDeleteFramebuffers(1, &framebuffer));
+    GLCall(glDeleteTextures(1, &colorTexture));
+    GLCall(glDeleteTextures(1, &depthTexture));
+    framebuffer = colorTexture = depthTexture = 0;
+    width = height = 0;
+}
+
+void RenderTarget::Bind() { state->BindFramebuffer(framebuffer); }
+
+void RenderTarget::BlitToScreen(GLsizei screenWidth, GLsizei screenHeight)
+{
+    GLCall(glBlitNamedFramebuffer(framebuffer, 0, 0, 0, width, height, 0, 0,
+                                  screenWidth, screenHeight,
+                                  GL_COLOR_BUFFER_BIT, GL_LINEAR));
+}
+
+GLuint RenderTarget::GetFramebuffer() const { return framebuffer; }
+
+GLuint RenderTarget::GetColorTexture() const { return colorTexture; }
+
+GLuint RenderTarget::GetDepthTexture() const { return depthTexture; }
+
+GLsizei RenderTarget::GetWidth() const { return width; }
+
+GLsizei RenderTarget::GetHeight() const { return height; }
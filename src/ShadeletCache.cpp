@@ -0,0 +1,64 @@
+#include "ShadeletCache.hpp"
+
+bool ShadeletCache::Key::operator==(const Key &other) const
+{
+    return type == other.type && sourceHash == other.sourceHash;
+}
+
+std::size_t ShadeletCache::KeyHash::operator()(const Key &key) const
+{
+    // The source hash is already well mixed
+    return std::size_t(key.sourceHash ^ (std::uint64_t(key.type) << 32));
+}
+
+ShadeletCache::ShadeletCache() {}
+
+ShadeletCache::~ShadeletCache() { Clear(); }
+
+GLuint ShadeletCache::Acquire(const ShadeletSource &source)
+{
+    auto key = Key{source.GetType(), source.GetSourceHash()};
+
+    auto found = shaders.find(key);
+    if (found != shaders.end())
+    {
+        entries[found->second].references++;
+        stats.reused++;
+        return found->second;
+    }
+
+    // No status query here, that would wait for the compiler
+    // Stored text has no terminator, so its length is given
+    GLuint      shader = glCreateShader(source.GetType());
+    const char *text   = source.GetSource().data();
+    GLint       length = GLint(source.GetSource().size());
+    glShaderSource(shader, 1, &text, &length);
+    glCompileShader(shader);
+
+    shaders[key]    = shader;
+    entries[shader] = Entry{key, 1};
+    stats.compiled++;
+    return shader;
+}
+
+void ShadeletCache::Release(GLuint shader)
+{
+    auto found = entries.find(shader);
+    if (found == entries.end() || --found->second.references > 0)
+        return;
+    shaders.erase(found->second.key);
+    entries.erase(found);
+    glDeleteShader(shader);
+}
+
+void ShadeletCache::Clear()
+{
+    for (auto const &entry : entries)
+        glDeleteShader(entry.first);
+    shaders.clear();
+    entries.clear();
+}
+
+std::size_t ShadeletCache::GetSize() const { return entries.size(); }
+
+const ShadeletCacheStats &ShadeletCache::GetStats() const { return stats; }
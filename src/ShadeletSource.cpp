@@ -1,17 +1,75 @@
 #include "ShadeletSource.hpp"
 
-ShadeletSource::ShadeletSource(std::string src, GLenum tp, std::string path)
-    : source(src), type(tp), fullPath(path)
+#include <cctype>
+
+ShadeletSource::ShadeletSource(std::string_view src, GLenum tp,
+                               std::string_view           path,
+                               std::vector<std::uint32_t> files)
+    : type(tp), sourceFiles(std::move(files))
 {
+    SourceStore &store = SourceStore::Shared();
+    source             = store.Add(src);
+    fullPath           = store.Intern(path);
 }
 
 ShadeletSource::~ShadeletSource() {}
 
-const std::string &ShadeletSource::GetFullPath() const
+ShadeletSource ShadeletSource::WithSource(std::string_view newSource) const
+{
+    auto shadelet   = *this;
+    shadelet.source = SourceStore::Shared().Add(newSource);
+    return shadelet;
+}
+
+std::string_view ShadeletSource::GetFullPath() const
 {
-    return this->fullPath;
+    return SourceStore::Shared().GetName(fullPath);
 }
 
-const std::string &ShadeletSource::GetSource() const { return this->source; }
+std::string_view ShadeletSource::GetSource() const { return source.GetText(); }
+
+std::uint64_t ShadeletSource::GetSourceHash() const
+{
+    return source.GetHash();
+}
 
 GLenum ShadeletSource::GetType() const { return this->type; }
+
+const std::vector<std::uint32_t> &ShadeletSource::GetSourceFiles() const
+{
+    return this->sourceFiles;
+}
+
+std::string ShadeletSource::DescribeLog(const std::string &log) const
+{
+    // Drivers start each message with the source string number, followed by
+    // ':' (Mesa, "0:12(3):") or '(' (NVIDIA, "0(12) :")
+    auto        described = std::string();
+    std::size_t start     = 0;
+    while (start < log.size())
+    {
+        auto end = log.find('\n', start);
+        if (end == std::string::npos)
+            end = log.size();
+        auto line = log.substr(start, end - start);
+
+        std::size_t digits = 0;
+        while (digits < line.size() &&
+               std::isdigit(static_cast<unsigned char>(line[digits])))
+            digits++;
+        if (digits > 0 && digits < line.size() &&
+            (line[digits] == ':' || line[digits] == '('))
+        {
+            std::size_t number = std::stoul(line.substr(0, digits));
+            if (number < sourceFiles.size())
+                line = SourceStore::Shared().GetName(sourceFiles[number]) +
+                       line.substr(digits);
+        }
+
+        described += line;
+        if (end < log.size())
+            described += '\n';
+        start = end + 1;
+    }
+    return described;
+}
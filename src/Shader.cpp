@@ -1,10 +1,21 @@
 #include "Shader.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FrameConstants.hpp"
+#include "ObjectConstants.hpp"
 #include "OpenGLExtensions.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "ShadeletCache.hpp"
 
 // OpenGL Start
 #include <GL/glew.h>
@@ -12,84 +23,601 @@
 #include <GLFW/glfw3.h>
 // OpenGL End
 
-std::unique_ptr<std::string>
-    Shader::CompileShadelet(const ShadeletSource &shadeletSource, GLuint &id)
+// Uniform blocks shared between programs, each at its own fixed binding
+static const std::pair<const char *, GLuint> SharedUniformBlocks[] = {
+    {FrameConstantsBlock, FrameConstantsBinding},
+    {ObjectConstantsBlock, ObjectConstantsBinding}};
+
+// Bytes of one element of a uniform of this type, 0 when not shadowed
+static std::uint32_t UniformTypeSize(GLenum type)
 {
-    id              = glCreateShader(shadeletSource.GetType());
-    const char *src = shadeletSource.GetSource().c_str();
-    glShaderSource(id, 1, &src, nullptr);
-    glCompileShader(id);
+    switch (type)
+    {
+        case GL_FLOAT:
+        case GL_INT:
+        case GL_UNSIGNED_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY: return 4;
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2: return 8;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3: return 12;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_FLOAT_MAT2: return 16;
+        case GL_FLOAT_MAT3: return 36;
+        case GL_FLOAT_MAT4: return 64;
+        default: return 0;
+    }
+}
 
+std::unique_ptr<std::string>
+    Shader::ShadeletError(const ShadeletSource &shadeletSource, GLuint id)
+{
     GLint result = 0;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE)
     {
         GLint len = 0;
         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &len);
+        auto msg = std::string(std::size_t(std::max(len, 1)), '\0');
+        glGetShaderInfoLog(id, len, &len, &msg[0]);
+        msg.resize(std::size_t(std::max(len, 0)));
 
-        GLchar *msg = (GLchar *)malloc(len);
-        glGetShaderInfoLog(id, len, &len, msg);
-
-        auto return_msg = std::make_unique<std::string>(
-            "Error in shader '" + shadeletSource.GetFullPath() + "':\n" +
-            std::string((char *)msg));
-        delete msg;
-        return return_msg;
+        return std::make_unique<std::string>(
+            "Error in shader '" + std::string(shadeletSource.GetFullPath()) +
+            "':\n" + shadeletSource.DescribeLog(msg));
     }
 
     return std::unique_ptr<std::string>(nullptr);
 }
 
+bool Shader::IsProgramReady(const PendingShader &pending)
+{
+    // Without the extension, asking for the link status simply waits
+    if (pending.cached || !HasParallelShaderCompile())
+        return true;
+    GLint ready = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_ARB, &ready);
+    return ready == GL_TRUE;
+}
+
+PendingShader Shader::SubmitProgram(const ShaderSource &source,
+                                    ProgramBinaryCache *binaryCache,
+                                    ShadeletCache &     shadeletCache)
+{
+    auto pending    = PendingShader();
+    pending.source  = &source;
+    pending.program = glCreateProgram();
+    pending.cached  = binaryCache != nullptr &&
+                     binaryCache->Load(source, pending.program);
+    if (pending.cached)
+        return pending;
+
+    // A shadelet several programs use is compiled once. Failed compiles
+    // just fail to link.
+    for (auto const &shadelet : source.GetShadelets())
+        pending.shadelets.push_back(shadeletCache.Acquire(shadelet));
+    if (binaryCache != nullptr)
+        binaryCache->PrepareProgram(pending.program);
+    for (GLuint shadelet : pending.shadelets)
+        glAttachShader(pending.program, shadelet);
+    glLinkProgram(pending.program);
+    return pending;
+}
+
 std::unique_ptr<std::vector<Shader>>
     Shader::CompileShaders(const std::vector<ShaderSource> &          sources,
-                           std::unique_ptr<std::vector<std::string>> &errors)
+                           std::unique_ptr<std::vector<std::string>> &errors,
+                           ProgramBinaryCache *binaryCache,
+                           ShadeletCache *     shadeletCache)
 {
+    // Shadelets are at least shared within this call
+    auto localCache = std::unique_ptr<ShadeletCache>();
+    if (shadeletCache == nullptr)
+    {
+        localCache    = std::make_unique<ShadeletCache>();
+        shadeletCache = localCache.get();
+    }
 
-    // auto shaderIDs = std::vector<GLuint>();
-    auto shaders = std::make_unique<std::vector<Shader>>();
+    // Let the driver compile on as many threads as it likes
+    if (GLEW_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+    // Submit every program before waiting on any, so the driver has all of
+    // them to work on at once
+    auto pending = std::vector<PendingShader>();
+    for (auto const &source : sources)
+        pending.push_back(SubmitProgram(source, binaryCache, *shadeletCache));
 
-    for (auto &source : sources)
+    // Finish programs in whatever order the driver completes them, and
+    // only then ask how they went
+    auto        built     = std::vector<std::optional<Shader>>(sources.size());
+    auto        finished  = std::vector<bool>(sources.size(), false);
+    std::size_t remaining = pending.size();
+    while (remaining > 0)
     {
-        GLuint      programID  = glCreateProgram();
-        GLuint      shadeletID = 0;
-        auto const &shadelets  = source.GetShadelets();
-        // Compile and add each individual shadelet
-        for (auto const &shadelet : shadelets)
+        for (std::size_t i = 0; i < pending.size(); i++)
         {
-            auto compileResult = CompileShadelet(shadelet, shadeletID);
-            if (compileResult == nullptr) // No error occurred
-            {
-                // shaderIDs.push_back(shadeletID);
-                glAttachShader(programID, shadeletID);
-                shaders->push_back(Shader(programID));
-
-                glDeleteShader(shadeletID);
-            }
-            else
-            {
-                if (errors != nullptr)
-                    errors->push_back(*compileResult);
-                return shaders;
-            }
+            if (finished[i] || !IsProgramReady(pending[i]))
+                continue;
+            finished[i] = true;
+            remaining--;
+            built[i] = FinishProgram(pending[i], errors, binaryCache,
+                                     *shadeletCache);
         }
-        glLinkProgram(programID);
-        glValidateProgram(programID);
+        if (remaining > 0)
+            std::this_thread::yield();
     }
 
+    // One Shader per program that built, in the order of the sources
+    auto shaders = std::make_unique<std::vector<Shader>>();
+    for (auto &shader : built)
+        if (shader.has_value())
+            shaders->push_back(std::move(*shader));
     return shaders;
 }
 
+std::optional<Shader>
+    Shader::FinishProgram(const PendingShader &pending,
+                          std::unique_ptr<std::vector<std::string>> &errors,
+                          ProgramBinaryCache *binaryCache,
+                          ShadeletCache &     shadeletCache)
+{
+    const ShaderSource &       source    = *pending.source;
+    GLuint                     programID = pending.program;
+    const std::vector<GLuint> &shadelets = pending.shadelets;
+    bool                       cached    = pending.cached;
+
+    GLint linked = GL_TRUE;
+    if (!cached)
+        glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+
+    if (linked == GL_FALSE && errors != nullptr)
+    {
+        // Compile errors explain a failed link better than the link log
+        std::size_t errorCount = errors->size();
+        for (std::size_t s = 0; s < shadelets.size(); s++)
+        {
+            auto error = ShadeletError(source.GetShadelets()[s], shadelets[s]);
+            if (error != nullptr)
+                errors->push_back(*error);
+        }
+        if (errors->size() == errorCount)
+        {
+            GLint len = 0;
+            glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &len);
+            auto msg = std::string(std::size_t(std::max(len, 1)), '\0');
+            glGetProgramInfoLog(programID, len, &len, &msg[0]);
+            msg.resize(std::size_t(std::max(len, 0)));
+            errors->push_back("Error linking shader '" + source.GetName() +
+                              "':\n" + msg);
+        }
+    }
+
+    for (GLuint shadelet : shadelets)
+    {
+        glDetachShader(programID, shadelet);
+        shadeletCache.Release(shadelet);
+    }
+
+    // A program that fails is left out, the others are still built
+    if (linked == GL_FALSE)
+    {
+        glDeleteProgram(programID);
+        return std::nullopt;
+    }
+
+    if (!cached && binaryCache != nullptr)
+        binaryCache->Store(source, programID);
+
+    glValidateProgram(programID);
+    BindSharedUniformBlocks(programID);
+
+    // Reflected now that it is linked
+    auto shader = Shader(programID);
+    shader.name = source.GetName();
+    shader.Reflect(source.HasStage(GL_COMPUTE_SHADER));
+    return shader;
+}
+
+void Shader::BindSharedUniformBlocks(GLuint programID)
+{
+    // GLSL 3.30 has no layout(binding = N), so the bindings are set here
+    for (auto const &block : SharedUniformBlocks)
+    {
+        GLuint index = glGetUniformBlockIndex(programID, block.first);
+        if (index != GL_INVALID_INDEX)
+        {
+            GLCall(glUniformBlockBinding(programID, index, block.second));
+        }
+    }
+}
+
+long Shader::FindShader(const std::vector<Shader> &shaders,
+                        const std::string &        name)
+{
+    for (std::size_t i = 0; i < shaders.size(); i++)
+        if (shaders[i].name == name)
+            return long(i);
+    return -1;
+}
+
 GLuint Shader::GetProgram() { return this->program; }
 
-void Shader::SetInUse() { GLCall(glUseProgram(this->program)); }
+const std::string &Shader::GetName() const { return this->name; }
+
+void Shader::SetInUse(GLState &state) { state.UseProgram(this->program); }
+
+void Shader::Reflect(bool compute)
+{
+    uniforms.clear();
+    uniformBlocks.clear();
+    storageBlocks.clear();
+    attributes.clear();
+    workGroupSize[0] = workGroupSize[1] = workGroupSize[2] = 0;
+
+    if (GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query)
+        ReflectProgramInterface();
+    else
+        ReflectActiveQueries();
+
+    // Asking a program without a compute stage is an error
+    if (compute)
+        glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, workGroupSize);
+
+    BuildLookups();
+    AllocateShadows();
+}
+
+void Shader::ReflectProgramInterface()
+{
+    // Every property of a resource in one query, instead of one per property
+    auto readName = [&](GLenum interface, GLuint index, GLint length) {
+        auto name = std::string(std::size_t(std::max(length, 1)), '\0');
+        glGetProgramResourceName(program, interface, index, length, nullptr,
+                                 &name[0]);
+        name.resize(std::size_t(std::max(length - 1, 0)));
+        return name;
+    };
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    const GLenum uniformProps[] = {GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE,
+                                   GL_LOCATION, GL_BLOCK_INDEX};
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint values[5] = {};
+        glGetProgramResourceiv(program, GL_UNIFORM, GLuint(i), 5, uniformProps,
+                               5, nullptr, values);
+        uniforms.push_back({readName(GL_UNIFORM, GLuint(i), values[0]),
+                            values[3], GLenum(values[1]), values[2],
+                            values[4]});
+    }
+
+    glGetProgramInterfaceiv(program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES,
+                            &count);
+    const GLenum blockProps[] = {GL_NAME_LENGTH, GL_BUFFER_BINDING,
+                                 GL_BUFFER_DATA_SIZE};
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint values[3] = {};
+        glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, GLuint(i), 3,
+                               blockProps, 3, nullptr, values);
+        uniformBlocks.push_back(
+            {readName(GL_UNIFORM_BLOCK, GLuint(i), values[0]), GLuint(i),
+             values[1], values[2]});
+    }
+
+    glGetProgramInterfaceiv(program, GL_SHADER_STORAGE_BLOCK,
+                            GL_ACTIVE_RESOURCES, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint values[3] = {};
+        glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, GLuint(i), 3,
+                               blockProps, 3, nullptr, values);
+        storageBlocks.push_back(
+            {readName(GL_SHADER_STORAGE_BLOCK, GLuint(i), values[0]),
+             GLuint(i), values[1], values[2]});
+    }
+
+    glGetProgramInterfaceiv(program, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES,
+                            &count);
+    const GLenum inputProps[] = {GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE,
+                                 GL_LOCATION};
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint values[4] = {};
+        glGetProgramResourceiv(program, GL_PROGRAM_INPUT, GLuint(i), 4,
+                               inputProps, 4, nullptr, values);
+        auto name = readName(GL_PROGRAM_INPUT, GLuint(i), values[0]);
+        // Built-ins such as gl_VertexID are inputs too, but not attributes
+        if (name.compare(0, 3, "gl_") == 0)
+            continue;
+        attributes.push_back(
+            {std::move(name), values[3], GLenum(values[1]), values[2]});
+    }
+}
+
+void Shader::ReflectActiveQueries()
+{
+    GLint count     = 0;
+    GLint maxLength = 0;
+    auto  buffer    = std::vector<GLchar>();
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    buffer.resize(std::size_t(std::max(maxLength, 1)));
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program, GLuint(i), GLsizei(buffer.size()), &length,
+                           &size, &type, buffer.data());
+
+        GLuint index      = GLuint(i);
+        GLint  blockIndex = -1;
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX,
+                              &blockIndex);
+
+        auto name = std::string(buffer.data(), std::size_t(length));
+        // Block members have no location of their own
+        GLint location = blockIndex < 0
+                             ? glGetUniformLocation(program, name.c_str())
+                             : -1;
+        uniforms.push_back({std::move(name), location, type, size, blockIndex});
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                   &maxLength);
+    buffer.resize(std::size_t(std::max(maxLength, 1)));
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length   = 0;
+        GLint   binding  = 0;
+        GLint   dataSize = 0;
+        glGetActiveUniformBlockName(program, GLuint(i), GLsizei(buffer.size()),
+                                    &length, buffer.data());
+        glGetActiveUniformBlockiv(program, GLuint(i), GL_UNIFORM_BLOCK_BINDING,
+                                  &binding);
+        glGetActiveUniformBlockiv(program, GLuint(i),
+                                  GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+        uniformBlocks.push_back(
+            {std::string(buffer.data(), std::size_t(length)), GLuint(i),
+             binding, dataSize});
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    buffer.resize(std::size_t(std::max(maxLength, 1)));
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveAttrib(program, GLuint(i), GLsizei(buffer.size()), &length,
+                          &size, &type, buffer.data());
+
+        auto name = std::string(buffer.data(), std::size_t(length));
+        if (name.compare(0, 3, "gl_") == 0)
+            continue;
+        GLint location = glGetAttribLocation(program, name.c_str());
+        attributes.push_back({std::move(name), location, type, size});
+    }
+}
+
+void Shader::BuildLookups()
+{
+    uniformLookup.Clear();
+    uniformBlockLookup.Clear();
+    storageBlockLookup.Clear();
+    attributeLookup.Clear();
+
+    auto add = [&](FlatHashMap<std::uint32_t> &lookup, const std::string &name,
+                   std::size_t index, const auto &entries) {
+        const std::uint32_t *existing = lookup.Find(HashName(name));
+        if (existing != nullptr && entries[*existing].name != name)
+            std::cerr << "Shader " << program << ": '" << name
+                      << "' and '" << entries[*existing].name
+                      << "' hash to the same value" << std::endl;
+        lookup.Insert(HashName(name), std::uint32_t(index));
+    };
+
+    for (std::size_t i = 0; i < uniforms.size(); i++)
+    {
+        const std::string &name = uniforms[i].name;
+        add(uniformLookup, name, i, uniforms);
+        // Arrays are reported as "name[0]", also answer to plain "name"
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            uniformLookup.Insert(HashName(std::string_view(name).substr(
+                                     0, name.size() - 3)),
+                                 std::uint32_t(i));
+    }
+    for (std::size_t i = 0; i < uniformBlocks.size(); i++)
+        add(uniformBlockLookup, uniformBlocks[i].name, i, uniformBlocks);
+    for (std::size_t i = 0; i < storageBlocks.size(); i++)
+        add(storageBlockLookup, storageBlocks[i].name, i, storageBlocks);
+    for (std::size_t i = 0; i < attributes.size(); i++)
+        add(attributeLookup, attributes[i].name, i, attributes);
+}
+
+GLint Shader::GetUniformLocation(std::uint32_t nameHash) const
+{
+    const std::uint32_t *index = uniformLookup.Find(nameHash);
+    return index != nullptr ? uniforms[*index].location : -1;
+}
+
+GLint Shader::GetUniformLocation(const std::string &uniformName) const
+{
+    return GetUniformLocation(HashName(uniformName));
+}
+
+const UniformInfo *Shader::FindUniform(std::uint32_t nameHash) const
+{
+    const std::uint32_t *index = uniformLookup.Find(nameHash);
+    return index != nullptr ? &uniforms[*index] : nullptr;
+}
+
+const UniformBlockInfo *Shader::FindUniformBlock(std::uint32_t nameHash) const
+{
+    const std::uint32_t *index = uniformBlockLookup.Find(nameHash);
+    return index != nullptr ? &uniformBlocks[*index] : nullptr;
+}
+
+const UniformBlockInfo *Shader::FindStorageBlock(std::uint32_t nameHash) const
+{
+    const std::uint32_t *index = storageBlockLookup.Find(nameHash);
+    return index != nullptr ? &storageBlocks[*index] : nullptr;
+}
+
+const AttributeInfo *Shader::FindAttribute(std::uint32_t nameHash) const
+{
+    const std::uint32_t *index = attributeLookup.Find(nameHash);
+    return index != nullptr ? &attributes[*index] : nullptr;
+}
+
+const std::vector<UniformInfo> &Shader::GetUniforms() const
+{
+    return uniforms;
+}
+
+const std::vector<UniformBlockInfo> &Shader::GetUniformBlocks() const
+{
+    return uniformBlocks;
+}
+
+const std::vector<UniformBlockInfo> &Shader::GetStorageBlocks() const
+{
+    return storageBlocks;
+}
 
-GLint Shader::GetUniformLocation(const std::string &uniformName)
+const std::vector<AttributeInfo> &Shader::GetAttributes() const
 {
-    GLCall(GLint val =
-               glGetUniformLocation(this->program, uniformName.c_str()));
-    return val;
+    return attributes;
 }
 
-Shader::Shader(GLuint programID) : program(programID) {}
+const GLint *Shader::GetWorkGroupSize() const { return workGroupSize; }
+
+bool Shader::IsCompute() const { return workGroupSize[0] > 0; }
+
+void Shader::Dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ)
+{
+    GLCall(glDispatchCompute(groupsX, groupsY, groupsZ));
+}
+
+void Shader::AllocateShadows()
+{
+    std::uint32_t offset = 0;
+    for (auto &uniform : uniforms)
+    {
+        // Only the first element of arrays is shadowed, like the setters
+        uniform.shadowSize   = uniform.location >= 0
+                                   ? UniformTypeSize(uniform.type)
+                                   : 0;
+        uniform.shadowOffset = offset;
+        offset += uniform.shadowSize;
+    }
+    shadowValues.assign(offset, 0);
+    shadowValid.assign(uniforms.size(), false);
+}
+
+GLint Shader::ShadowUniform(std::uint32_t nameHash, const void *value,
+                            std::size_t size)
+{
+    const std::uint32_t *index = uniformLookup.Find(nameHash);
+    if (index == nullptr)
+        return -1;
+    const UniformInfo &uniform = uniforms[*index];
+    // Block members have no location, nothing would be uploaded
+    if (uniform.location < 0)
+        return -1;
+
+    // A value of the wrong size is GL's error to report, pass it through
+    if (uniform.shadowSize == size)
+    {
+        std::uint8_t *shadow = shadowValues.data() + uniform.shadowOffset;
+        if (shadowValid[*index] && std::memcmp(shadow, value, size) == 0)
+        {
+            uniformStats.skipped++;
+            return -1;
+        }
+        std::memcpy(shadow, value, size);
+        shadowValid[*index] = true;
+    }
+
+    uniformStats.uploads++;
+    return uniform.location;
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, int value)
+{
+    GLint location = ShadowUniform(nameHash, &value, sizeof(value));
+    if (location >= 0)
+    {
+        GLCall(glUniform1i(location, value));
+    }
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, float value)
+{
+    GLint location = ShadowUniform(nameHash, &value, sizeof(value));
+    if (location >= 0)
+    {
+        GLCall(glUniform1f(location, value));
+    }
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, const glm::vec2 &value)
+{
+    GLint location =
+        ShadowUniform(nameHash, glm::value_ptr(value), sizeof(float) * 2);
+    if (location >= 0)
+    {
+        GLCall(glUniform2fv(location, 1, glm::value_ptr(value)));
+    }
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, const glm::vec3 &value)
+{
+    GLint location =
+        ShadowUniform(nameHash, glm::value_ptr(value), sizeof(float) * 3);
+    if (location >= 0)
+    {
+        GLCall(glUniform3fv(location, 1, glm::value_ptr(value)));
+    }
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, const glm::vec4 &value)
+{
+    GLint location =
+        ShadowUniform(nameHash, glm::value_ptr(value), sizeof(float) * 4);
+    if (location >= 0)
+    {
+        GLCall(glUniform4fv(location, 1, glm::value_ptr(value)));
+    }
+}
+
+void Shader::SetUniform(std::uint32_t nameHash, const glm::mat4 &value)
+{
+    GLint location =
+        ShadowUniform(nameHash, glm::value_ptr(value), sizeof(float) * 16);
+    if (location >= 0)
+    {
+        GLCall(glUniformMatrix4fv(location, 1, GL_FALSE,
+                                  glm::value_ptr(value)));
+    }
+}
+
+const UniformStats &Shader::GetUniformStats() const { return uniformStats; }
+
+Shader::Shader(GLuint programID) : program(programID), workGroupSize{0, 0, 0}
+{
+}
 
 Shader::~Shader() {}
@@ -0,0 +1,418 @@
+#include "ShaderBundle.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "SourceStore.hpp"
+#include "StringHash.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <zlib.h>
+
+namespace
+{
+    // Bumped whenever the file layout changes
+    constexpr std::uint32_t BundleVersion = 3;
+
+    // Uncompressed, at the start of the file
+    struct BundleHeader
+    {
+    public:
+        char          magic[4];
+        std::uint32_t version;
+        std::uint32_t payloadBytes; // Once uncompressed
+        std::uint32_t compressedBytes;
+    };
+
+    // The start of the payload, followed by each table in this order and
+    // then the strings
+    struct PayloadHeader
+    {
+    public:
+        std::uint32_t programCount;
+        std::uint32_t keywordCount;
+        std::uint32_t variantCount;
+        std::uint32_t shadeletCount;
+        std::uint32_t textCount;
+        std::uint32_t fileCount;
+        std::uint32_t stringBytes;
+        std::uint64_t manifestList; // See HashManifestList
+    };
+
+    struct StringRef
+    {
+    public:
+        std::uint32_t offset; // Into the strings
+        std::uint32_t length;
+    };
+
+    struct ProgramRecord
+    {
+    public:
+        StringRef     name;
+        std::uint32_t firstKeyword;
+        std::uint32_t keywordCount;
+        std::uint32_t firstVariant;
+        std::uint32_t variantCount;
+    };
+
+    struct VariantRecord
+    {
+    public:
+        std::uint32_t mask;
+        std::uint32_t firstShadelet;
+        std::uint32_t shadeletCount;
+    };
+
+    struct ShadeletRecord
+    {
+    public:
+        std::uint32_t type;
+        std::uint32_t text; // Into the texts
+        StringRef     path;
+    };
+
+    // A manifest or source file the bundle was built from
+    struct FileRecord
+    {
+    public:
+        StringRef     path;
+        std::uint64_t hash; // HashText of its contents
+    };
+
+    // HashText of the paths of every manifest below the directory, relative
+    // to it and sorted, so adding, removing or renaming one changes it
+    std::uint64_t HashManifestList(const std::filesystem::path &directory)
+    {
+        auto list = std::string();
+        for (auto const &manifest :
+             ShaderSource::FindManifests(directory.generic_string()))
+        {
+            list += manifest.lexically_relative(directory).generic_string();
+            list += '\n';
+        }
+        return HashText(list);
+    }
+
+    template <typename T>
+    void Append(std::string &payload, const std::vector<T> &records)
+    {
+        payload.append(reinterpret_cast<const char *>(records.data()),
+                       records.size() * sizeof(T));
+    }
+
+    // Where the next table starts, advancing past it. Null if the payload
+    // is too short to hold it.
+    template <typename T>
+    const T *Take(const std::string &payload, std::size_t &offset,
+                  std::uint32_t count)
+    {
+        std::size_t size = std::size_t(count) * sizeof(T);
+        if (offset + size > payload.size())
+            return nullptr;
+        auto table = reinterpret_cast<const T *>(payload.data() + offset);
+        offset += size;
+        return table;
+    }
+} // namespace
+
+bool ShaderBundle::Write(const std::filesystem::path &    path,
+                         const std::filesystem::path &    shaderDirectory,
+                         const std::vector<ShaderSource> &sources)
+{
+    auto programs  = std::vector<ProgramRecord>();
+    auto keywords  = std::vector<StringRef>();
+    auto variants  = std::vector<VariantRecord>();
+    auto shadelets = std::vector<ShadeletRecord>();
+    auto texts     = std::vector<StringRef>();
+    auto files     = std::vector<FileRecord>();
+    auto strings   = std::string();
+    auto addString = [&](std::string_view string) {
+        auto ref   = StringRef();
+        ref.offset = std::uint32_t(strings.size());
+        ref.length = std::uint32_t(string.size());
+        strings += string;
+        return ref;
+    };
+    // Variants mostly share their shadelets, each text is written once
+    auto textIDs = std::unordered_map<std::string_view, std::uint32_t>();
+    auto addText = [&](std::string_view text) {
+        auto found = textIDs.find(text);
+        if (found != textIDs.end())
+            return found->second;
+        auto id = std::uint32_t(texts.size());
+        texts.push_back(addString(text));
+        textIDs.emplace(text, id);
+        return id;
+    };
+    auto addVariant = [&](std::uint32_t                      mask,
+                          const std::vector<ShadeletSource> &stages) {
+        auto variant          = VariantRecord();
+        variant.mask          = mask;
+        variant.firstShadelet = std::uint32_t(shadelets.size());
+        variant.shadeletCount = std::uint32_t(stages.size());
+        for (auto const &stage : stages)
+        {
+            auto shadelet = ShadeletRecord();
+            shadelet.type = std::uint32_t(stage.GetType());
+            shadelet.text = addText(stage.GetSource());
+            shadelet.path = addString(stage.GetFullPath());
+            shadelets.push_back(shadelet);
+        }
+        variants.push_back(variant);
+    };
+    auto filePaths = std::unordered_set<std::string_view>();
+    auto addFile   = [&](std::string_view path) {
+        if (!filePaths.insert(path).second)
+            return true;
+        auto contents = std::string();
+        if (!ShaderPreprocessor::ReadFile(std::filesystem::path(path),
+                                          contents))
+            return false;
+        // Relative to where the bundle is made, which is where it is used
+        std::error_code error;
+        auto            relative = std::filesystem::proximate(path, error);
+        auto            file     = FileRecord();
+        file.path = addString(error ? std::string(path)
+                                    : relative.generic_string());
+        file.hash = HashText(contents);
+        files.push_back(file);
+        return true;
+    };
+
+    for (auto const &source : sources)
+    {
+        auto program         = ProgramRecord();
+        program.name         = addString(source.GetName());
+        program.firstKeyword = std::uint32_t(keywords.size());
+        program.keywordCount = std::uint32_t(source.GetKeywords().size());
+        program.firstVariant = std::uint32_t(variants.size());
+        for (auto const &keyword : source.GetKeywords())
+            keywords.push_back(addString(keyword));
+        addVariant(0, source.GetShadelets());
+        for (auto const &variant : source.GetVariants())
+            addVariant(variant.first, variant.second);
+        program.variantCount =
+            std::uint32_t(variants.size()) - program.firstVariant;
+        programs.push_back(program);
+
+        bool read = addFile(source.GetManifestPath());
+        for (auto const &shadelet : source.GetShadelets())
+            for (auto file : shadelet.GetSourceFiles())
+                read = addFile(SourceStore::Shared().GetName(file)) && read;
+        if (!read)
+        {
+            std::cerr << "Could not read the files of '" << source.GetName()
+                      << "' to bundle them" << std::endl;
+            return false;
+        }
+    }
+
+    auto header          = PayloadHeader();
+    header.programCount  = std::uint32_t(programs.size());
+    header.keywordCount  = std::uint32_t(keywords.size());
+    header.variantCount  = std::uint32_t(variants.size());
+    header.shadeletCount = std::uint32_t(shadelets.size());
+    header.textCount     = std::uint32_t(texts.size());
+    header.fileCount     = std::uint32_t(files.size());
+    header.stringBytes   = std::uint32_t(strings.size());
+    header.manifestList  = HashManifestList(shaderDirectory);
+
+    auto payload = std::string(reinterpret_cast<const char *>(&header),
+                               sizeof(header));
+    Append(payload, programs);
+    Append(payload, keywords);
+    Append(payload, variants);
+    Append(payload, shadelets);
+    Append(payload, texts);
+    Append(payload, files);
+    payload += strings;
+
+    auto   compressed = std::string(compressBound(uLong(payload.size())), '\0');
+    uLongf compressedSize = uLongf(compressed.size());
+    if (compress2(reinterpret_cast<Bytef *>(&compressed[0]), &compressedSize,
+                  reinterpret_cast<const Bytef *>(payload.data()),
+                  uLong(payload.size()), Z_BEST_COMPRESSION) != Z_OK)
+    {
+        std::cerr << "Could not compress shader bundle" << std::endl;
+        return false;
+    }
+    compressed.resize(compressedSize);
+
+    auto bundleHeader = BundleHeader();
+    std::memcpy(bundleHeader.magic, "GLSB", 4);
+    bundleHeader.version         = BundleVersion;
+    bundleHeader.payloadBytes    = std::uint32_t(payload.size());
+    bundleHeader.compressedBytes = std::uint32_t(compressed.size());
+
+    auto file = std::ofstream(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&bundleHeader),
+               sizeof(bundleHeader));
+    file.write(compressed.data(), std::streamsize(compressed.size()));
+    if (!file)
+    {
+        std::cerr << "Could not write shader bundle '" << path.generic_string()
+                  << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ShaderBundle::Read(const std::filesystem::path &path,
+                        const std::filesystem::path &shaderDirectory,
+                        std::vector<ShaderSource> &  sources)
+{
+    auto file = std::string();
+    if (!ShaderPreprocessor::ReadFile(path, file))
+        return false;
+
+    auto bundleHeader = BundleHeader();
+    if (file.size() < sizeof(bundleHeader))
+        return false;
+    std::memcpy(&bundleHeader, file.data(), sizeof(bundleHeader));
+    if (std::memcmp(bundleHeader.magic, "GLSB", 4) != 0 ||
+        bundleHeader.version != BundleVersion ||
+        file.size() - sizeof(bundleHeader) != bundleHeader.compressedBytes)
+    {
+        std::cerr << "'" << path.generic_string()
+                  << "' is not a shader bundle of this version" << std::endl;
+        return false;
+    }
+
+    auto   payload     = std::string(bundleHeader.payloadBytes, '\0');
+    uLongf payloadSize = uLongf(payload.size());
+    if (uncompress(reinterpret_cast<Bytef *>(&payload[0]), &payloadSize,
+                   reinterpret_cast<const Bytef *>(file.data() +
+                                                   sizeof(bundleHeader)),
+                   uLong(bundleHeader.compressedBytes)) != Z_OK ||
+        payloadSize != payload.size() || payload.size() < sizeof(PayloadHeader))
+    {
+        std::cerr << "Shader bundle '" << path.generic_string()
+                  << "' is damaged" << std::endl;
+        return false;
+    }
+
+    auto header = PayloadHeader();
+    std::memcpy(&header, payload.data(), sizeof(header));
+    std::size_t offset = sizeof(header);
+    auto programs =
+        Take<ProgramRecord>(payload, offset, header.programCount);
+    auto keywords = Take<StringRef>(payload, offset, header.keywordCount);
+    auto variants =
+        Take<VariantRecord>(payload, offset, header.variantCount);
+    auto shadelets =
+        Take<ShadeletRecord>(payload, offset, header.shadeletCount);
+    auto texts = Take<StringRef>(payload, offset, header.textCount);
+    auto files = Take<FileRecord>(payload, offset, header.fileCount);
+    bool valid = programs != nullptr && keywords != nullptr &&
+                 variants != nullptr && shadelets != nullptr &&
+                 texts != nullptr && files != nullptr &&
+                 offset + header.stringBytes == payload.size();
+
+    // Everything is checked before anything is added
+    const char *strings   = payload.data() + offset;
+    auto        inStrings = [&](const StringRef &string) {
+        return std::size_t(string.offset) + string.length <= header.stringBytes;
+    };
+    auto inRange = [&](std::uint32_t first, std::uint32_t count,
+                       std::uint32_t size) {
+        return std::size_t(first) + count <= size;
+    };
+    for (std::uint32_t t = 0; valid && t < header.textCount; t++)
+        valid = inStrings(texts[t]);
+    for (std::uint32_t f = 0; valid && f < header.fileCount; f++)
+        valid = inStrings(files[f].path);
+    for (std::uint32_t s = 0; valid && s < header.shadeletCount; s++)
+        valid = inStrings(shadelets[s].path) &&
+                shadelets[s].text < header.textCount;
+    for (std::uint32_t v = 0; valid && v < header.variantCount; v++)
+        valid = inRange(variants[v].firstShadelet, variants[v].shadeletCount,
+                        header.shadeletCount);
+    for (std::uint32_t p = 0; valid && p < header.programCount; p++)
+    {
+        const ProgramRecord &program = programs[p];
+        valid = inStrings(program.name) && program.variantCount > 0 &&
+                inRange(program.firstKeyword, program.keywordCount,
+                        header.keywordCount) &&
+                inRange(program.firstVariant, program.variantCount,
+                        header.variantCount);
+        for (std::uint32_t k = 0; valid && k < program.keywordCount; k++)
+            valid = inStrings(keywords[program.firstKeyword + k]);
+    }
+    if (!valid)
+    {
+        std::cerr << "Shader bundle '" << path.generic_string()
+                  << "' is damaged" << std::endl;
+        return false;
+    }
+
+    auto view = [&](const StringRef &string) {
+        return std::string_view(strings + string.offset, string.length);
+    };
+
+    // Files that are not there are fine, the sources need not ship with
+    // the bundle. Files that are there must not have changed since, and a
+    // shader directory that is there must hold the same manifests.
+    std::error_code error;
+    if (std::filesystem::is_directory(shaderDirectory, error) &&
+        HashManifestList(shaderDirectory) != header.manifestList)
+    {
+        std::cerr << "Manifests in '" << shaderDirectory.generic_string()
+                  << "' were added or removed since shader bundle '"
+                  << path.generic_string() << "' was built, not using it"
+                  << std::endl;
+        return false;
+    }
+    auto contents = std::string();
+    for (std::uint32_t f = 0; f < header.fileCount; f++)
+    {
+        auto filePath = std::filesystem::path(view(files[f].path));
+        if (!std::filesystem::exists(filePath, error))
+            continue;
+        contents.clear();
+        if (!ShaderPreprocessor::ReadFile(filePath, contents) ||
+            HashText(contents) != files[f].hash)
+        {
+            std::cerr << "'" << filePath.generic_string()
+                      << "' changed since shader bundle '"
+                      << path.generic_string() << "' was built, not using it"
+                      << std::endl;
+            return false;
+        }
+    }
+    auto stages = [&](const VariantRecord &variant) {
+        auto result = std::vector<ShadeletSource>();
+        for (std::uint32_t s = 0; s < variant.shadeletCount; s++)
+        {
+            const ShadeletRecord &shadelet =
+                shadelets[variant.firstShadelet + s];
+            result.emplace_back(view(texts[shadelet.text]),
+                                GLenum(shadelet.type), view(shadelet.path));
+        }
+        return result;
+    };
+    for (std::uint32_t p = 0; p < header.programCount; p++)
+    {
+        const ProgramRecord &program = programs[p];
+        auto                 source  = ShaderSource(view(program.name));
+        for (std::uint32_t k = 0; k < program.keywordCount; k++)
+            source.AddKeyword(
+                std::string(view(keywords[program.firstKeyword + k])));
+        for (std::uint32_t v = 0; v < program.variantCount; v++)
+        {
+            const VariantRecord &variant = variants[program.firstVariant + v];
+            if (v == 0)
+                for (auto &shadelet : stages(variant))
+                    source.AddShadelet(std::move(shadelet));
+            else
+                source.AddVariant(variant.mask, stages(variant));
+        }
+        sources.push_back(std::move(source));
+    }
+    return true;
+}
@@ -0,0 +1,246 @@
+#include "ShaderPreprocessor.hpp"
+#include "SourceStore.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string_view>
+
+ShaderPreprocessor::ShaderPreprocessor() {}
+
+ShaderPreprocessor::~ShaderPreprocessor() {}
+
+std::string ShaderPreprocessor::Normalize(const std::filesystem::path &path)
+{
+    std::error_code error;
+    auto            absolute = std::filesystem::absolute(path, error);
+    if (error)
+        absolute = path;
+    return absolute.lexically_normal().generic_string();
+}
+
+bool ShaderPreprocessor::ReadFile(const std::filesystem::path &path,
+                                  std::string &                contents)
+{
+    // One read of the whole file, its size is known up front
+    std::error_code error;
+    auto            size = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    std::FILE *file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    contents.resize(std::size_t(size));
+    std::size_t read =
+        size > 0 ? std::fread(&contents[0], 1, contents.size(), file) : 0;
+    std::fclose(file);
+    contents.resize(read);
+    return read == std::size_t(size);
+}
+
+const ShaderPreprocessor::ParsedFile *
+    ShaderPreprocessor::Parse(const std::string &path)
+{
+    auto found = files.find(path);
+    if (found != files.end())
+    {
+        stats.reused++;
+        return &found->second;
+    }
+
+    auto text = std::string();
+    if (!ReadFile(path, text))
+    {
+        std::cerr << "Could not open shader source '" << path << "'"
+                  << std::endl;
+        return nullptr;
+    }
+
+    // Split at '#include "file"' lines, which are dropped from the text
+    auto        parsed     = ParsedFile();
+    auto        chunk      = std::string();
+    std::size_t lineNumber = 0;
+    std::size_t lineStart  = 0;
+    chunk.reserve(text.size());
+    while (lineStart < text.size())
+    {
+        std::size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = text.size();
+        auto line = std::string_view(text).substr(lineStart,
+                                                  lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        auto start = line.find_first_not_of(" \t");
+        if (start != std::string_view::npos &&
+            line.compare(start, 8, "#include") == 0)
+        {
+            auto open  = line.find('"', start + 8);
+            auto close = open == std::string_view::npos
+                             ? std::string_view::npos
+                             : line.find('"', open + 1);
+            if (close == std::string_view::npos)
+            {
+                std::cerr << "Malformed #include in '" << path
+                          << "': " << line << std::endl;
+                return nullptr;
+            }
+            parsed.chunks.push_back(std::move(chunk));
+            parsed.includes.emplace_back(
+                line.substr(open + 1, close - open - 1));
+            parsed.includeLines.push_back(lineNumber);
+            chunk = std::string();
+            continue;
+        }
+        if (start != std::string_view::npos &&
+            line.compare(start, 12, "#pragma once") == 0)
+        {
+            // Kept as an empty line, so the numbers still match
+            parsed.once = true;
+            line        = std::string_view();
+        }
+        chunk += line;
+        chunk += '\n';
+    }
+    parsed.chunks.push_back(std::move(chunk));
+    parsed.id = SourceStore::Shared().Intern(path);
+
+    stats.parsed++;
+    return &(files[path] = std::move(parsed));
+}
+
+bool ShaderPreprocessor::Expand(const std::string &          path,
+                                const std::filesystem::path &manifestDirectory,
+                                std::uint32_t                program,
+                                std::string &                contents,
+                                std::vector<std::uint32_t> & sourceFiles,
+                                std::unordered_set<std::string> &pasted,
+                                int                              depth)
+{
+    // Even a file that fails, so fixing it is noticed
+    Depend(path, program);
+    if (depth > MaxIncludeDepth)
+    {
+        std::cerr << "Includes nested too deeply in '" << path << "'"
+                  << std::endl;
+        return false;
+    }
+
+    const ParsedFile *parsed = Parse(path);
+    if (parsed == nullptr)
+        return false;
+    if (parsed->once && !pasted.insert(path).second)
+        return true;
+
+    std::size_t sourceNumber = sourceFiles.size();
+    sourceFiles.push_back(parsed->id);
+    // The shadelet's own file is source string 0 from the start, and a
+    // '#line' may not come before its '#version'
+    if (depth > 0)
+        contents += "#line 1 " + std::to_string(sourceNumber) + "\n";
+
+    // Both directories are already normalized, so joining them only needs
+    // lexically_normal, and a file parsed before is known to exist
+    auto directory = std::filesystem::path(path).parent_path();
+    for (std::size_t i = 0; i < parsed->includes.size(); i++)
+    {
+        contents += parsed->chunks[i];
+
+        auto includePath = (directory / parsed->includes[i])
+                               .lexically_normal()
+                               .generic_string();
+        if (files.count(includePath) == 0 &&
+            !std::filesystem::exists(includePath))
+        {
+            auto fromManifest = (manifestDirectory / parsed->includes[i])
+                                    .lexically_normal()
+                                    .generic_string();
+            if (files.count(fromManifest) != 0 ||
+                std::filesystem::exists(fromManifest))
+                includePath = fromManifest;
+        }
+        if (!Expand(includePath, manifestDirectory, program, contents,
+                    sourceFiles, pasted, depth + 1))
+            return false;
+
+        // Back in this file, on the line after the include
+        contents += "#line " + std::to_string(parsed->includeLines[i] + 1) +
+                    " " + std::to_string(sourceNumber) + "\n";
+    }
+    contents += parsed->chunks.back();
+    return true;
+}
+
+bool ShaderPreprocessor::Process(const std::filesystem::path &path,
+                                 const std::filesystem::path &manifestDirectory,
+                                 const std::string &          program,
+                                 std::string &                contents,
+                                 std::vector<std::uint32_t> & sourceFiles)
+{
+    contents.clear();
+    sourceFiles.clear();
+    auto pasted = std::unordered_set<std::string>();
+    return Expand(Normalize(path), Normalize(manifestDirectory),
+                  SourceStore::Shared().Intern(program), contents,
+                  sourceFiles, pasted, 0);
+}
+
+void ShaderPreprocessor::Depend(const std::string &path, std::uint32_t program)
+{
+    if (dependents[path].insert(program).second)
+        dependencies[program].push_back(path);
+}
+
+void ShaderPreprocessor::AddDependency(const std::filesystem::path &file,
+                                       const std::string &          program)
+{
+    Depend(Normalize(file), SourceStore::Shared().Intern(program));
+}
+
+std::vector<std::string>
+    ShaderPreprocessor::GetDependents(const std::filesystem::path &file) const
+{
+    auto found = dependents.find(Normalize(file));
+    if (found == dependents.end())
+        return std::vector<std::string>();
+    SourceStore &store    = SourceStore::Shared();
+    auto         programs = std::vector<std::string>();
+    for (std::uint32_t program : found->second)
+        programs.push_back(store.GetName(program));
+    std::sort(programs.begin(), programs.end());
+    return programs;
+}
+
+bool ShaderPreprocessor::IsDependency(const std::filesystem::path &file) const
+{
+    return dependents.count(Normalize(file)) != 0;
+}
+
+void ShaderPreprocessor::Invalidate(const std::filesystem::path &file)
+{
+    files.erase(Normalize(file));
+}
+
+void ShaderPreprocessor::ForgetProgram(const std::string &program)
+{
+    std::uint32_t id    = SourceStore::Shared().Intern(program);
+    auto          found = dependencies.find(id);
+    if (found == dependencies.end())
+        return;
+    for (auto const &file : found->second)
+    {
+        auto programs = dependents.find(file);
+        programs->second.erase(id);
+        if (programs->second.empty())
+            dependents.erase(programs);
+    }
+    dependencies.erase(found);
+}
+
+const ShaderPreprocessorStats &ShaderPreprocessor::GetStats() const
+{
+    return stats;
+}
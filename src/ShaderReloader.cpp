@@ -0,0 +1,150 @@
+#include "ShaderReloader.hpp"
+#include "GLState.hpp"
+#include "ShadeletCache.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderVariants.hpp"
+
+#include <iostream>
+#include <memory>
+#include <set>
+
+using namespace std::chrono;
+
+ShaderReloader::ShaderReloader(GLState &                  state,
+                               std::vector<ShaderSource> &sources,
+                               std::vector<Shader> &      shaders,
+                               ShaderPreprocessor &       preprocessor,
+                               ProgramBinaryCache *       binaryCache,
+                               ShadeletCache &            shadeletCache,
+                               ShaderVariants *           variants)
+    : state(state), sources(sources), shaders(shaders),
+      preprocessor(preprocessor), binaryCache(binaryCache),
+      shadeletCache(shadeletCache), variants(variants)
+{
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    // The pending programs are finished only to be thrown away
+    for (auto &reload : reloads)
+        reload.superseded = true;
+    while (!reloads.empty())
+    {
+        Finish(reloads.front());
+        reloads.pop_front();
+    }
+}
+
+bool ShaderReloader::Watch(const std::string &directory)
+{
+    return watcher.Watch(directory);
+}
+
+void ShaderReloader::Submit(std::size_t sourceIndex, std::size_t shaderIndex)
+{
+    auto source = ShaderSource::ReadManifest(
+        sources[sourceIndex].GetManifestPath(), preprocessor);
+    if (!source.has_value())
+    {
+        std::cerr << "Could not read shader '"
+                  << sources[sourceIndex].GetName()
+                  << "' again, keeping the old program" << std::endl;
+        stats.failed++;
+        return;
+    }
+
+    // Only the newest rebuild of a program may replace it
+    for (auto &reload : reloads)
+        if (reload.sourceIndex == sourceIndex)
+            reload.superseded = true;
+
+    reloads.push_back(Reload{sourceIndex, shaderIndex, std::move(*source),
+                             PendingShader(), steady_clock::now()});
+    Reload &reload = reloads.back();
+    reload.pending =
+        Shader::SubmitProgram(reload.source, binaryCache, shadeletCache);
+}
+
+void ShaderReloader::Finish(Reload &reload)
+{
+    auto errors = std::make_unique<std::vector<std::string>>();
+    auto built  = Shader::FinishProgram(reload.pending, errors, binaryCache,
+                                       shadeletCache);
+    if (reload.superseded)
+    {
+        if (built.has_value())
+            glDeleteProgram(built->GetProgram());
+        return;
+    }
+    if (!built.has_value())
+    {
+        for (auto const &error : *errors)
+            std::cerr << error << std::endl;
+        std::cerr << "Keeping the old '" << reload.source.GetName()
+                  << "' program" << std::endl;
+        stats.failed++;
+        return;
+    }
+
+    // Replaced in place, whoever holds the index or a pointer now draws
+    // with the new program
+    GLuint oldProgram           = shaders[reload.shaderIndex].GetProgram();
+    shaders[reload.shaderIndex] = std::move(*built);
+    sources[reload.sourceIndex] = std::move(reload.source);
+    const std::string &name     = sources[reload.sourceIndex].GetName();
+    state.ForgetProgram(oldProgram);
+    glDeleteProgram(oldProgram);
+    if (variants != nullptr)
+        variants->Invalidate(variants->FindFamily(name), state);
+
+    stats.reloaded++;
+    std::cout << "Reloaded shader '" << name
+              << "' in "
+              << duration<double, std::milli>(steady_clock::now() -
+                                              reload.start)
+                     .count()
+              << " ms" << std::endl;
+}
+
+void ShaderReloader::Update()
+{
+    // Every program a changed file went into, each once
+    auto programs = std::set<std::string>();
+    for (auto const &file : watcher.Poll())
+    {
+        preprocessor.Invalidate(file);
+        for (auto const &program : preprocessor.GetDependents(file))
+            programs.insert(program);
+    }
+    for (auto const &program : programs)
+    {
+        long sourceIndex = -1;
+        for (std::size_t i = 0; i < sources.size(); i++)
+            if (sources[i].GetName() == program)
+                sourceIndex = long(i);
+        // Programs that never built have nothing to replace
+        long shaderIndex = Shader::FindShader(shaders, program);
+        if (sourceIndex < 0 || shaderIndex < 0)
+        {
+            std::cerr << "Shader '" << program
+                      << "' changed, restart to load it" << std::endl;
+            continue;
+        }
+        Submit(std::size_t(sourceIndex), std::size_t(shaderIndex));
+    }
+
+    for (auto it = reloads.begin(); it != reloads.end();)
+    {
+        if (!Shader::IsProgramReady(it->pending))
+        {
+            ++it;
+            continue;
+        }
+        Finish(*it);
+        it = reloads.erase(it);
+    }
+}
+
+std::size_t ShaderReloader::GetPendingCount() const { return reloads.size(); }
+
+const ShaderReloadStats &ShaderReloader::GetStats() const { return stats; }
@@ -1,177 +1,284 @@
 #include "ShaderSource.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <optional>
 
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
+#include "JobSystem.hpp"
+#include "JsonDocument.hpp"
+#include "StringHash.hpp"
 
-ShaderSource::ShaderSource(std::string name) { this->name = name; }
+ShaderSource::ShaderSource(std::string_view name)
+    : nameID(SourceStore::Shared().Intern(name))
+{
+}
 
 ShaderSource::~ShaderSource() {}
 
-const std::string &ShaderSource::GetName() const { return this->name; }
+const std::string &ShaderSource::GetName() const
+{
+    return SourceStore::Shared().GetName(nameID);
+}
+
+std::uint32_t ShaderSource::GetNameID() const { return nameID; }
+
+const std::string &ShaderSource::GetManifestPath() const
+{
+    return this->manifestPath;
+}
+
+std::vector<std::filesystem::path>
+    ShaderSource::FindManifests(std::string const &directoryPath,
+                                JobSystem *        jobs)
+{
+    auto manifests   = std::vector<std::filesystem::path>();
+    auto directories = std::vector<std::filesystem::path>();
+
+    // The top level is listed here, each directory below it is walked on
+    // its own
+    std::error_code error;
+    for (auto &entry :
+         std::filesystem::directory_iterator(directoryPath, error))
+    {
+        if (entry.is_directory(error))
+            directories.push_back(entry.path());
+        else if (entry.is_regular_file(error) &&
+                 HasEnding(entry.path().generic_string(), ".json"))
+            manifests.push_back(entry.path());
+    }
+    if (error)
+        std::cerr << "Could not list '" << directoryPath
+                  << "': " << error.message() << std::endl;
+
+    auto found = std::vector<std::vector<std::filesystem::path>>(
+        directories.size());
+    auto walk = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t d = begin; d < end; d++)
+        {
+            std::error_code walkError;
+            for (auto &entry : std::filesystem::recursive_directory_iterator(
+                     directories[d], walkError))
+                if (entry.is_regular_file(walkError) &&
+                    HasEnding(entry.path().generic_string(), ".json"))
+                    found[d].push_back(entry.path());
+        }
+    };
+    if (jobs != nullptr)
+        jobs->ParallelFor(directories.size(), walk, 1);
+    else
+        walk(0, directories.size());
+
+    for (auto &paths : found)
+        manifests.insert(manifests.end(), paths.begin(), paths.end());
+    // Directory order is up to the file system, programs are not
+    std::sort(manifests.begin(), manifests.end());
+    return manifests;
+}
 
 std::vector<ShaderSource>
-    ShaderSource::ReadShaderSources(std::string directoryPath)
+    ShaderSource::ReadShaderSources(std::string         directoryPath,
+                                    ShaderPreprocessor *preprocessor,
+                                    JobSystem *         jobs,
+                                    ManifestIndex *     index)
 {
     auto sources = std::vector<ShaderSource>();
 
+    auto localPreprocessor = std::unique_ptr<ShaderPreprocessor>();
+    if (preprocessor == nullptr)
+    {
+        localPreprocessor = std::make_unique<ShaderPreprocessor>();
+        preprocessor      = localPreprocessor.get();
+    }
+
     if (!std::filesystem::is_directory(directoryPath))
-        return sources; // Just return the vector
+    {
+        std::cout << "Shader directory '" << directoryPath
+                  << "' does not exist" << std::endl;
+        return sources;
+    }
+
+    // Manifests only depend on themselves, so they are parsed in parallel
+    auto paths     = FindManifests(directoryPath, jobs);
+    auto manifests = std::vector<ShaderManifest>(paths.size());
+    auto parsed    = std::atomic<std::size_t>(0);
+    auto parse     = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (index != nullptr &&
+                index->Lookup(paths[i].generic_string(), manifests[i]))
+                continue;
+            ParseManifest(paths[i], manifests[i]);
+            parsed++;
+        }
+    };
+    if (jobs != nullptr)
+        jobs->ParallelFor(manifests.size(), parse);
+    else
+        parse(0, manifests.size());
+    if (index != nullptr)
+        index->Store(manifests);
+
+    // Sources go through the one preprocessor, which reads each file once
+    sources.reserve(manifests.size());
+    for (auto const &manifest : manifests)
+    {
+        if (manifest.name.empty())
+            continue;
+        auto source = BuildSource(manifest, *preprocessor);
+        if (source.has_value())
+            sources.push_back(std::move(*source));
+    }
+    std::cout << "Finished reading " << sources.size() << " shaders, "
+              << parsed << " manifests parsed" << std::endl;
+    return sources;
+}
+
+std::optional<ShaderSource>
+    ShaderSource::ReadManifest(std::filesystem::path const &path,
+                               ShaderPreprocessor &         preprocessor)
+{
+    auto manifest = ShaderManifest();
+    if (!ParseManifest(path, manifest))
+        return std::nullopt;
+    return BuildSource(manifest, preprocessor);
+}
+
+bool ShaderSource::ParseManifest(std::filesystem::path const &path,
+                                 ShaderManifest &             manifest)
+{
+    // The time is taken first, so a write during the read is seen next time
+    std::error_code error;
+    auto            modified = std::filesystem::last_write_time(path, error);
+    auto            text     = std::string();
+    if (error || !ShaderPreprocessor::ReadFile(path, text))
+    {
+        std::cerr << "Could not read '" << path.generic_string() << "'"
+                  << std::endl;
+        return false;
+    }
+    manifest.modified = modified.time_since_epoch().count();
+    manifest.size     = text.size();
+    manifest.hash     = HashContent(text);
+    auto json = JsonDocument();
+    if (!json.Parse(text))
+    {
+        std::cerr << path.generic_string() << ": " << json.GetError()
+                  << std::endl;
+        return false;
+    }
+
+    // Determine if this JSON file represents a shader program
+    auto jsonType = std::string_view();
+    if (!json.FindString(0, "type", jsonType))
+    {
+        std::cerr << "JSON file has no type" << std::endl;
+        return false;
+    }
+    if (jsonType != "shader")
+    {
+        // This is not a shader, remembered so the index can skip it
+        manifest.path = path.generic_string();
+        return false;
+    }
+    // Get the shader programs name
+    auto shaderName = std::string_view();
+    if (!json.FindString(0, "name", shaderName) || shaderName.empty())
+    {
+        std::cerr << "All shaders must have a 'name' field in the root"
+                  << std::endl;
+        return false;
+    }
+
+    std::uint32_t shaderJSONSources = json.Find(0, "sources");
+    if (shaderJSONSources == JsonValue::None ||
+        json.Get(shaderJSONSources).type != JsonType::Array)
+    {
+        std::cerr << "A shader must have sources to create the shader from"
+                  << std::endl;
+        return false;
+    }
 
-    for (auto &dir :
-         std::filesystem::recursive_directory_iterator(directoryPath))
+    manifest.path = path.generic_string();
+    manifest.name = std::string(shaderName);
+
+    // Optional feature keywords, see WithKeywords
+    std::uint32_t shaderKeywords = json.Find(0, "keywords");
+    if (shaderKeywords != JsonValue::None)
+        for (std::uint32_t keyword = json.Get(shaderKeywords).firstChild;
+             keyword != JsonValue::None;
+             keyword = json.Get(keyword).nextSibling)
+            manifest.keywords.emplace_back(json.Get(keyword).text);
+
+    for (std::uint32_t shadeletData = json.Get(shaderJSONSources).firstChild;
+         shadeletData != JsonValue::None;
+         shadeletData = json.Get(shadeletData).nextSibling)
     {
-        std::error_code error;
-        if (dir.exists(error))
+        auto shadeletDirectory = std::string_view();
+        auto shadeletTypeStr   = std::string_view();
+        if (!json.FindString(shadeletData, "path", shadeletDirectory))
         {
-            if (error)
-            {
-                std::cout << error.message() << std::endl;
-                return sources;
-            }
-            if (dir.is_regular_file(error))
-            {
-                if (error)
-                {
-                    std::cout << error.message() << std::endl;
-                    return sources;
-                }
-
-                if (HasEnding(dir.path().generic_string(), ".json"))
-                {
-                    // std::string cleanName = "";
-
-                    namespace pt = boost::property_tree;
-                    auto root    = pt::ptree();
-                    try
-                    {
-                        pt::read_json(dir.path(), root);
-                        // Determine if this JSON file represents a shader
-                        // program
-                        boost::optional<std::string> jsonType =
-                            root.get_optional<std::string>("type");
-                        if (!jsonType.has_value())
-                        {
-                            std::cerr << "JSON file has no type" << std::endl;
-                            continue;
-                        }
-                        if (jsonType.get() != "shader")
-                            continue; // This is not a shader, ignore it
-                        // Get the shader programs name
-                        boost::optional<std::string> shaderName =
-                            root.get_optional<std::string>("name");
-                        if (!shaderName.has_value())
-                        {
-                            std::cerr
-                                << "All shaders must have a 'name' field in "
-                                   "the root"
-                                << std::endl;
-                            continue;
-                        }
-
-                        auto shaderJSONSources =
-                            root.get_child_optional("sources");
-                        if (!shaderJSONSources.has_value())
-                        {
-                            std::cerr
-                                << "A shader must have sources to create the "
-                                   "shader from"
-                                << std::endl;
-                            continue;
-                        }
-                        // The format of the shader source data
-                        struct JSONShaderSourceData
-                        {
-                            std::string dir;
-                            std::string type;
-                        };
-                        auto shaderSource = ShaderSource(shaderName.get());
-                        // Iterate over shadelets
-                        for (auto &shadeletData : shaderJSONSources.get())
-                        {
-                            auto shadeletDirectory =
-                                shadeletData.second.get_optional<std::string>(
-                                    "path");
-                            auto shadeletTypeStr =
-                                shadeletData.second.get_optional<std::string>(
-                                    "type");
-                            if (!shadeletDirectory.has_value())
-                            {
-                                std::cerr
-                                    << "Every shader source must have a "
-                                       "directory "
-                                       "'path' value to tell the loader where "
-                                       "the "
-                                       "source file is located relative to the "
-                                       "shader JSON data file."
-                                    << std::endl;
-                                continue;
-                            }
-                            if (!shadeletTypeStr.has_value())
-                            {
-                                std::cerr
-                                    << "Every shader source must have a type "
-                                       "'type' specified"
-                                    << std::endl;
-                                continue;
-                            }
-
-                            // Find the source file and read it into the shader
-                            // source
-
-                            auto shadeletFullPath =
-                                dir.path().parent_path().append(
-                                    shadeletDirectory.get());
-
-                            std::cout << "Reading: "
-                                      << shadeletFullPath.generic_string()
-                                      << std::endl;
-
-                            auto shadeletSourceFile =
-                                std::ifstream(shadeletFullPath);
-                            auto shadeletContents =
-                                std::string(std::istreambuf_iterator<char>(
-                                                shadeletSourceFile),
-                                            std::istreambuf_iterator<char>());
-
-                            shadeletSourceFile.close();
-
-                            GLenum shadeletType = 0;
-                            if (!GetShaderType(shadeletTypeStr.get(),
-                                               shadeletType))
-                            {
-                                std::cerr
-                                    << "Shadelet must have a valid type. Got: '"
-                                    << shadeletTypeStr << "'" << std::endl;
-                                continue;
-                            }
-                            shaderSource.AddShadelet(
-                                ShadeletSource(shadeletContents, shadeletType,
-                                               shadeletFullPath));
-                        }
-                        sources.push_back(shaderSource);
-                    }
-                    catch (std::exception &e)
-                    {
-                        std::cerr << e.what() << std::endl;
-                        continue;
-                    }
-                }
-            }
+            std::cerr << "Every shader source must have a directory 'path' "
+                         "value to tell the loader where the source file is "
+                         "located relative to the shader JSON data file."
+                      << std::endl;
+            manifest.complete = false;
+            continue;
         }
-        else
+        GLenum shadeletType = 0;
+        if (!json.FindString(shadeletData, "type", shadeletTypeStr) ||
+            !GetShaderType(std::string(shadeletTypeStr), shadeletType))
         {
-            std::cout << "Shader directory '" << directoryPath
-                      << "' does not exist" << std::endl;
+            std::cerr << "Shadelet must have a valid type. Got: '"
+                      << shadeletTypeStr << "'" << std::endl;
+            manifest.complete = false;
+            continue;
         }
+        manifest.shadelets.emplace_back(std::string(shadeletDirectory),
+                                        shadeletType);
     }
-    std::cout << "Finished reading shaders" << std::endl;
-    return sources;
+    return true;
+}
+
+std::optional<ShaderSource>
+    ShaderSource::BuildSource(ShaderManifest const &manifest,
+                              ShaderPreprocessor &  preprocessor)
+{
+    auto shaderSource         = ShaderSource(manifest.name);
+    shaderSource.manifestPath = ShaderPreprocessor::Normalize(manifest.path);
+    // Read again from scratch, so its old files go
+    preprocessor.ForgetProgram(manifest.name);
+    preprocessor.AddDependency(manifest.path, manifest.name);
+    for (auto const &keyword : manifest.keywords)
+        shaderSource.AddKeyword(keyword);
+
+    // A program missing one of its shadelets could still link, and be
+    // wrong, so it is left out instead
+    bool complete  = manifest.complete;
+    auto directory = std::filesystem::path(manifest.path).parent_path();
+    // Only scratch space, the text is kept by the SourceStore
+    auto shadeletContents = std::string();
+    auto shadeletFiles    = std::vector<std::uint32_t>();
+    for (auto const &shadelet : manifest.shadelets)
+    {
+        // Find the source file and read it into the shader source
+        auto shadeletFullPath = directory / shadelet.first;
+        if (!preprocessor.Process(shadeletFullPath, directory, manifest.name,
+                                  shadeletContents, shadeletFiles))
+        {
+            complete = false;
+            continue;
+        }
+        shaderSource.AddShadelet(ShadeletSource(
+            shadeletContents, shadelet.second,
+            shadeletFullPath.generic_string(), shadeletFiles));
+    }
+    if (!complete)
+        return std::nullopt;
+    return shaderSource;
 }
 
 bool ShaderSource::HasEnding(std::string const &fullString,
@@ -190,7 +297,8 @@ bool ShaderSource::GetShaderType(std::string const &typeString, GLenum &type)
     const auto shaderTypes = std::vector<std::pair<std::string, GLenum>>(
         {{"vertex", GL_VERTEX_SHADER},
          {"fragment", GL_FRAGMENT_SHADER},
-         {"geometry", GL_GEOMETRY_SHADER}});
+         {"geometry", GL_GEOMETRY_SHADER},
+         {"compute", GL_COMPUTE_SHADER}});
 
     for (auto shaderType : shaderTypes)
     {
@@ -205,10 +313,134 @@ bool ShaderSource::GetShaderType(std::string const &typeString, GLenum &type)
 
 void ShaderSource::AddShadelet(ShadeletSource shadelet)
 {
-    shadelets.push_back(shadelet);
+    shadelets.push_back(std::move(shadelet));
+}
+
+bool ShaderSource::AddKeyword(std::string keyword)
+{
+    if (keyword.empty() ||
+        std::find(keywords.begin(), keywords.end(), keyword) != keywords.end())
+        return false;
+    if (keywords.size() >= MaxKeywords)
+    {
+        std::cerr << "Shader '" << GetName() << "' has more than "
+                  << MaxKeywords << " keywords, ignoring '" << keyword << "'"
+                  << std::endl;
+        return false;
+    }
+    keywords.push_back(keyword);
+    return true;
+}
+
+void ShaderSource::AddVariant(std::uint32_t               mask,
+                              std::vector<ShadeletSource> variantShadelets)
+{
+    variants.emplace_back(mask, std::move(variantShadelets));
+}
+
+ShaderSource ShaderSource::WithKeywords(std::uint32_t mask) const
+{
+    if (mask == 0)
+        return *this;
+
+    // Variants are told apart by name, the binary cache files them by it
+    auto variantName = GetName();
+    auto defined     = std::vector<std::string>();
+    for (std::size_t k = 0; k < keywords.size(); k++)
+        if ((mask & (1u << k)) != 0)
+        {
+            defined.push_back(keywords[k]);
+            variantName += "+" + keywords[k];
+        }
+    auto variant         = ShaderSource(variantName);
+    variant.keywords     = keywords;
+    variant.manifestPath = manifestPath;
+    for (auto const &prebuilt : variants)
+        if (prebuilt.first == mask)
+        {
+            variant.shadelets = prebuilt.second;
+            return variant;
+        }
+
+    // A shadelet that never mentions a keyword stays the same text, so the
+    // ShadeletCache can share it between variants
+    for (auto const &shadelet : shadelets)
+    {
+        auto used = std::vector<std::string>();
+        for (auto const &keyword : defined)
+            if (shadelet.GetSource().find(keyword) != std::string_view::npos)
+                used.push_back(keyword);
+        variant.AddShadelet(used.empty() ? shadelet
+                                         : shadelet.WithSource(InjectDefines(
+                                               shadelet.GetSource(), used)));
+    }
+    return variant;
+}
+
+ShaderSource
+    ShaderSource::WithShadelets(std::vector<ShadeletSource> newShadelets) const
+{
+    auto program      = *this;
+    program.shadelets = std::move(newShadelets);
+    program.variants.clear();
+    return program;
+}
+
+std::string ShaderSource::InjectDefines(std::string_view                source,
+                                        std::vector<std::string> const &defines)
+{
+    // '#version' has to come first, so the defines go on the line after it
+    auto        result   = std::string(source);
+    std::size_t insertAt = 0;
+    auto        version  = result.find("#version");
+    if (version != std::string::npos)
+    {
+        auto end = result.find('\n', version);
+        if (end == std::string::npos)
+        {
+            result += '\n';
+            end = result.size() - 1;
+        }
+        insertAt = end + 1;
+    }
+
+    auto injected = std::string();
+    for (auto const &define : defines)
+        injected += "#define " + define + " 1\n";
+    // Errors keep the line numbers of the file
+    auto line = std::count(result.begin(), result.begin() + insertAt, '\n');
+    injected += "#line " + std::to_string(line + 1) + "\n";
+
+    result.insert(insertAt, injected);
+    return result;
 }
 
 std::vector<ShadeletSource> const &ShaderSource::GetShadelets() const
 {
     return shadelets;
-}
\ No newline at end of file
+}
+bool ShaderSource::HasStage(GLenum type) const
+{
+    for (auto const &shadelet : shadelets)
+        if (shadelet.GetType() == type)
+            return true;
+    return false;
+}
+
+std::vector<std::string> const &ShaderSource::GetKeywords() const
+{
+    return keywords;
+}
+
+std::vector<ShaderSource::Variant> const &ShaderSource::GetVariants() const
+{
+    return variants;
+}
+
+std::uint32_t ShaderSource::GetKeywordBit(std::string const &keyword) const
+{
+    for (std::size_t k = 0; k < keywords.size(); k++)
+        if (keywords[k] == keyword)
+            return 1u << k;
+    return 0;
+}
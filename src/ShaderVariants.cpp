@@ -0,0 +1,249 @@
+#include "ShaderVariants.hpp"
+#include "GLState.hpp"
+#include "ShadeletCache.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+ShaderVariants::ShaderVariants(const std::vector<ShaderSource> &sources,
+                               std::vector<Shader> &            shaders,
+                               ProgramBinaryCache *             binaryCache,
+                               ShadeletCache &                  shadeletCache)
+    : binaryCache(binaryCache), shadeletCache(&shadeletCache)
+{
+    for (auto const &source : sources)
+    {
+        auto family   = Family();
+        family.source = &source;
+        std::size_t variantCount = std::size_t(1)
+                                   << source.GetKeywords().size();
+        family.shaders.assign(variantCount, nullptr);
+        family.states.assign(variantCount, VariantState::Missing);
+
+        // Mask 0 is already built, or failed to
+        long base = Shader::FindShader(shaders, source.GetName());
+        if (base >= 0)
+        {
+            family.shaders[0] = &shaders[std::size_t(base)];
+            family.states[0]  = VariantState::Ready;
+        }
+        else
+            family.states[0] = VariantState::Failed;
+        families.push_back(std::move(family));
+    }
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    // Nothing may keep waiting on a program that nobody will finish
+    while (!compiling.empty())
+        Finish(compiling.back());
+}
+
+long ShaderVariants::FindFamily(const std::string &name) const
+{
+    for (std::size_t i = 0; i < families.size(); i++)
+        if (families[i].source->GetName() == name)
+            return long(i);
+    return -1;
+}
+
+std::uint32_t
+    ShaderVariants::GetMask(long                            family,
+                            const std::vector<std::string> &keywords) const
+{
+    if (family < 0 || std::size_t(family) >= families.size())
+        return 0;
+    std::uint32_t mask = 0;
+    for (auto const &keyword : keywords)
+        mask |= families[std::size_t(family)].source->GetKeywordBit(keyword);
+    return mask;
+}
+
+std::size_t ShaderVariants::Submit(std::size_t family, std::uint32_t mask)
+{
+    // Slots of invalidated and failed variants are reused first, nothing
+    // points into them anymore
+    std::size_t index = variants.size();
+    if (!freeVariants.empty())
+    {
+        index = freeVariants.back();
+        freeVariants.pop_back();
+    }
+    else
+        variants.push_back(Variant{ShaderSource(""), PendingShader(),
+                                   std::nullopt, NoFamily, 0});
+
+    Variant &variant = variants[index];
+    variant.source   = families[family].source->WithKeywords(mask);
+    variant.family   = family;
+    variant.mask     = mask;
+    variant.pending =
+        Shader::SubmitProgram(variant.source, binaryCache, *shadeletCache);
+
+    families[family].states[mask] = VariantState::Compiling;
+    compiling.push_back(index);
+    return index;
+}
+
+Shader *ShaderVariants::Finish(std::size_t index)
+{
+    Variant &variant = variants[index];
+
+    auto errors    = std::make_unique<std::vector<std::string>>();
+    variant.shader = Shader::FinishProgram(variant.pending, errors,
+                                           binaryCache, *shadeletCache);
+    for (auto const &error : *errors)
+        std::cerr << error << std::endl;
+
+    compiling.erase(std::find(compiling.begin(), compiling.end(), index));
+
+    Family &family = families[variant.family];
+    if (!variant.shader.has_value())
+    {
+        family.states[variant.mask] = VariantState::Failed;
+        Release(index);
+        return nullptr;
+    }
+    family.shaders[variant.mask] = &*variant.shader;
+    family.states[variant.mask]  = VariantState::Ready;
+    return family.shaders[variant.mask];
+}
+
+void ShaderVariants::Release(std::size_t index)
+{
+    Variant &variant = variants[index];
+    variant.source   = ShaderSource("");
+    variant.pending  = PendingShader();
+    variant.shader.reset();
+    variant.family = NoFamily;
+    freeVariants.push_back(index);
+}
+
+Shader *ShaderVariants::GetVariant(long family, std::uint32_t mask)
+{
+    if (family < 0 || std::size_t(family) >= families.size() ||
+        mask >= families[std::size_t(family)].states.size())
+        return nullptr;
+
+    Family &entry = families[std::size_t(family)];
+    switch (entry.states[mask])
+    {
+        case VariantState::Ready: return entry.shaders[mask];
+        case VariantState::Failed: return nullptr;
+        case VariantState::Compiling:
+            for (std::size_t index : compiling)
+                if (variants[index].family == std::size_t(family) &&
+                    variants[index].mask == mask)
+                    return Finish(index);
+            return nullptr;
+        default:
+            // Any queued entry is skipped by Update once this is built
+            return Finish(Submit(std::size_t(family), mask));
+    }
+}
+
+Shader *ShaderVariants::TryGetVariant(long family, std::uint32_t mask)
+{
+    if (family < 0 || std::size_t(family) >= families.size() ||
+        mask >= families[std::size_t(family)].states.size())
+        return nullptr;
+
+    Family &entry = families[std::size_t(family)];
+    if (entry.states[mask] == VariantState::Missing)
+        Warm(family, mask);
+    return entry.shaders[mask];
+}
+
+void ShaderVariants::Warm(long family, std::uint32_t mask)
+{
+    if (family < 0 || std::size_t(family) >= families.size() ||
+        mask >= families[std::size_t(family)].states.size())
+        return;
+
+    Family &entry = families[std::size_t(family)];
+    if (entry.states[mask] != VariantState::Missing)
+        return;
+    entry.states[mask] = VariantState::Queued;
+    warmQueue.emplace_back(std::size_t(family), mask);
+}
+
+void ShaderVariants::Invalidate(long family, GLState &state)
+{
+    if (family < 0 || std::size_t(family) >= families.size())
+        return;
+
+    // Those in flight were submitted from the old source
+    for (std::size_t i = 0; i < compiling.size();)
+    {
+        if (variants[compiling[i]].family == std::size_t(family))
+            Finish(compiling[i]);
+        else
+            i++;
+    }
+    for (std::size_t i = 0; i < variants.size(); i++)
+    {
+        Variant &variant = variants[i];
+        if (variant.family != std::size_t(family))
+            continue;
+        if (variant.shader.has_value())
+        {
+            state.ForgetProgram(variant.shader->GetProgram());
+            glDeleteProgram(variant.shader->GetProgram());
+        }
+        Release(i);
+    }
+
+    // The base program is swapped in place, so it stays
+    Family &    entry        = families[std::size_t(family)];
+    Shader *    base         = entry.shaders[0];
+    std::size_t variantCount = std::size_t(1)
+                               << entry.source->GetKeywords().size();
+    entry.shaders.assign(variantCount, nullptr);
+    entry.states.assign(variantCount, VariantState::Missing);
+    entry.shaders[0] = base;
+    entry.states[0]  = base != nullptr ? VariantState::Ready
+                                       : VariantState::Failed;
+}
+
+void ShaderVariants::Update(std::size_t maxSubmits)
+{
+    // Spread over frames, so no one frame submits the whole queue
+    std::size_t submitted = 0;
+    while (!warmQueue.empty() && submitted < maxSubmits)
+    {
+        auto next = warmQueue.front();
+        warmQueue.pop_front();
+        // Invalidate may have dropped it since
+        auto const &states = families[next.first].states;
+        if (next.second >= states.size() ||
+            states[next.second] != VariantState::Queued)
+            continue;
+        Submit(next.first, next.second);
+        submitted++;
+    }
+
+    // Only what the driver has finished, Finish changes compiling
+    for (std::size_t i = 0; i < compiling.size();)
+    {
+        if (Shader::IsProgramReady(variants[compiling[i]].pending))
+            Finish(compiling[i]);
+        else
+            i++;
+    }
+}
+
+std::size_t ShaderVariants::GetQueuedCount() const
+{
+    return warmQueue.size() + compiling.size();
+}
+
+std::size_t ShaderVariants::GetBuiltCount() const
+{
+    std::size_t count = 0;
+    for (auto const &variant : variants)
+        if (variant.shader.has_value())
+            count++;
+    return count;
+}
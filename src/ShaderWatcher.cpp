@@ -0,0 +1,125 @@
+#include "ShaderWatcher.hpp"
+#include "ShaderPreprocessor.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+ShaderWatcher::ShaderWatcher() : fd(-1) {}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+bool ShaderWatcher::WatchDirectory(const std::string &directory)
+{
+#ifdef __linux__
+    // Editors either write in place or rename a new file over the old one
+    int watch = inotify_add_watch(fd, directory.c_str(),
+                                  IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watch < 0)
+    {
+        std::cerr << "Could not watch '" << directory
+                  << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    directories[watch] = directory;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ShaderWatcher::Watch(const std::string &directory)
+{
+#ifdef __linux__
+    if (fd < 0)
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "Could not start inotify: " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+
+    auto root = ShaderPreprocessor::Normalize(directory);
+    if (!WatchDirectory(root))
+        return false;
+    std::error_code error;
+    for (auto &entry :
+         std::filesystem::recursive_directory_iterator(root, error))
+        if (entry.is_directory(error))
+            WatchDirectory(ShaderPreprocessor::Normalize(entry.path()));
+    return true;
+#else
+    std::cerr << "Watching shader files needs inotify" << std::endl;
+    return false;
+#endif
+}
+
+bool ShaderWatcher::IsWatching() const { return !directories.empty(); }
+
+std::vector<std::string> ShaderWatcher::Poll()
+{
+    auto changed = std::vector<std::string>();
+#ifdef __linux__
+    if (fd < 0)
+        return changed;
+
+    auto seen = std::unordered_set<std::string>();
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN, nothing more for now
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            auto event =
+                reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += ssize_t(sizeof(inotify_event) + event->len);
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0)
+                std::cerr << "Too many file changes at once, some were missed"
+                          << std::endl;
+            if ((event->mask & IN_IGNORED) != 0)
+            {
+                directories.erase(event->wd);
+                continue;
+            }
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || event->len == 0)
+                continue;
+
+            auto path = ShaderPreprocessor::Normalize(
+                std::filesystem::path(directory->second) / event->name);
+            if ((event->mask & IN_ISDIR) != 0)
+            {
+                // New directories are only watched, their files are new too
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+                    WatchDirectory(path);
+                continue;
+            }
+            // A created file is reported again once it is written
+            if ((event->mask & IN_CREATE) != 0)
+                continue;
+            if (seen.insert(path).second)
+                changed.push_back(path);
+        }
+    }
+#endif
+    return changed;
+}
@@ -0,0 +1,103 @@
+#include "SourceStore.hpp"
+#include "StringHash.hpp"
+
+std::string_view SourceText::GetText() const
+{
+    return stored ? std::string_view(stored->text) : std::string_view();
+}
+
+std::uint64_t SourceText::GetHash() const
+{
+    return stored ? stored->hash : HashText(std::string_view());
+}
+
+SourceStore::SourceStore() {}
+
+SourceStore::~SourceStore() {}
+
+SourceStore &SourceStore::Shared()
+{
+    static SourceStore store;
+    return store;
+}
+
+SourceText SourceStore::Add(std::string_view text)
+{
+    auto          result = SourceText();
+    std::uint64_t hash   = HashText(text);
+
+    {
+        auto lock  = std::lock_guard<std::mutex>(mutex);
+        auto range = texts.equal_range(hash);
+        for (auto found = range.first; found != range.second; found++)
+            if (found->second.text->text == text)
+            {
+                // Fails when the last holder is just releasing it
+                result.stored = found->second.handle.lock();
+                if (result.stored)
+                {
+                    stats.shared++;
+                    return result;
+                }
+            }
+    }
+
+    // Copied outside the lock, the store only needs to see the result
+    auto stored   = new SourceText::Stored();
+    stored->text  = std::string(text);
+    stored->hash  = hash;
+    result.stored = std::shared_ptr<const SourceText::Stored>(
+        stored, [this](const SourceText::Stored *text) { Release(text); });
+
+    auto lock    = std::lock_guard<std::mutex>(mutex);
+    auto entry   = Entry();
+    entry.text   = stored;
+    entry.handle = result.stored;
+    texts.emplace(hash, entry);
+    stats.stored++;
+    stats.bytes += text.size();
+    return result;
+}
+
+void SourceStore::Release(const SourceText::Stored *text)
+{
+    {
+        auto lock  = std::lock_guard<std::mutex>(mutex);
+        auto range = texts.equal_range(text->hash);
+        for (auto found = range.first; found != range.second; found++)
+            if (found->second.text == text)
+            {
+                texts.erase(found);
+                break;
+            }
+        stats.released++;
+        stats.bytes -= text->text.size();
+    }
+    delete text;
+}
+
+std::uint32_t SourceStore::Intern(std::string_view name)
+{
+    auto lock  = std::lock_guard<std::mutex>(mutex);
+    auto found = nameIDs.find(name);
+    if (found != nameIDs.end())
+        return found->second;
+
+    // A deque keeps every name where it is, so the keys stay valid
+    auto id = std::uint32_t(names.size());
+    names.emplace_back(name);
+    nameIDs.emplace(names.back(), id);
+    return id;
+}
+
+const std::string &SourceStore::GetName(std::uint32_t id) const
+{
+    auto lock = std::lock_guard<std::mutex>(mutex);
+    return names[id];
+}
+
+SourceStoreStats SourceStore::GetStats() const
+{
+    auto lock = std::lock_guard<std::mutex>(mutex);
+    return stats;
+}
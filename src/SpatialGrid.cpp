@@ -0,0 +1,360 @@
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// Below this many objects per job, MoveMany is not worth splitting
+static constexpr std::size_t MinMovesPerJob = 4096;
+
+std::size_t SpatialGrid::CellHash::operator()(const glm::ivec3 &coord) const
+{
+    // 21 bits per axis, so cells two million apart share a hash. The lookup
+    // still compares whole coordinates, they never share a cell.
+    constexpr std::uint64_t mask = 0x1FFFFF;
+    std::uint64_t key = ((std::uint64_t(coord.x) & mask) << 42) |
+                        ((std::uint64_t(coord.y) & mask) << 21) |
+                        (std::uint64_t(coord.z) & mask);
+
+    // Packed coordinates hash badly as-is, mix the bits (splitmix64)
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return std::size_t(key);
+}
+
+SpatialGrid::SpatialGrid(float size)
+    : cellSize(size), inverseCellSize(1.0f / size),
+      usedLo(INT_MAX, INT_MAX, INT_MAX), usedHi(INT_MIN, INT_MIN, INT_MIN)
+{
+}
+
+SpatialGrid::~SpatialGrid() {}
+
+glm::ivec3 SpatialGrid::CellCoord(const glm::vec3 &position) const
+{
+    return glm::ivec3(int(std::floor(position.x * inverseCellSize)),
+                      int(std::floor(position.y * inverseCellSize)),
+                      int(std::floor(position.z * inverseCellSize)));
+}
+
+std::uint32_t SpatialGrid::TargetCell(const glm::vec4 &sphere)
+{
+    if (sphere.w > cellSize * 0.5f)
+        return OversizedCell;
+
+    glm::ivec3 coord = CellCoord(glm::vec3(sphere));
+
+    auto found = cellLookup.find(coord);
+    if (found != cellLookup.end())
+        return found->second;
+
+    std::uint32_t index = 0;
+    if (!freeCells.empty())
+    {
+        index = freeCells.back();
+        freeCells.pop_back();
+    }
+    else
+    {
+        index = std::uint32_t(cells.size());
+        cells.push_back(GridCell());
+    }
+    cells[index].coord = coord;
+    cellLookup[coord]  = index;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        usedLo[axis] = std::min(usedLo[axis], coord[axis]);
+        usedHi[axis] = std::max(usedHi[axis], coord[axis]);
+    }
+    return index;
+}
+
+void SpatialGrid::Link(ObjectID id, const glm::vec4 &sphere)
+{
+    std::uint32_t cellIndex = TargetCell(sphere);
+    Object &      object    = objects[id];
+    object.cell             = cellIndex;
+
+    if (cellIndex == OversizedCell)
+    {
+        object.slot = std::uint32_t(oversizedIDs.size());
+        oversizedIDs.push_back(id);
+        oversizedSpheres.push_back(sphere);
+        return;
+    }
+
+    GridCell &cell = cells[cellIndex];
+    object.slot    = std::uint32_t(cell.ids.size());
+    cell.ids.push_back(id);
+    cell.spheres.push_back(sphere);
+}
+
+void SpatialGrid::Unlink(ObjectID id)
+{
+    Object &object = objects[id];
+
+    // Swap-remove, patching the slot of whichever object fills the hole
+    auto swapRemove = [&](std::vector<ObjectID> & ids,
+                          std::vector<glm::vec4> &spheres) {
+        ObjectID last        = ids.back();
+        ids[object.slot]     = last;
+        spheres[object.slot] = spheres.back();
+        objects[last].slot   = object.slot;
+        ids.pop_back();
+        spheres.pop_back();
+    };
+
+    if (object.cell == OversizedCell)
+    {
+        swapRemove(oversizedIDs, oversizedSpheres);
+        return;
+    }
+
+    GridCell &cell = cells[object.cell];
+    swapRemove(cell.ids, cell.spheres);
+
+    // Hand empty cells back so the cell array stays dense
+    if (cell.ids.empty())
+    {
+        cellLookup.erase(cell.coord);
+        freeCells.push_back(object.cell);
+    }
+}
+
+SpatialGrid::ObjectID SpatialGrid::Insert(const glm::vec3 &center,
+                                          float            radius)
+{
+    ObjectID id = 0;
+    if (!freeIDs.empty())
+    {
+        id = freeIDs.back();
+        freeIDs.pop_back();
+    }
+    else
+    {
+        id = ObjectID(objects.size());
+        objects.push_back(Object());
+    }
+    objects[id].alive = true;
+    Link(id, glm::vec4(center, radius));
+    return id;
+}
+
+void SpatialGrid::Move(ObjectID id, const glm::vec3 &center, float radius)
+{
+    if (id >= objects.size() || !objects[id].alive)
+        return;
+
+    Object &  object = objects[id];
+    glm::vec4 sphere = glm::vec4(center, radius);
+
+    // Staying in the same cell is just an in-place update
+    if (object.cell == OversizedCell)
+    {
+        if (radius > cellSize * 0.5f)
+        {
+            oversizedSpheres[object.slot] = sphere;
+            return;
+        }
+    }
+    else if (radius <= cellSize * 0.5f &&
+             cells[object.cell].coord == CellCoord(center))
+    {
+        cells[object.cell].spheres[object.slot] = sphere;
+        return;
+    }
+
+    Unlink(id);
+    Link(id, sphere);
+}
+
+void SpatialGrid::Remove(ObjectID id)
+{
+    if (id >= objects.size() || !objects[id].alive)
+        return;
+    Unlink(id);
+    objects[id].alive = false;
+    freeIDs.push_back(id);
+}
+
+void SpatialGrid::Clear()
+{
+    cells.clear();
+    freeCells.clear();
+    cellLookup.clear();
+    usedLo = glm::ivec3(INT_MAX, INT_MAX, INT_MAX);
+    usedHi = glm::ivec3(INT_MIN, INT_MIN, INT_MIN);
+    objects.clear();
+    freeIDs.clear();
+    oversizedIDs.clear();
+    oversizedSpheres.clear();
+}
+
+void SpatialGrid::MoveMany(JobSystem &jobs, const ObjectID *ids,
+                           const glm::vec4 *spheres, std::size_t count)
+{
+    rebinScratch.clear();
+
+    // First pass, in parallel: update objects that stay in their cell and
+    // note the ones that do not. Cells are only read here, never resized.
+    auto updateRange = [&](std::size_t begin, std::size_t end) {
+        auto  rebin = std::vector<std::uint32_t>();
+        float half  = cellSize * 0.5f;
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const Object &   object = objects[ids[i]];
+            const glm::vec4 &sphere = spheres[i];
+            if (object.cell == OversizedCell)
+            {
+                if (sphere.w > half)
+                    oversizedSpheres[object.slot] = sphere;
+                else
+                    rebin.push_back(std::uint32_t(i));
+            }
+            else if (sphere.w <= half &&
+                     cells[object.cell].coord == CellCoord(glm::vec3(sphere)))
+                cells[object.cell].spheres[object.slot] = sphere;
+            else
+                rebin.push_back(std::uint32_t(i));
+        }
+
+        if (!rebin.empty())
+        {
+            std::lock_guard<std::mutex> lock(rebinMutex);
+            rebinScratch.insert(rebinScratch.end(), rebin.begin(),
+                                rebin.end());
+        }
+    };
+    jobs.ParallelFor(count, updateRange,
+                     std::max(MinMovesPerJob,
+                              count / (jobs.GetThreadCount() * 4) + 1));
+
+    // Second pass: only a small fraction of objects cross a cell boundary
+    // in one frame, so these are rebinned serially
+    for (auto i : rebinScratch)
+    {
+        ObjectID id = ids[i];
+        Unlink(id);
+        Link(id, spheres[i]);
+    }
+}
+
+void SpatialGrid::QueryRadius(const glm::vec3 &center, float radius,
+                              std::vector<ObjectID> &results) const
+{
+    auto testSpheres = [&](const std::vector<ObjectID> & ids,
+                           const std::vector<glm::vec4> &spheres) {
+        for (std::size_t i = 0; i < ids.size(); i++)
+        {
+            glm::vec3 offset = glm::vec3(spheres[i]) - center;
+            float     reach  = radius + spheres[i].w;
+            if (glm::dot(offset, offset) <= reach * reach)
+                results.push_back(ids[i]);
+        }
+    };
+
+    testSpheres(oversizedIDs, oversizedSpheres);
+
+    // Objects poke out of their cell by up to half a cell
+    float      reach = radius + cellSize * 0.5f;
+    glm::ivec3 lo    = CellCoord(center - glm::vec3(reach));
+    glm::ivec3 hi    = CellCoord(center + glm::vec3(reach));
+
+    double rangeCells = double(hi.x - lo.x + 1) * double(hi.y - lo.y + 1) *
+                        double(hi.z - lo.z + 1);
+
+    // A huge radius covers more cells than exist, walk the occupied ones
+    if (rangeCells > double(cellLookup.size()))
+    {
+        for (auto const &cell : cells)
+            if (!cell.ids.empty())
+                testSpheres(cell.ids, cell.spheres);
+        return;
+    }
+
+    for (int x = lo.x; x <= hi.x; x++)
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int z = lo.z; z <= hi.z; z++)
+            {
+                auto found = cellLookup.find(glm::ivec3(x, y, z));
+                if (found == cellLookup.end())
+                    continue;
+                const GridCell &cell = cells[found->second];
+                testSpheres(cell.ids, cell.spheres);
+            }
+}
+
+void SpatialGrid::QueryFrustum(const Frustum &        frustum,
+                               std::vector<ObjectID> &results) const
+{
+    for (std::size_t i = 0; i < oversizedIDs.size(); i++)
+        if (frustum.IntersectsSphere(glm::vec3(oversizedSpheres[i]),
+                                     oversizedSpheres[i].w))
+            results.push_back(oversizedIDs[i]);
+
+    float half     = cellSize * 0.5f;
+    auto  testCell = [&](const GridCell &cell) {
+        // Reject whole cells by their loose bounds first
+        glm::vec3 cellMin = glm::vec3(float(cell.coord.x) * cellSize - half,
+                                      float(cell.coord.y) * cellSize - half,
+                                      float(cell.coord.z) * cellSize - half);
+        glm::vec3 cellMax = cellMin + glm::vec3(cellSize + 2.0f * half);
+        if (!frustum.IntersectsAABB(cellMin, cellMax))
+            return;
+
+        for (std::size_t i = 0; i < cell.ids.size(); i++)
+            if (frustum.IntersectsSphere(glm::vec3(cell.spheres[i]),
+                                         cell.spheres[i].w))
+                results.push_back(cell.ids[i]);
+    };
+
+    // Only the used cells under the frustum's bounds, grown by how far
+    // objects poke out of their cell, can hold anything visible
+    glm::vec3 min, max;
+    if (frustum.ComputeBounds(min, max))
+    {
+        glm::ivec3 lo = CellCoord(min - glm::vec3(half));
+        glm::ivec3 hi = CellCoord(max + glm::vec3(half));
+        for (int axis = 0; axis < 3; axis++)
+        {
+            lo[axis] = std::max(lo[axis], usedLo[axis]);
+            hi[axis] = std::min(hi[axis], usedHi[axis]);
+            if (lo[axis] > hi[axis])
+                return; // Nothing used is in view
+        }
+
+        double rangeCells = double(hi.x - lo.x + 1) *
+                            double(hi.y - lo.y + 1) * double(hi.z - lo.z + 1);
+        if (rangeCells <= double(cellLookup.size()))
+        {
+            for (int x = lo.x; x <= hi.x; x++)
+                for (int y = lo.y; y <= hi.y; y++)
+                    for (int z = lo.z; z <= hi.z; z++)
+                    {
+                        auto found = cellLookup.find(glm::ivec3(x, y, z));
+                        if (found != cellLookup.end())
+                            testCell(cells[found->second]);
+                    }
+            return;
+        }
+    }
+
+    // An unbounded frustum, or one covering more cells than exist, walks
+    // the occupied ones
+    for (auto const &cell : cells)
+        if (!cell.ids.empty())
+            testCell(cell);
+}
+
+std::size_t SpatialGrid::GetObjectCount() const
+{
+    return objects.size() - freeIDs.size();
+}
+
+std::size_t SpatialGrid::GetCellCount() const { return cellLookup.size(); }
+
+float SpatialGrid::GetCellSize() const { return cellSize; }
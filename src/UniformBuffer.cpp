@@ -0,0 +1,106 @@
+#include "UniformBuffer.hpp"
+#include "GLState.hpp"
+#include "OpenGLExtensions.hpp"
+
+UniformBuffer::UniformBuffer()
+    : buffer(0), size(0), usage(GL_DYNAMIC_DRAW), state(nullptr),
+      direct(false)
+{
+}
+
+UniformBuffer::UniformBuffer(UniformBuffer &&other)
+    : buffer(other.buffer), size(other.size), usage(other.usage),
+      state(other.state), direct(other.direct)
+{
+    other.buffer = 0;
+    other.size   = 0;
+}
+
+UniformBuffer::~UniformBuffer() { ClearBuffer(); }
+
+void UniformBuffer::CreateBuffer(GLState &glState, GLsizeiptr bufferSize,
+                                 GLenum bufferUsage)
+{
+    ClearBuffer();
+    size   = bufferSize;
+    usage  = bufferUsage;
+    state  = &glState;
+    direct = HasDirectStateAccess();
+    if (direct)
+    {
+        // Mutable storage, orphaning needs glNamedBufferData
+        GLCall(glCreateBuffers(1, &buffer));
+        GLCall(glNamedBufferData(buffer, size, nullptr, usage));
+        return;
+    }
+    GLCall(glGenBuffers(1, &buffer));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, usage));
+}
+
+void UniformBuffer::UpdateBuffer(const void *data, GLsizeiptr dataSize,
+                                 GLintptr offset)
+{
+    bool whole = offset == 0 && dataSize == size;
+    if (direct)
+    {
+        if (whole)
+        {
+            GLCall(glNamedBufferData(buffer, size, data, usage));
+        }
+        else
+        {
+            GLCall(glNamedBufferSubData(buffer, offset, dataSize, data));
+        }
+        return;
+    }
+
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    if (whole)
+    {
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage));
+    }
+    else
+    {
+        GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, dataSize, data));
+    }
+}
+
+void UniformBuffer::OrphanBuffer()
+{
+    if (direct)
+    {
+        GLCall(glNamedBufferData(buffer, size, nullptr, usage));
+        return;
+    }
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, usage));
+}
+
+void UniformBuffer::BindBase(GLuint binding)
+{
+    state->BindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+void UniformBuffer::BindRange(GLuint binding, GLintptr offset,
+                              GLsizeiptr rangeSize)
+{
+    state->BindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset,
+                           rangeSize);
+}
+
+void UniformBuffer::ClearBuffer()
+{
+    if (buffer != 0)
+    {
+        if (state != nullptr)
+            state->ForgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    size   = 0;
+}
+
+GLuint UniformBuffer::GetBuffer() const { return buffer; }
+
+GLsizeiptr UniformBuffer::GetSize() const { return size; }
@@ -0,0 +1,78 @@
+#include "UniformRing.hpp"
+#include "OpenGLExtensions.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+UniformRing::UniformRing()
+    : state(nullptr), capacity(0), alignment(256), head(0)
+{
+}
+
+UniformRing::~UniformRing() { ClearRing(); }
+
+void UniformRing::CreateRing(GLState &glState, std::size_t ringCapacity)
+{
+    state = &glState;
+
+    GLint offsetAlignment = 0;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment));
+    alignment = std::max<std::size_t>(1, std::size_t(offsetAlignment));
+
+    capacity = ringCapacity;
+    staging  = std::make_unique<std::uint8_t[]>(capacity);
+    buffer.CreateBuffer(*state, GLsizeiptr(capacity), GL_STREAM_DRAW);
+    head = 0;
+}
+
+void UniformRing::ClearRing()
+{
+    buffer.ClearBuffer();
+    staging.reset();
+    capacity = 0;
+    head     = 0;
+}
+
+void UniformRing::BeginFrame(std::size_t reserve)
+{
+    if (reserve > capacity)
+    {
+        // Grow geometrically so a slowly growing scene does not
+        // reallocate every frame
+        capacity = std::max(reserve, capacity * 2);
+        staging  = std::make_unique<std::uint8_t[]>(capacity);
+        buffer.CreateBuffer(*state, GLsizeiptr(capacity), GL_STREAM_DRAW);
+    }
+    head = 0;
+}
+
+std::size_t UniformRing::AlignedSize(std::size_t size) const
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+GLintptr UniformRing::Push(const void *data, std::size_t size)
+{
+    std::size_t offset =
+        head.fetch_add(AlignedSize(size), std::memory_order_relaxed);
+    if (offset + size > capacity)
+        return InvalidOffset;
+    std::memcpy(staging.get() + offset, data, size);
+    return GLintptr(offset);
+}
+
+void UniformRing::Flush()
+{
+    std::size_t used = std::min(head.load(), capacity);
+    if (used == 0)
+        return;
+    // One write for the whole frame, into fresh storage so the previous
+    // frame's draws are not waited on
+    buffer.OrphanBuffer();
+    buffer.UpdateBuffer(staging.get(), GLsizeiptr(used));
+}
+
+void UniformRing::BindRange(GLuint binding, GLintptr offset, GLsizeiptr size)
+{
+    buffer.BindRange(binding, offset, size);
+}
@@ -1,10 +1,13 @@
 #include "Vertex.hpp"
+#include "GLState.hpp"
 #include "OpenGLExtensions.hpp"
 
 // #include <iostream>
 
 #include <cstdint>
 
+static GLuint sharedVertexArray = 0;
+
 Vertex::Vertex() {}
 
 Vertex::Vertex(GLfloat pos_x, GLfloat pos_y, GLfloat pos_z, GLfloat uv_x = 0.0f,
@@ -20,11 +23,11 @@ Vertex::Vertex(GLfloat pos_x, GLfloat pos_y, GLfloat pos_z, GLfloat uv_x = 0.0f,
 
 Vertex::~Vertex() {}
 
-GLuint Vertex::GenerateAttributes()
+GLuint Vertex::GenerateAttributes(GLState &state)
 {
     GLuint vao = 0;
     GLCall(glGenVertexArrays(1, &vao));
-    GLCall(glBindVertexArray(vao));
+    state.BindVertexArray(vao);
     // Vertex attributes
     GLCall(glEnableVertexAttribArray(0));
 
@@ -43,4 +46,38 @@ GLuint Vertex::GenerateAttributes()
         sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, uv))));
 
     return vao;
-}
\ No newline at end of file
+}
+
+GLuint Vertex::GetSharedVertexArray()
+{
+    if (sharedVertexArray != 0)
+        return sharedVertexArray;
+
+    GLuint vao = 0;
+    GLCall(glCreateVertexArrays(1, &vao));
+
+    // Model position attribute
+    GLCall(glEnableVertexArrayAttrib(vao, 0));
+    GLCall(glVertexArrayAttribFormat(vao, 0, sizeof(position) / sizeof(GLfloat),
+                                     GL_FLOAT, GL_FALSE,
+                                     offsetof(Vertex, position)));
+    GLCall(glVertexArrayAttribBinding(vao, 0, 0));
+
+    // UV Coordinate Attribute
+    GLCall(glEnableVertexArrayAttrib(vao, 1));
+    GLCall(glVertexArrayAttribFormat(vao, 1, sizeof(uv) / sizeof(GLfloat),
+                                     GL_FLOAT, GL_FALSE, offsetof(Vertex, uv)));
+    GLCall(glVertexArrayAttribBinding(vao, 1, 0));
+
+    sharedVertexArray = vao;
+    return vao;
+}
+
+void Vertex::ClearSharedVertexArray(GLState &state)
+{
+    if (sharedVertexArray == 0)
+        return;
+    state.ForgetVertexArray(sharedVertexArray);
+    glDeleteVertexArrays(1, &sharedVertexArray);
+    sharedVertexArray = 0;
+}
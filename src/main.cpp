@@ -1,7 +1,31 @@
+#include "Camera.hpp"
+#include "CellGraph.hpp"
+#include "CommandBuffer.hpp"
+#include "CullingPass.hpp"
+#include "FrameConstants.hpp"
+#include "Frustum.hpp"
+#include "GLCommandBackend.hpp"
+#include "GLState.hpp"
+#include "HiZBuffer.hpp"
+#include "IndirectDrawList.hpp"
+#include "JobSystem.hpp"
+#include "ManifestIndex.hpp"
 #include "Mesh.hpp"
+#include "MeshPool.hpp"
+#include "ObjectConstants.hpp"
 #include "OpenGLExtensions.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "RenderQueue.hpp"
+#include "RenderTarget.hpp"
+#include "ShadeletCache.hpp"
 #include "Shader.hpp"
+#include "ShaderBundle.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderReloader.hpp"
 #include "ShaderSource.hpp"
+#include "ShaderVariants.hpp"
+#include "UniformBuffer.hpp"
+#include "UniformRing.hpp"
 #include "extern/stb_image.hpp"
 
 // OpenGL Start
@@ -14,16 +38,20 @@
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <iostream>
+#include <string>
 #include <vector>
 
 using namespace std::chrono;
 
+// Fewer draws than this are not worth recording on another thread
+static constexpr std::size_t MinPacketsPerBuffer = 1024;
+
 float  deltaTime  = 0.1f;
 float  mouseXDiff = 0.0f, mouseYDiff = 0.0f;
 double lastMouseX = 0.0, lastMouseY = 0.0;
@@ -41,6 +69,14 @@ float GetTime(steady_clock::time_point start)
     return GetTime(start, steady_clock::now());
 }
 
+static bool HasArgument(int argc, char *argv[], const std::string &argument)
+{
+    for (int i = 1; i < argc; i++)
+        if (argument == argv[i])
+            return true;
+    return false;
+}
+
 static void MousePosEvent(GLFWwindow *window, double xpos, double ypos)
 {
     if (firstUpdate)
@@ -67,9 +103,10 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    // Tell OpenGL to use GLSL 3.30
-    GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3));
-    GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3));
+    // Ask for OpenGL 4.5 for direct state access, the shaders themselves
+    // only need GLSL 3.30
+    GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4));
+    GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5));
     GLCall(glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE));
     GLCall(glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE));
 
@@ -77,6 +114,14 @@ int main(int argc, char *argv[])
     GLCall(GLFWwindow *window =
                glfwCreateWindow(640, 640, "Hello World", NULL, NULL));
 
+    // Fall back to OpenGL 3.3 where 4.5 is not available
+    if (!window)
+    {
+        GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3));
+        GLCall(glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3));
+        GLCall(window = glfwCreateWindow(640, 640, "Hello World", NULL, NULL));
+    }
+
     if (!window)
     {
         std::cerr << "Failed to create window" << std::endl;
@@ -106,14 +151,20 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // Every bind and enable goes through here, redundant ones are dropped
+    auto glState = GLState();
+
     // Depth buffer
-    glEnable(GL_DEPTH_TEST);
+    glState.SetDepthTest(true);
 
     // Setup viewport
-    glViewport(0, 0, bufferWidth, bufferHeight);
+    glState.SetViewport(0, 0, bufferWidth, bufferHeight);
 
     GLCall(fprintf(stdout, "Status: Using GLEW %s\n",
                    glewGetString(GLEW_VERSION)));
+    std::cout << "Editing GL objects through "
+              << (HasDirectStateAccess() ? "direct state access" : "binding")
+              << std::endl;
 
 #pragma endregion
 
@@ -124,21 +175,72 @@ int main(int argc, char *argv[])
 
 #pragma region Compile Shaders
 
-    auto shaderSources       = ShaderSource::ReadShaderSources("res/");
-    auto shaderCompileErrors = std::make_unique<std::vector<std::string>>();
-    auto shaders             = Shader::CompileShaders(
-        shaderSources, shaderCompileErrors); // Compile(shaderSources);
-
-    if (shaderCompileErrors->size() > 0)
+    // Worker threads for loading and the per-frame CPU work, this thread is
+    // one of them
+    auto jobs = JobSystem();
+
+    auto shaderLoadStart = steady_clock::now();
+    // Include files are parsed once for every program that uses them
+    auto shaderPreprocessor = ShaderPreprocessor();
+    // A bundle from shader_bundle replaces reading res/, with its variants
+    // already built, unless res/ has changed since it was made
+    auto shaderSources = std::vector<ShaderSource>();
+    bool bundled =
+        ShaderBundle::Read("shaders.bundle", "res/", shaderSources);
+    if (!bundled)
     {
-        for (auto error : *shaderCompileErrors)
-            std::cout << error << std::endl;
-        return 1;
+        // What the manifests said last run, so unchanged ones are not parsed
+        auto manifestIndex = ManifestIndex("shader_cache/manifests.idx");
+        manifestIndex.Load();
+        shaderSources = ShaderSource::ReadShaderSources(
+            "res/", &shaderPreprocessor, &jobs, &manifestIndex);
     }
-    else
-    {
+    auto shaderCompileErrors = std::make_unique<std::vector<std::string>>();
+    // Linked programs from earlier runs, so warm starts skip compiling
+    auto binaryCache = ProgramBinaryCache("shader_cache/");
+    // Stages several programs share are compiled once
+    auto shadeletCache = ShadeletCache();
+    auto shaders       = Shader::CompileShaders(
+        shaderSources, shaderCompileErrors, &binaryCache, &shadeletCache);
+
+    for (auto error : *shaderCompileErrors)
+        std::cout << error << std::endl;
+
+    const ProgramBinaryStats &binaryStats = binaryCache.GetStats();
+    std::cout << "Shaders ready in " << GetTime(shaderLoadStart) * 1000.0f
+              << " ms from " << (bundled ? "shaders.bundle" : "res/") << ", "
+              << binaryStats.loaded << " loaded from cache, "
+              << binaryStats.stored << " compiled, "
+              << shadeletCache.GetStats().reused << " shadelets shared"
+              << std::endl;
+
+    // Only the default shader is required, the others need GL 4.3
+    long defaultShader  = Shader::FindShader(*shaders, "def");
+    long indirectShader = Shader::FindShader(*shaders, "indirect");
+    long pulledShader   = Shader::FindShader(*shaders, "pulled");
+    long cullShader     = Shader::FindShader(*shaders, "cull");
+    long hiZShader      = Shader::FindShader(*shaders, "hiz");
+    if (defaultShader < 0)
+        return 1;
+    if (shaderCompileErrors->empty())
         std::cout << "All shaders compiled successfully" << std::endl;
-    }
+
+    // Keyword variants of the programs above, built when first asked for
+    auto shaderVariants =
+        ShaderVariants(shaderSources, *shaders, &binaryCache, shadeletCache);
+
+    // Programs are rebuilt while running when a file they use is written
+    auto shaderReloader =
+        ShaderReloader(glState, shaderSources, *shaders, shaderPreprocessor,
+                       &binaryCache, shadeletCache, &shaderVariants);
+    // A bundle has no files of its own to watch, it is only checked
+    // against res/ when loaded
+    if (bundled)
+        std::cout << "Shaders from shaders.bundle, changes to res/ apply "
+                     "on the next start"
+                  << std::endl;
+    else if (shaderReloader.Watch("res/"))
+        std::cout << "Watching res/ for shader changes" << std::endl;
 
 #pragma endregion
 
@@ -150,16 +252,18 @@ int main(int argc, char *argv[])
 
 #pragma region Render Data
 
-    // Projection matrix
-    // glm::mat4 projection =
-    //     glm::ortho(0.0f, (GLfloat)1, (GLfloat)1, 0.0f, 0.1f, 100.0f);
-    glm::mat4 projection = glm::perspective(
-        45.0f, (GLfloat)bufferWidth / (GLfloat)bufferHeight, 0.1f, 100.0f);
+    // The camera owns the view and projection matrices
+    auto camera = Camera(glm::radians(45.0f),
+                         (GLfloat)bufferWidth / (GLfloat)bufferHeight, 0.1f,
+                         100.0f);
+    camera.SetPosition(glm::vec3(0.0f, 0.0f, 10.0f));
+    camera.LookAt(glm::vec3(0.0f, 0.0f, 0.0f));
 
     std::vector<Mesh> meshes = std::vector<Mesh>();
 
     Mesh cubeMesh = Mesh();
-    cubeMesh.CreateMesh({Vertex(1.f, 1.f, 1.f, 0.0f, 0.0f),    // 0
+    cubeMesh.CreateMesh(glState,
+                        {Vertex(1.f, 1.f, 1.f, 0.0f, 0.0f),    // 0
                          Vertex(-1.f, 1.f, 1.f, 0.0f, 0.0f),   // 1
                          Vertex(-1.f, 1.f, -1.f, 0.0f, 0.0f),  // 2
                          Vertex(1.f, 1.f, -1.f, 0.0f, 0.0f),   // 3
@@ -172,20 +276,111 @@ int main(int argc, char *argv[])
 
     meshes.push_back(std::move(cubeMesh));
 
+    // With multi draw indirect the whole opaque pass is one draw call over
+    // every mesh's geometry in shared buffers, otherwise each draw is
+    // recorded into command buffers
+    bool useIndirect = indirectShader >= 0 && HasDirectStateAccess() &&
+                       HasMultiDrawIndirect();
+    auto meshPool    = MeshPool();
+    auto drawList    = IndirectDrawList();
+
+    // Passing --pull-vertices has the vertex shader fetch its own
+    // attributes, see MeshPool
+    bool pullVertices = useIndirect && pulledShader >= 0 &&
+                        HasArgument(argc, argv, "--pull-vertices");
+    long drawShader   = pullVertices ? pulledShader : indirectShader;
+
+    // Passing --object-color draws each object in its own color, with a
+    // variant that is built in the background while the default one draws
+    long          drawFamily = -1;
+    std::uint32_t drawMask   = 0;
+    if (useIndirect)
+        drawFamily =
+            shaderVariants.FindFamily((*shaders)[drawShader].GetName());
+    if (HasArgument(argc, argv, "--object-color"))
+        drawMask = shaderVariants.GetMask(drawFamily, {"OBJECT_COLOR"});
+    shaderVariants.Warm(drawFamily, drawMask);
+    if (useIndirect)
+    {
+        for (auto const &mesh : meshes)
+            meshPool.AddMesh(mesh.GetVertices(), mesh.GetIndices());
+        meshPool.CreatePool(glState, pullVertices);
+        drawList.CreateList(glState, MinPacketsPerBuffer);
+    }
+    std::cout << (useIndirect ? "Drawing with multi draw indirect"
+                              : "Drawing with command buffers")
+              << (pullVertices ? ", pulling vertices" : "") << std::endl;
+
+    // The indirect draws can also be culled on the GPU, against the frustum
+    // and against the depth of the previous frame. That depth has to be
+    // read back, so the scene is drawn offscreen and then blitted.
+    bool useGPUCulling = useIndirect && HasComputeShaders() &&
+                         cullShader >= 0 && hiZShader >= 0;
+    auto culling       = CullingPass();
+    auto hiZ           = HiZBuffer();
+    auto sceneTarget   = RenderTarget();
+    if (useGPUCulling)
+    {
+        culling.CreatePass(glState, MinPacketsPerBuffer);
+        hiZ.CreateHiZ(glState, bufferWidth, bufferHeight);
+        useGPUCulling =
+            sceneTarget.CreateTarget(glState, bufferWidth, bufferHeight);
+    }
+    if (useGPUCulling)
+        std::cout << "Culling draws on the GPU" << std::endl;
+    // What the Hi-Z was rendered with
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+
+    // Interior cells and the portals between them, meshes in cells that
+    // cannot be seen from the camera's cell are skipped
+    auto cellGraphs    = CellGraph::ReadCellGraphs("res/");
+    auto visibleMeshes = std::vector<std::size_t>();
+
+    // Visible draws of the frame, sorted to minimize state changes
+    auto renderQueue = RenderQueue();
+
+    // One command buffer per job system thread, replayed on this one
+    auto commandBuffers = std::vector<CommandBuffer>(jobs.GetThreadCount());
+    // Per-draw constants, uploaded once per frame and bound by range
+    auto uniformRing = UniformRing();
+    uniformRing.CreateRing(glState, 64 * 1024);
+
+    auto glBackend = GLCommandBackend(glState, *shaders, meshes, uniformRing);
+
+    // Camera and time, written once per frame and read by every program
+    auto frameConstants = FrameConstants();
+    auto frameBuffer    = UniformBuffer();
+    frameBuffer.CreateBuffer(glState, sizeof(FrameConstants));
+    frameBuffer.BindBase(FrameConstantsBinding);
+
 #pragma endregion
 
     // Model matrix (Where the object's position is defined)
     glm::mat4 model =
         glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
+    // One model matrix per mesh
+    auto models = std::vector<glm::mat4>(meshes.size(), model);
 
-    glm::mat4 view =
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-                    glm::vec3(0.0f, 1.0f, 0.0f));
-
-    glm::mat4 camPitch = glm::mat4(1.0f);
-    glm::mat4 camYaw   = glm::mat4(1.0f);
+    // World space bounds of each mesh, for those in no cell. The models do
+    // not move, so they are only computed once.
+    auto boundsMin = std::vector<glm::vec3>(meshes.size(), glm::vec3(0.0f));
+    auto boundsMax = std::vector<glm::vec3>(meshes.size(), glm::vec3(0.0f));
+    for (std::size_t i = 0; i < meshes.size(); i++)
+    {
+        auto const &vertices = meshes[i].GetVertices();
+        for (std::size_t v = 0; v < vertices.size(); v++)
+        {
+            glm::vec3 position =
+                glm::vec3(models[i] * glm::vec4(vertices[v].position[0],
+                                                vertices[v].position[1],
+                                                vertices[v].position[2], 1.0f));
+            boundsMin[i] = v == 0 ? position : glm::min(boundsMin[i], position);
+            boundsMax[i] = v == 0 ? position : glm::max(boundsMax[i], position);
+        }
+    }
 
-    auto lastTimePoint = steady_clock::now();
+    auto startTimePoint = steady_clock::now();
+    auto lastTimePoint  = startTimePoint;
 
     // Hide and lock the cursor, and prep it for motion-based detection
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -210,120 +405,276 @@ int main(int argc, char *argv[])
         lastTimePoint = now;
 
         // Render here
+        if (useGPUCulling)
+            sceneTarget.Bind();
         GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
-        //--- Binding ---//
-        shaders->at(0).SetInUse();
-
-        //--- Setup for draw ---//
-        GLint colorUniformLoc = shaders->at(0).GetUniformLocation("u_Color");
-        if (colorUniformLoc >= 0)
-        {
-            GLCall(glUniform4f(colorUniformLoc, 0.8f, 0.3f, 0.2f, 1.0f));
-        }
-
         // Rotate the model
         // model = glm::rotate(model, 0.005f, glm::vec3(1.0f, 1.0f, 1.0f));
 
-        // Update view matrix based on user input
-        // View matrix position
+        // Update the camera based on user input
         float cameraSpeed = 8.0f, cameraSensitivity = 0.005f;
 
-        // View matrix rotation
-        // camPitch *= glm::rotate(glm::mat4(1.0f), mouseYDiff *
-        // cameraSensitivity,
-        //                         glm::vec3(1.0f, 0.0f, 0.0f));
-        // camYaw *= glm::rotate(glm::mat4(1.0f), mouseXDiff *
-        // cameraSensitivity,
-        //                       glm::vec3(0.0f, 1.0f, 0.0f));
-
-        auto camPitchDiff =
-            glm::rotate(glm::mat4(1.0f), mouseYDiff * cameraSensitivity,
-                        glm::vec3(1.0f, 0.0f, 0.0f));
-        auto camYawDiff =
-            glm::rotate(glm::mat4(1.0f), mouseXDiff * cameraSensitivity,
-                        glm::vec3(0.0f, 1.0f, 0.0f));
-
-        // View matrix position
+        // Mouse look, moving the mouse right or down turns right or down
+        camera.Rotate(-mouseXDiff * cameraSensitivity,
+                      -mouseYDiff * cameraSensitivity);
+
+        // Camera movement, relative to where it is facing
         glm::vec3 moveVec = glm::vec3(0.0f, 0.0f, 0.0f);
         // Forward/Backward
         if (glfwGetKey(window, GLFW_KEY_W) == GL_TRUE)
-            moveVec.z = 1.0f;
-        else if (glfwGetKey(window, GLFW_KEY_S) == GL_TRUE)
             moveVec.z = -1.0f;
+        else if (glfwGetKey(window, GLFW_KEY_S) == GL_TRUE)
+            moveVec.z = 1.0f;
 
         // Right/Left
         if (glfwGetKey(window, GLFW_KEY_D) == GL_TRUE)
-            moveVec.x = -1.0f;
-        else if (glfwGetKey(window, GLFW_KEY_A) == GL_TRUE)
             moveVec.x = 1.0f;
+        else if (glfwGetKey(window, GLFW_KEY_A) == GL_TRUE)
+            moveVec.x = -1.0f;
 
         // Up/Down
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GL_TRUE)
-            moveVec.y = -1.0f;
-        else if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GL_TRUE)
             moveVec.y = 1.0f;
+        else if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GL_TRUE)
+            moveVec.y = -1.0f;
 
-        glm::vec3 viewScale;
-        glm::quat viewRotation;
-        glm::vec3 viewPos = glm::vec3(0.0f, 0.0f, 0.0f);
-        glm::vec3 viewSkew;
-        glm::vec4 viewPerspective;
-
-        glm::decompose(view, viewScale, viewRotation, viewPos, viewSkew,
-                       viewPerspective);
-
-        glm::mat4 viewTransform = glm::translate(glm::mat4(1.0f), -viewPos);
-        viewTransform           = viewTransform * glm::toMat4(viewRotation);
-        glm::mat4 inverseViewTransform = glm::inverse(viewTransform);
-
-        view = (viewTransform * camYawDiff * inverseViewTransform) * view;
-        view = camPitchDiff * view;
-        view =
-            glm::translate(glm::mat4(1.0f), moveVec * cameraSpeed * deltaTime) *
-            view;
-        // view = glm::translate(view, moveVec * cameraSpeed * deltaTime);
+        if (moveVec != glm::vec3(0.0f))
+            camera.MoveLocal(moveVec * cameraSpeed * deltaTime);
 
         // Reset the diffs
         mouseXDiff = mouseYDiff = 0.0f;
 
-        // Assign the object model to the uniform (Not good for more than
-        // one object)
-        GLint modelUniformLoc = shaders->at(0).GetUniformLocation("model");
-        if (modelUniformLoc >= 0)
+        // Every matrix and the frustum are derived once, here
+        camera.Update();
+
+        //--- Visibility ---//
+        const glm::vec3 &eye = camera.GetPosition();
+        bool             culled =
+            !cellGraphs.empty() &&
+            cellGraphs[0].ComputeVisibleMeshes(eye, camera.GetFrustum(),
+                                               camera.GetViewProjection(),
+                                               visibleMeshes);
+
+        if (culled)
         {
-            GLCall(glUniformMatrix4fv(modelUniformLoc, 1, GL_FALSE,
-                                      glm::value_ptr(model)));
+            // Meshes in no cell are behind no portal, only the frustum can
+            // cull them
+            for (std::size_t i = 0; i < meshes.size(); i++)
+                if (!cellGraphs[0].ContainsMesh(i) &&
+                    camera.GetFrustum().IntersectsAABB(boundsMin[i],
+                                                       boundsMax[i]))
+                    visibleMeshes.push_back(i);
         }
-        // Assign the projection matrix uniform its value
-        GLint projectionUniformLoc =
-            shaders->at(0).GetUniformLocation("projection");
-        if (projectionUniformLoc >= 0)
+        else
         {
-            GLCall(glUniformMatrix4fv(projectionUniformLoc, 1, GL_FALSE,
-                                      glm::value_ptr(projection)));
+            visibleMeshes.clear();
+            for (std::size_t i = 0; i < meshes.size(); i++)
+                visibleMeshes.push_back(i);
         }
 
-        // Assign the view matrix
-        GLint viewUniformLoc = shaders->at(0).GetUniformLocation("view");
-        if (viewUniformLoc >= 0)
+        //--- Queue the visible draws ---//
+        renderQueue.Clear();
+        for (auto i : visibleMeshes)
+        {
+            if (i >= meshes.size())
+                continue;
+            // Every mesh uses the same shader until meshes carry a
+            // material of their own
+            std::uint32_t shaderIndex =
+                std::uint32_t(useIndirect ? drawShader : defaultShader);
+            float         depth =
+                (glm::distance(eye, glm::vec3(models[i][3])) -
+                 camera.GetNearPlane()) /
+                (camera.GetFarPlane() - camera.GetNearPlane());
+            renderQueue.Push(RenderQueue::MakeKey(RenderPass::Opaque, false,
+                                                  shaderIndex, 0,
+                                                  std::uint32_t(i), depth),
+                             shaderIndex, std::uint32_t(i), std::uint32_t(i));
+        }
+        renderQueue.Sort();
+
+        //--- Recording ---//
+        auto const &packets = renderQueue.GetPackets();
+
+        // Draws are written straight into the indirect list, in parallel
+        auto writeDraws = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                const RenderPacket &packet = packets[i];
+
+                auto constants  = ObjectConstants();
+                constants.model = models[packet.objectIndex];
+                constants.color = glm::vec4(0.8f, 0.3f, 0.2f, 1.0f);
+                drawList.SetDraw(i, meshPool.GetRange(packet.meshIndex),
+                                 constants);
+                if (!useGPUCulling)
+                    continue;
+
+                // The mesh's sphere in world space, scaled by the longest
+                // axis so it still holds under non-uniform scale
+                const glm::mat4 &world  = constants.model;
+                glm::vec4        sphere = meshPool.GetBounds(packet.meshIndex);
+                glm::vec3        axes   = glm::vec3(
+                    glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+                    glm::dot(glm::vec3(world[1]), glm::vec3(world[1])),
+                    glm::dot(glm::vec3(world[2]), glm::vec3(world[2])));
+                float     scale = std::max({axes.x, axes.y, axes.z});
+                glm::vec4 center = world * glm::vec4(glm::vec3(sphere), 1.0f);
+                culling.SetBounds(i, glm::vec4(glm::vec3(center),
+                                               sphere.w * std::sqrt(scale)));
+            }
+        };
+
+        // Split the sorted draws across the command buffers, each recorded
+        // as its own job. Small frames are recorded in one go.
+        std::size_t bufferCount = std::min(
+            commandBuffers.size(), packets.size() / MinPacketsPerBuffer + 1);
+        std::size_t perBuffer =
+            (packets.size() + bufferCount - 1) / bufferCount;
+
+        auto recordRange = [&](std::size_t b) {
+            CommandBuffer &buffer = commandBuffers[b];
+            buffer.Reset();
+            std::size_t begin = std::min(packets.size(), b * perBuffer);
+            std::size_t end   = std::min(packets.size(), begin + perBuffer);
+            renderQueue.SubmitRange(
+                begin, end,
+                [&](const RenderPacket &packet, bool programChanged) {
+                    // The program only needs binding when it changes
+                    if (programChanged)
+                        buffer.BindProgram(packet.shaderIndex);
+
+                    auto constants  = ObjectConstants();
+                    constants.model = models[packet.objectIndex];
+                    constants.color = glm::vec4(0.8f, 0.3f, 0.2f, 1.0f);
+                    GLintptr offset =
+                        uniformRing.Push(&constants, sizeof(constants));
+                    if (offset == UniformRing::InvalidOffset)
+                        return; // Cannot happen, the ring was reserved
+                    buffer.BindUniformRange(ObjectConstantsBinding,
+                                            std::size_t(offset),
+                                            sizeof(constants));
+                    buffer.DrawMesh(packet.meshIndex);
+                });
+        };
+
+        if (useIndirect)
+        {
+            drawList.BeginFrame(packets.size());
+            if (useGPUCulling)
+                culling.BeginFrame(packets.size());
+            jobs.ParallelFor(packets.size(), writeDraws, MinPacketsPerBuffer);
+        }
+        else
         {
-            GLCall(
-                glUniformMatrix4fv(viewUniformLoc, 1, GL_FALSE,
-                                   glm::value_ptr(camYaw * camPitch * view)));
+            // Room for every draw's constants, so pushing never fails
+            std::size_t constantsSize =
+                uniformRing.AlignedSize(sizeof(ObjectConstants));
+            uniformRing.BeginFrame(packets.size() * constantsSize);
+
+            jobs.ParallelFor(
+                bufferCount,
+                [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t b = begin; b < end; b++)
+                        recordRange(b);
+                },
+                1);
         }
 
+        //--- Frame constants ---//
+        frameConstants.view           = camera.GetView();
+        frameConstants.projection     = camera.GetProjection();
+        frameConstants.viewProjection = camera.GetViewProjection();
+        frameConstants.cameraPosition = glm::vec4(camera.GetPosition(), 1.0f);
+        frameConstants.time           = GetTime(startTimePoint, now);
+        frameConstants.deltaTime      = deltaTime;
+        frameConstants.resolution =
+            glm::vec2(float(bufferWidth), float(bufferHeight));
+        frameBuffer.UpdateBuffer(&frameConstants, sizeof(FrameConstants));
+
         //--- Drawing ---//
-        // The actual draw call
-        for (std::size_t i = 0; i < meshes.size(); i++)
-            meshes[i].RenderMesh();
+        // Only this thread touches GL
+        shaderReloader.Update();
+        shaderVariants.Update();
+        Shader *drawProgram =
+            shaderVariants.TryGetVariant(drawFamily, drawMask);
+        if (drawProgram == nullptr && useIndirect)
+            drawProgram = &(*shaders)[drawShader];
+
+        if (useGPUCulling)
+        {
+            drawList.Flush();
+            culling.Flush();
+            culling.Cull((*shaders)[cullShader], drawList, hiZ,
+                         previousViewProjection);
+            drawProgram->SetInUse(glState);
+            culling.Draw(drawList, meshPool);
+
+            // Next frame tests against this frame's depth
+            hiZ.Build((*shaders)[hiZShader], sceneTarget.GetDepthTexture());
+            previousViewProjection = camera.GetViewProjection();
+
+            sceneTarget.BlitToScreen(bufferWidth, bufferHeight);
+            glState.BindFramebuffer(0);
+        }
+        else if (useIndirect)
+        {
+            // Every draw's commands and constants in one upload each, then
+            // a constant number of calls however many draws there are
+            drawList.Flush();
+            drawProgram->SetInUse(glState);
+            drawList.Draw(meshPool);
+        }
+        else
+        {
+            // Every draw's constants in one upload
+            uniformRing.Flush();
+
+            // The buffers are replayed in order
+            for (std::size_t b = 0; b < bufferCount; b++)
+                commandBuffers[b].Replay(glBackend);
+        }
 
         // Swap front and back buffers
         GLCall(glfwSwapBuffers(window));
     }
 
+    const GLStateStats &stateStats = glState.GetStats();
+    std::cout << "GL state changes: " << stateStats.issued << " issued, "
+              << stateStats.filtered << " filtered" << std::endl;
+    // Every program's uniform uploads, and the draw variant's if one was
+    // built
+    auto    uniformStats = UniformStats();
+    Shader *drawVariant  = shaderVariants.TryGetVariant(drawFamily, drawMask);
+    for (auto const &shader : *shaders)
+    {
+        uniformStats.uploads += shader.GetUniformStats().uploads;
+        uniformStats.skipped += shader.GetUniformStats().skipped;
+    }
+    if (drawVariant != nullptr && drawMask != 0)
+    {
+        uniformStats.uploads += drawVariant->GetUniformStats().uploads;
+        uniformStats.skipped += drawVariant->GetUniformStats().skipped;
+    }
+    std::cout << "Uniforms: " << uniformStats.uploads << " uploaded, "
+              << uniformStats.skipped << " skipped as unchanged" << std::endl;
+    // The last frame's draws, in the order they were sorted into
+    RenderQueueStats queueStats = renderQueue.GetStats();
+    std::cout << "Render queue: " << queueStats.draws << " draws, "
+              << queueStats.programChanges << " program changes, "
+              << queueStats.meshChanges << " mesh changes" << std::endl;
+
     for (std::size_t i = 0; i < meshes.size(); i++)
         meshes[i].ClearMesh();
+    frameBuffer.ClearBuffer();
+    uniformRing.ClearRing();
+    culling.ClearPass();
+    hiZ.ClearHiZ();
+    sceneTarget.ClearTarget();
+    drawList.ClearList();
+    meshPool.ClearPool();
+    Vertex::ClearSharedVertexArray(glState);
 
     GLCall(glfwTerminate());
     return 0;
@@ -0,0 +1,168 @@
+// Culls a known scene on the GPU and checks how many draws survive, once
+// against the frustum alone and once more against the Hi-Z of the first
+// pass. Exits non-zero on a mismatch. The context is made through EGL, so
+// it also runs on Mesa's llvmpipe without a display server. A machine
+// that cannot give it GL 4.5 skips it, see SkipTest.
+#include "CullingPass.hpp"
+#include "FrameConstants.hpp"
+#include "GLState.hpp"
+#include "HeadlessContext.hpp"
+#include "HiZBuffer.hpp"
+#include "IndirectDrawList.hpp"
+#include "MeshPool.hpp"
+#include "OpenGLExtensions.hpp"
+#include "RenderTarget.hpp"
+#include "Shader.hpp"
+#include "ShaderSource.hpp"
+#include "UniformBuffer.hpp"
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr GLsizei TargetSize = 256;
+// ctest's SKIP_RETURN_CODE for the test, the usual automake one
+static constexpr int SkipTest = 77;
+
+struct TestDraw
+{
+public:
+    const char *name;
+    glm::vec3   center;
+    float       size; // Of the square, which faces the camera
+};
+
+// The camera sits at the origin looking down -z, and the wall fills the
+// whole view
+static const TestDraw Draws[] = {
+    {"wall", glm::vec3(0.0f, 0.0f, -10.0f), 40.0f},
+    {"in front of the wall", glm::vec3(0.0f, 0.0f, -5.0f), 1.0f},
+    {"off screen", glm::vec3(100.0f, 0.0f, -10.0f), 1.0f},
+    {"behind the camera", glm::vec3(0.0f, 0.0f, 10.0f), 1.0f},
+    {"behind the wall", glm::vec3(2.0f, 1.0f, -30.0f), 1.0f},
+};
+static constexpr GLuint InFrustum   = 3; // All but off screen and behind
+static constexpr GLuint NotOccluded = 2; // And not behind the wall
+
+static bool Check(const char *pass, GLuint survivors, GLuint expected)
+{
+    std::cout << pass << ": " << survivors << " of " << std::size(Draws)
+              << " draws survived, expected " << expected << std::endl;
+    return survivors == expected;
+}
+
+int main()
+{
+    // Nothing is shown, everything is drawn into a RenderTarget
+    auto context = HeadlessContext();
+    if (!context.CreateContext(4, 5))
+        return SkipTest;
+    if (!HasDirectStateAccess() || !HasMultiDrawIndirect() ||
+        !HasComputeShaders())
+    {
+        std::cerr << "Multi draw indirect and compute shaders are required"
+                  << std::endl;
+        return SkipTest;
+    }
+
+    bool passed = false;
+    {
+        auto state = GLState();
+        state.SetDepthTest(true);
+        state.SetViewport(0, 0, TargetSize, TargetSize);
+
+        auto target = RenderTarget();
+        target.CreateTarget(state, TargetSize, TargetSize);
+        target.Bind();
+
+        auto sources = ShaderSource::ReadShaderSources("res/");
+        auto errors  = std::make_unique<std::vector<std::string>>();
+        auto shaders = Shader::CompileShaders(sources, errors);
+
+        long indirect = Shader::FindShader(*shaders, "indirect");
+        long cull     = Shader::FindShader(*shaders, "cull");
+        long hiZ      = Shader::FindShader(*shaders, "hiz");
+        if (indirect < 0 || cull < 0 || hiZ < 0)
+        {
+            for (auto const &error : *errors)
+                std::cerr << error << std::endl;
+            return 1;
+        }
+
+        auto frameConstants = FrameConstants();
+        frameConstants.viewProjection =
+            glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f) *
+            glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                        glm::vec3(0.0f, 1.0f, 0.0f));
+        auto frameBuffer = UniformBuffer();
+        frameBuffer.CreateBuffer(state, sizeof(FrameConstants));
+        frameBuffer.UpdateBuffer(&frameConstants, sizeof(FrameConstants));
+        frameBuffer.BindBase(FrameConstantsBinding);
+
+        // A unit square facing +z, positions only
+        auto layout           = VertexLayout();
+        layout.stride         = 3;
+        layout.positionOffset = 0;
+        auto square           = std::vector<GLfloat>{
+            -0.5f, -0.5f, 0.0f, 0.5f,  -0.5f, 0.0f,
+            0.5f,  0.5f,  0.0f, -0.5f, 0.5f,  0.0f};
+        auto pool = MeshPool();
+        pool.AddMesh(square.data(), 4, layout, {0, 1, 2, 0, 2, 3});
+        pool.CreatePool(state);
+
+        std::size_t drawCount = std::size(Draws);
+        auto        draws     = IndirectDrawList();
+        auto        culling   = CullingPass();
+        draws.CreateList(state, drawCount);
+        culling.CreatePass(state, drawCount);
+        draws.BeginFrame(drawCount);
+        culling.BeginFrame(drawCount);
+        for (std::size_t i = 0; i < drawCount; i++)
+        {
+            auto constants  = ObjectConstants();
+            constants.model = glm::scale(
+                glm::translate(glm::mat4(1.0f), Draws[i].center),
+                glm::vec3(Draws[i].size));
+            constants.color = glm::vec4(1.0f);
+            draws.SetDraw(i, pool.GetRange(0), constants);
+            // Just reaching the square's corners
+            culling.SetBounds(i, glm::vec4(Draws[i].center,
+                                           Draws[i].size * 0.71f));
+        }
+        draws.Flush();
+        culling.Flush();
+
+        // Without a Hi-Z only the frustum culls
+        auto hiZBuffer = HiZBuffer();
+        hiZBuffer.CreateHiZ(state, TargetSize, TargetSize);
+        culling.Cull((*shaders)[cull], draws, hiZBuffer,
+                     frameConstants.viewProjection);
+        passed = Check("frustum", culling.ReadDrawCount(), InFrustum);
+
+        // The survivors' depth then hides whatever is behind the wall
+        GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        (*shaders)[indirect].SetInUse(state);
+        culling.Draw(draws, pool);
+        hiZBuffer.Build((*shaders)[hiZ], target.GetDepthTexture());
+        culling.Cull((*shaders)[cull], draws, hiZBuffer,
+                     frameConstants.viewProjection);
+        passed = Check("frustum and Hi-Z", culling.ReadDrawCount(),
+                       NotOccluded) &&
+                 passed;
+
+        hiZBuffer.ClearHiZ();
+        culling.ClearPass();
+        draws.ClearList();
+        pool.ClearPool();
+        frameBuffer.ClearBuffer();
+        target.ClearTarget();
+    }
+    return passed ? 0 : 1;
+}
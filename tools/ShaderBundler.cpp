@@ -0,0 +1,337 @@
+// Builds a ShaderBundle from the shader manifests, offline:
+//     shader_bundle [shader directory] [bundle file] [--skip-validation]
+// Every program is read with its includes expanded and each of its keyword
+// variants is built. Comments, keyword branches a variant does not take,
+// '#line's and spare whitespace are stripped. Every program is then linked
+// in a headless EGL context, which needs no display, and nothing is written
+// unless they all link.
+#include "HeadlessContext.hpp"
+#include "Shader.hpp"
+#include "ShaderBundle.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderSource.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Programs with more keywords are bundled as they are, and their variants
+// built at runtime, rather than linking every one of 2^keywords here
+static constexpr std::size_t MaxBundledKeywords = 8;
+
+// Comments become a space, keeping any line breaks inside them
+static std::string StripComments(std::string_view source)
+{
+    auto        result = std::string();
+    std::size_t i      = 0;
+    result.reserve(source.size());
+    while (i < source.size())
+    {
+        if (source.compare(i, 2, "//") == 0)
+        {
+            while (i < source.size() && source[i] != '\n')
+                i++;
+            continue;
+        }
+        if (source.compare(i, 2, "/*") == 0)
+        {
+            auto end = source.find("*/", i + 2);
+            end      = end == std::string_view::npos ? source.size() : end + 2;
+            result += ' ';
+            result.append(std::size_t(std::count(source.begin() + i,
+                                                 source.begin() + end, '\n')),
+                          '\n');
+            i = end;
+            continue;
+        }
+        result += source[i++];
+    }
+    return result;
+}
+
+// The directive a line holds, such as "ifdef", and what follows it
+static bool ReadDirective(std::string_view line, std::string_view &directive,
+                          std::string_view &rest)
+{
+    auto start = line.find_first_not_of(" \t");
+    if (start == std::string_view::npos || line[start] != '#')
+        return false;
+    line        = line.substr(start + 1);
+    start       = std::min(line.find_first_not_of(" \t"), line.size());
+    auto end    = std::min(line.find_first_of(" \t", start), line.size());
+    directive   = line.substr(start, end - start);
+    auto restAt = std::min(line.find_first_not_of(" \t", end), line.size());
+    rest        = line.substr(restAt);
+    return true;
+}
+
+// Drops the branches of '#ifdef KEYWORD' and '#ifndef KEYWORD' the variant
+// does not take, along with those directives. Conditionals on anything else
+// are left for the driver.
+static std::string StripDeadCode(std::string_view                source,
+                                 std::vector<std::string> const &keywords,
+                                 std::uint32_t                   mask)
+{
+    struct Branch
+    {
+    public:
+        bool known;        // On a keyword, its directives are dropped
+        bool parentActive; // Whether the lines around it are kept
+        bool active;       // Whether the lines of this branch are kept
+        bool taken;        // Whether a branch of it was already kept
+    };
+
+    auto result   = std::string();
+    auto branches = std::vector<Branch>();
+    auto isActive = [&]() {
+        return branches.empty() || branches.back().active;
+    };
+    std::size_t start = 0;
+    while (start < source.size())
+    {
+        auto end = source.find('\n', start);
+        if (end == std::string_view::npos)
+            end = source.size();
+        auto line = source.substr(start, end - start);
+        start     = end + 1;
+
+        auto directive = std::string_view();
+        auto rest      = std::string_view();
+        bool keep      = isActive();
+        if (ReadDirective(line, directive, rest))
+        {
+            if (directive == "ifdef" || directive == "ifndef")
+            {
+                auto name = rest.substr(0, rest.find_first_of(" \t"));
+                auto keyword =
+                    std::find(keywords.begin(), keywords.end(), name);
+                auto branch         = Branch();
+                branch.parentActive = isActive();
+                branch.known        = keyword != keywords.end();
+                branch.taken        = false;
+                branch.active       = branch.parentActive;
+                if (branch.known)
+                {
+                    bool defined =
+                        (mask & (1u << (keyword - keywords.begin()))) != 0;
+                    branch.taken  = defined == (directive == "ifdef");
+                    branch.active = branch.parentActive && branch.taken;
+                    keep          = false;
+                }
+                branches.push_back(branch);
+            }
+            else if (directive == "if")
+                branches.push_back(Branch{false, keep, keep, false});
+            else if (directive == "elif" && !branches.empty() &&
+                     branches.back().known)
+            {
+                Branch &branch = branches.back();
+                keep           = false;
+                if (branch.taken)
+                    branch.active = false;
+                else
+                {
+                    // Only the keyword branch is gone, the rest of the
+                    // chain still needs the driver
+                    branch.known  = false;
+                    branch.active = branch.parentActive;
+                    if (branch.parentActive)
+                        result += "#if " + std::string(rest) + "\n";
+                }
+            }
+            else if (directive == "else" && !branches.empty() &&
+                     branches.back().known)
+            {
+                Branch &branch = branches.back();
+                branch.active  = branch.parentActive && !branch.taken;
+                branch.taken   = true;
+                keep           = false;
+            }
+            else if (directive == "endif" && !branches.empty())
+            {
+                keep = branches.back().parentActive && !branches.back().known;
+                branches.pop_back();
+            }
+            else if ((directive == "elif" || directive == "else") &&
+                     !branches.empty())
+                keep = branches.back().parentActive;
+        }
+        if (keep)
+        {
+            result += line;
+            result += '\n';
+        }
+    }
+    return result;
+}
+
+static bool IsWordChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+static bool IsOperatorChar(char c)
+{
+    return std::string_view("+-*/%<>=!&|^~").find(c) != std::string_view::npos;
+}
+
+// One statement or directive per line, without '#line's, blank lines or
+// any whitespace the compiler does not need. Directives keep one space
+// between words, '#define F (x)' and '#define F(x)' differ.
+static std::string Minify(std::string_view source)
+{
+    auto        result = std::string();
+    std::size_t start  = 0;
+    while (start < source.size())
+    {
+        auto end = source.find('\n', start);
+        if (end == std::string_view::npos)
+            end = source.size();
+        auto line = source.substr(start, end - start);
+        start     = end + 1;
+
+        auto directive = std::string_view();
+        auto rest      = std::string_view();
+        bool isDirective = ReadDirective(line, directive, rest);
+        if (isDirective && directive == "line")
+            continue;
+
+        auto minified = std::string();
+        bool spaced   = false;
+        for (char c : line)
+        {
+            if (c == ' ' || c == '\t' || c == '\r')
+            {
+                spaced = !minified.empty();
+                continue;
+            }
+            if (spaced)
+            {
+                char last = minified.back();
+                if (isDirective || (IsWordChar(last) && IsWordChar(c)) ||
+                    (IsOperatorChar(last) && IsOperatorChar(c)))
+                    minified += ' ';
+                spaced = false;
+            }
+            minified += c;
+        }
+        if (minified.empty())
+            continue;
+        result += minified;
+        result += '\n';
+    }
+    return result;
+}
+
+static ShaderSource Strip(const ShaderSource &variant,
+                          std::vector<std::string> const &keywords,
+                          std::uint32_t mask)
+{
+    auto stripped = std::vector<ShadeletSource>();
+    for (auto const &shadelet : variant.GetShadelets())
+        stripped.push_back(shadelet.WithSource(Minify(StripDeadCode(
+            StripComments(shadelet.GetSource()), keywords, mask))));
+    return variant.WithShadelets(std::move(stripped));
+}
+
+// Links every program, reporting each that fails
+static bool Validate(const std::vector<ShaderSource> &sources)
+{
+    auto context = HeadlessContext();
+    if (!context.CreateContext(4, 5))
+    {
+        std::cerr << "Cannot validate shaders, use --skip-validation"
+                  << std::endl;
+        return false;
+    }
+
+    std::size_t linked = 0;
+    {
+        auto errors  = std::make_unique<std::vector<std::string>>();
+        auto shaders = Shader::CompileShaders(sources, errors);
+        for (auto const &error : *errors)
+            std::cerr << error << std::endl;
+        linked = shaders->size();
+    }
+    std::cout << linked << " of " << sources.size() << " programs linked"
+              << std::endl;
+    return linked == sources.size();
+}
+
+int main(int argc, char *argv[])
+{
+    auto arguments = std::vector<std::string>();
+    bool validate  = true;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--skip-validation")
+            validate = false;
+        else
+            arguments.push_back(argv[i]);
+    }
+    auto directory  = arguments.size() > 0 ? arguments[0] : "res/";
+    auto bundlePath = arguments.size() > 1 ? arguments[1] : "shaders.bundle";
+
+    auto preprocessor = ShaderPreprocessor();
+    auto sources = ShaderSource::ReadShaderSources(directory, &preprocessor);
+    if (sources.empty())
+        return 1;
+
+    auto        bundled     = std::vector<ShaderSource>();
+    auto        linkable    = std::vector<ShaderSource>(); // Every variant
+    std::size_t sourceBytes = 0;
+    std::size_t keptBytes   = 0;
+    for (auto const &source : sources)
+    {
+        auto const &keywords = source.GetKeywords();
+        if (keywords.size() > MaxBundledKeywords)
+        {
+            std::cout << "'" << source.GetName() << "' has more than "
+                      << MaxBundledKeywords
+                      << " keywords, its variants are left to the runtime"
+                      << std::endl;
+            bundled.push_back(source);
+            linkable.push_back(source);
+            continue;
+        }
+
+        auto program = Strip(source, keywords, 0);
+        std::uint32_t variantCount = 1u << keywords.size();
+        for (std::uint32_t mask = 0; mask < variantCount; mask++)
+        {
+            auto variant = source.WithKeywords(mask);
+            auto stripped =
+                mask == 0 ? program : Strip(variant, keywords, mask);
+            for (auto const &shadelet : variant.GetShadelets())
+                sourceBytes += shadelet.GetSource().size();
+            for (auto const &shadelet : stripped.GetShadelets())
+                keptBytes += shadelet.GetSource().size();
+            if (mask != 0)
+                program.AddVariant(mask, stripped.GetShadelets());
+            linkable.push_back(std::move(stripped));
+        }
+        bundled.push_back(std::move(program));
+    }
+    std::cout << linkable.size() << " programs with their variants, "
+              << sourceBytes / 1024 << " KiB of source stripped to "
+              << keptBytes / 1024 << " KiB" << std::endl;
+
+    if (validate && !Validate(linkable))
+    {
+        std::cerr << "Not writing '" << bundlePath << "'" << std::endl;
+        return 1;
+    }
+    if (!ShaderBundle::Write(bundlePath, directory, bundled))
+        return 1;
+    std::error_code error;
+    std::cout << "Wrote '" << bundlePath << "', "
+              << std::filesystem::file_size(bundlePath, error) / 1024
+              << " KiB" << std::endl;
+    return 0;
+}